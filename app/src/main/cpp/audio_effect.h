@@ -29,6 +29,29 @@ typedef struct audio_buffer_s {
     };
 } audio_buffer_t;
 
+typedef int32_t (*buffer_function_t)(void *cookie, audio_buffer_t *buffer);
+
+typedef struct buffer_provider_s {
+    buffer_function_t getBuffer;
+    buffer_function_t releaseBuffer;
+    void             *cookie;
+} buffer_provider_t;
+
+typedef struct buffer_config_s {
+    audio_buffer_t    buffer;
+    uint32_t          samplingRate;
+    uint32_t          channels;
+    buffer_provider_t bufferProvider;
+    uint8_t           format;
+    uint8_t           accessMode;
+    uint16_t          mask;
+} buffer_config_t;
+
+typedef struct effect_config_s {
+    buffer_config_t inputCfg;
+    buffer_config_t outputCfg;
+} effect_config_t;
+
 typedef struct effect_interface_s {
     int32_t (*process)(struct effect_interface_s **self, audio_buffer_t *inBuffer, audio_buffer_t *outBuffer);
     int32_t (*command)(struct effect_interface_s **self, uint32_t cmdCode, uint32_t cmdSize,
@@ -81,6 +104,50 @@ enum {
     EFFECT_CMD_GET_PARAM            = 9,
 };
 
+// buffer_config_t.mask
+#define EFFECT_CONFIG_BUFFER    0x0001
+#define EFFECT_CONFIG_SMP_RATE  0x0002
+#define EFFECT_CONFIG_CHANNELS  0x0004
+#define EFFECT_CONFIG_FORMAT    0x0008
+#define EFFECT_CONFIG_ACC_MODE  0x0010
+#define EFFECT_CONFIG_PROVIDER  0x0020
+#define EFFECT_CONFIG_ALL       0x003F
+
+// buffer_config_t.accessMode
+enum {
+    EFFECT_BUFFER_ACCESS_WRITE      = 0,
+    EFFECT_BUFFER_ACCESS_READ       = 1,
+    EFFECT_BUFFER_ACCESS_ACCUMULATE = 2,
+};
+
+// buffer_config_t.format (audio_format_t values, PCM subset)
+enum {
+    AUDIO_FORMAT_PCM_16_BIT        = 0x1,
+    AUDIO_FORMAT_PCM_32_BIT        = 0x3,
+    AUDIO_FORMAT_PCM_8_24_BIT      = 0x4,
+    AUDIO_FORMAT_PCM_FLOAT         = 0x5,
+    AUDIO_FORMAT_PCM_24_BIT_PACKED = 0x6,
+};
+
+// buffer_config_t.channels (audio_channel_mask_t values)
+#define AUDIO_CHANNEL_OUT_FRONT_LEFT    0x1u
+#define AUDIO_CHANNEL_OUT_FRONT_RIGHT   0x2u
+#define AUDIO_CHANNEL_OUT_FRONT_CENTER  0x4u
+#define AUDIO_CHANNEL_OUT_LOW_FREQUENCY 0x8u
+#define AUDIO_CHANNEL_OUT_BACK_LEFT     0x10u
+#define AUDIO_CHANNEL_OUT_BACK_RIGHT    0x20u
+#define AUDIO_CHANNEL_OUT_SIDE_LEFT     0x200u
+#define AUDIO_CHANNEL_OUT_SIDE_RIGHT    0x400u
+#define AUDIO_CHANNEL_OUT_STEREO        (AUDIO_CHANNEL_OUT_FRONT_LEFT | AUDIO_CHANNEL_OUT_FRONT_RIGHT)
+#define AUDIO_CHANNEL_OUT_5POINT1       (AUDIO_CHANNEL_OUT_STEREO | AUDIO_CHANNEL_OUT_FRONT_CENTER | \
+                                         AUDIO_CHANNEL_OUT_LOW_FREQUENCY | AUDIO_CHANNEL_OUT_BACK_LEFT | \
+                                         AUDIO_CHANNEL_OUT_BACK_RIGHT)
+#define AUDIO_CHANNEL_OUT_5POINT1_SIDE  (AUDIO_CHANNEL_OUT_STEREO | AUDIO_CHANNEL_OUT_FRONT_CENTER | \
+                                         AUDIO_CHANNEL_OUT_LOW_FREQUENCY | AUDIO_CHANNEL_OUT_SIDE_LEFT | \
+                                         AUDIO_CHANNEL_OUT_SIDE_RIGHT)
+#define AUDIO_CHANNEL_OUT_7POINT1       (AUDIO_CHANNEL_OUT_5POINT1 | AUDIO_CHANNEL_OUT_SIDE_LEFT | \
+                                         AUDIO_CHANNEL_OUT_SIDE_RIGHT)
+
 #define EINVAL 22
 #define ENOMEM 12
 
@@ -19,6 +19,31 @@ void AudioProcessor::reset() {
     // Base implementation - derived classes should override
 }
 
+int AudioProcessor::getTailSamples() const {
+    // Stateless or IIR-only processors have no delay-line memory
+    return 0;
+}
+
+int AudioProcessor::getLatencySamples() const {
+    return 0;
+}
+
+bool AudioProcessor::allocateState() {
+    // Nothing beyond the processor object itself
+    return true;
+}
+
+void AudioProcessor::releaseState() {
+}
+
+size_t AudioProcessor::getStateBytes() const {
+    return 0;
+}
+
+void AudioProcessor::snapParameters() {
+    // No smoothed parameters
+}
+
 float AudioProcessor::clamp(float value, float min, float max) {
     return std::clamp(value, min, max);
 }
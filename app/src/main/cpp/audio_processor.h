@@ -1,17 +1,108 @@
 #ifndef AUDIO_PROCESSOR_H
 #define AUDIO_PROCESSOR_H
 
+#include <cstddef>
+
+// A gain or coefficient that glides linearly to a new target instead of
+// jumping, so parameter automation does not zipper. The ramp is evaluated
+// per block: read value(), then advance() returns the per-sample increment
+// that takes it to where it will be at the end of the block. Inner loops are
+// a plain add per sample, and once the target is reached the increment is
+// exactly zero so callers can branch to their constant-value path.
+class SmoothedParam {
+public:
+    // Ramp length used by every processor and by the dry/wet mix.
+    static constexpr float RAMP_MS = 20.0f;
+    static int rampFrames(int sampleRate) { return (int)(RAMP_MS * sampleRate / 1000.0f); }
+
+    explicit SmoothedParam(float value = 0.0f) : m_value(value), m_target(value), m_remaining(0) {}
+
+    void setTarget(float target, int rampFrames) {
+        if (target == m_target) return;
+        m_target = target;
+        m_remaining = rampFrames;
+        if (m_remaining <= 0) snap();
+    }
+
+    // Like setTarget(), but restarts the ramp from the current value even
+    // if the target is unchanged, for values that must move in step.
+    void restart(float target, int rampFrames) {
+        m_target = target;
+        m_remaining = rampFrames;
+        if (m_remaining <= 0) snap();
+    }
+
+    // Jumps to the target, for moments with no audible output to protect.
+    void snap() {
+        m_value = m_target;
+        m_remaining = 0;
+    }
+
+    bool isSteady() const { return m_remaining == 0; }
+    float value() const { return m_value; }
+    float target() const { return m_target; }
+
+    float advance(int frames) {
+        if (m_remaining == 0 || frames <= 0) return 0.0f;
+        float next = m_target;
+        if (frames < m_remaining) {
+            next = m_value + (m_target - m_value) * ((float)frames / (float)m_remaining);
+            m_remaining -= frames;
+        } else {
+            m_remaining = 0;
+        }
+        float step = (next - m_value) / (float)frames;
+        m_value = next;
+        return step;
+    }
+
+private:
+    float m_value;
+    float m_target;
+    int m_remaining;
+};
+
 class AudioProcessor {
 public:
     AudioProcessor();
     virtual ~AudioProcessor();
     
-    // Core processing interface
+    // Core processing interface; output may alias input (in-place)
     virtual void process(const float* input, float* output, int frames) = 0;
     
     // Configuration
     virtual void setSampleRate(int sampleRate);
     virtual void reset();
+
+    // Longest delay-line memory in samples, i.e. how long the output can keep
+    // changing after the input goes silent. Feedback decay is not included;
+    // callers confirm that by watching the output level.
+    virtual int getTailSamples() const;
+
+    // Samples by which the output lags the input at unity-delay frequencies
+    // (block-based convolution), so the chain can delay its dry path to
+    // match. Zero for sample-by-sample processors.
+    virtual int getLatencySamples() const;
+
+    // Large delay-line memory is allocated on demand rather than with the
+    // processor, so instances that never play stay small. Until
+    // allocateState() succeeds, process() passes audio through unchanged;
+    // releaseState() frees the memory again and loses its contents like
+    // reset(). Both may allocate or free, so the caller decides when that is
+    // acceptable.
+    virtual bool allocateState();
+    virtual void releaseState();
+    virtual size_t getStateBytes() const;   // currently allocated
+
+    // Memory for allocateState() to use instead of the heap, at least the
+    // processor's STATE_BYTES and suitably aligned. The owner keeps it alive
+    // and decides what happens to its pages after releaseState().
+    void setStateStorage(float* storage) { m_providedState = storage; }
+
+    // Jumps every smoothed parameter to its target. The chain calls it when
+    // nothing audible is playing (before the first block, while idle);
+    // setSampleRate() and reset() do it too.
+    virtual void snapParameters();
     
     // Parameter control
     virtual void setParameter(int param, float value) = 0;
@@ -20,9 +111,10 @@ public:
 protected:
     int m_sampleRate;
     bool m_initialized;
+    float* m_providedState = nullptr;
     
     // Utility functions
-    float clamp(float value, float min, float max);
+    static float clamp(float value, float min, float max);
     float linearToDb(float linear);
     float dbToLinear(float db);
     float frequencyToRadians(float frequency);
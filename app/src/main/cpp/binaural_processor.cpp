@@ -1,6 +1,8 @@
 #include "binaural_processor.h"
-#include <cstring>
 #include <cmath>
+#include <new>
+
+const size_t BinauralProcessor::STATE_BYTES = HrtfRenderer::STATE_BYTES;
 
 // GUARANTEED FIX: Reordered initializers to match declaration order in .h file.
 BinauralProcessor::BinauralProcessor()
@@ -12,10 +14,13 @@ BinauralProcessor::BinauralProcessor()
         , m_airAbsorption(0.1f)
         , m_itdSamples(0) {
 
+    m_decorrelationLine[0].setStorage(m_decorrelationBuffer[0]);
+    m_decorrelationLine[1].setStorage(m_decorrelationBuffer[1]);
     clearDelayBuffer();
     updateHRTFCoeffs();
-    updateDistanceSimulation();
+    setCoeffs(designCoeffs(m_distance, m_spatialWidth));
     setupSpatialProcessing();
+    snapParameters();
 }
 
 BinauralProcessor::~BinauralProcessor() {
@@ -39,84 +44,114 @@ void BinauralProcessor::process(const float* leftIn, const float* rightIn,
         return;
     }
 
+    m_hrtf.update();
+
+    // Both steps are exactly zero unless a parameter is ramping
+    float width = m_widthRamp.value();
+    float distanceGain = m_distanceGainRamp.value();
+    const float widthStep = m_widthRamp.advance(frames);
+    const float distanceGainStep = m_distanceGainRamp.advance(frames);
+
+    if (m_hrtf.isActive()) {
+        // The convolution runs on whole blocks, so the per-sample steps
+        // around it split into a pass before and one after
+        float w = width;
+        for (int i = 0; i < frames; i++) {
+            applyWidthAndDecorrelation(leftIn[i], rightIn[i], leftOut[i], rightOut[i], w);
+            w += widthStep;
+        }
+        m_hrtf.process(leftOut, rightOut, leftOut, rightOut, frames);
+        for (int i = 0; i < frames; i++) {
+            float leftSignal = leftOut[i];
+            float rightSignal = rightOut[i];
+            applyDistanceSimulation(leftSignal, rightSignal, leftSignal, rightSignal, distanceGain);
+            applySoundstageWidening(leftSignal, rightSignal, leftSignal, rightSignal, width);
+            leftOut[i] = leftSignal;
+            rightOut[i] = rightSignal;
+            width += widthStep;
+            distanceGain += distanceGainStep;
+        }
+        return;
+    }
+
     for (int i = 0; i < frames; i++) {
-        float leftSignal = leftIn[i];
-        float rightSignal = rightIn[i];
-
-        // 1. Stereo width expansion: 170%
-        float widthFactor = m_spatialWidth;
-        float mid = (leftSignal + rightSignal) * 0.5f;
-        float side = (leftSignal - rightSignal) * 0.5f;
-
-        // Mid/Side processing: Mid -5dB, Side +3dB
-        float midGain = 0.56f;
-        float sideGain = 1.41f;
-
-        mid *= midGain;
-        side *= sideGain * widthFactor;
-
-        leftSignal = mid + side;
-        rightSignal = mid - side;
-
-        // 2. Decorrelation: 18% on high frequencies
-        float decorrelationAmount = 0.18f;
-        int delayReadLeft = (m_delayIndex[0] - m_decorrelationDelay + MAX_ITD_SAMPLES) % MAX_ITD_SAMPLES;
-        int delayReadRight = (m_delayIndex[1] - m_decorrelationDelay + MAX_ITD_SAMPLES) % MAX_ITD_SAMPLES;
-        float decorrelatedLeft = m_decorrelationBuffer[0][delayReadLeft];
-        float decorrelatedRight = m_decorrelationBuffer[1][delayReadRight];
-        float highFreqMix = decorrelationAmount;
-        leftSignal = leftSignal * (1.0f - highFreqMix) + decorrelatedRight * highFreqMix;
-        rightSignal = rightSignal * (1.0f - highFreqMix) + decorrelatedLeft * highFreqMix;
+        float leftSignal;
+        float rightSignal;
+
+        // 1-2. Stereo width expansion and decorrelation
+        applyWidthAndDecorrelation(leftIn[i], rightIn[i], leftSignal, rightSignal, width);
 
         // 3. HRTF processing for rear positioning
         processHRTF(leftSignal, rightSignal, leftSignal, rightSignal);
 
         // 4. Distance simulation with air absorption
-        applyDistanceSimulation(leftSignal, rightSignal, leftSignal, rightSignal);
+        applyDistanceSimulation(leftSignal, rightSignal, leftSignal, rightSignal, distanceGain);
 
         // 5. Soundstage widening algorithms
-        applySoundstageWidening(leftSignal, rightSignal, leftSignal, rightSignal);
-
-        // Store in decorrelation buffer
-        m_decorrelationBuffer[0][m_delayIndex[0]] = leftIn[i];
-        m_decorrelationBuffer[1][m_delayIndex[1]] = rightIn[i];
-
-        // Update delay indices
-        m_delayIndex[0] = (m_delayIndex[0] + 1) % MAX_ITD_SAMPLES;
-        m_delayIndex[1] = (m_delayIndex[1] + 1) % MAX_ITD_SAMPLES;
+        applySoundstageWidening(leftSignal, rightSignal, leftSignal, rightSignal, width);
 
         leftOut[i] = leftSignal;
         rightOut[i] = rightSignal;
+
+        width += widthStep;
+        distanceGain += distanceGainStep;
     }
 }
 
+// Also feeds the decorrelation lines, so call it exactly once per sample.
+// The outputs may alias the inputs.
+void BinauralProcessor::applyWidthAndDecorrelation(float leftIn, float rightIn, float& leftOut, float& rightOut,
+                                                   float width) {
+    // 1. Stereo width expansion: 170%
+    float widthFactor = width;
+    float mid = (leftIn + rightIn) * 0.5f;
+    float side = (leftIn - rightIn) * 0.5f;
+
+    // Mid/Side processing: Mid -5dB, Side +3dB
+    float midGain = 0.56f;
+    float sideGain = 1.41f;
+
+    mid *= midGain;
+    side *= sideGain * widthFactor;
+
+    float leftSignal = mid + side;
+    float rightSignal = mid - side;
+
+    // 2. Decorrelation: 18% on high frequencies
+    float decorrelationAmount = 0.18f;
+    float decorrelatedLeft = m_decorrelationLine[0].tapAllpass(m_decorrelationDelay, m_decorrelationTap[0]);
+    float decorrelatedRight = m_decorrelationLine[1].tapAllpass(m_decorrelationDelay, m_decorrelationTap[1]);
+    float highFreqMix = decorrelationAmount;
+    m_decorrelationLine[0].write(leftIn);
+    m_decorrelationLine[1].write(rightIn);
+    leftOut = leftSignal * (1.0f - highFreqMix) + decorrelatedRight * highFreqMix;
+    rightOut = rightSignal * (1.0f - highFreqMix) + decorrelatedLeft * highFreqMix;
+}
+
 void BinauralProcessor::processHRTF(float leftIn, float rightIn, float& leftOut, float& rightOut) {
-    float azimuthRad = m_azimuth * M_PI / 180.0f;
-    float elevationRad = m_elevation * M_PI / 180.0f;
     float leftGain = m_hrtfCoeffs.leftGain;
     float rightGain = m_hrtfCoeffs.rightGain;
-    float elevationFilter = 0.85f + 0.15f * cosf(elevationRad);
+    float elevationFilter = m_hrtfCoeffs.elevationFilter;
     leftOut = leftIn * leftGain * elevationFilter;
     rightOut = rightIn * rightGain * elevationFilter;
-    float phaseShift = sinf(azimuthRad) * 0.1f;
+    float phaseShift = m_hrtfCoeffs.phaseShift;
     leftOut *= (1.0f + phaseShift);
     rightOut *= (1.0f - phaseShift);
 }
 
-void BinauralProcessor::applyDistanceSimulation(float leftIn, float rightIn, float& leftOut, float& rightOut) {
-    float distanceGain = m_distanceAtten;
-    float airAbsorb = 1.0f - m_airAbsorption * m_distance;
-    float totalGain = distanceGain * airAbsorb;
-    leftOut = leftIn * totalGain;
-    rightOut = rightIn * totalGain;
+void BinauralProcessor::applyDistanceSimulation(float leftIn, float rightIn, float& leftOut, float& rightOut,
+                                                float distanceGain) {
+    leftOut = leftIn * distanceGain;
+    rightOut = rightIn * distanceGain;
 }
 
-void BinauralProcessor::applySoundstageWidening(float leftIn, float rightIn, float& leftOut, float& rightOut) {
-    float enhancement = (m_spatialWidth - 1.0f) * 0.3f;
+void BinauralProcessor::applySoundstageWidening(float leftIn, float rightIn, float& leftOut, float& rightOut,
+                                                float width) {
+    float enhancement = (width - 1.0f) * 0.3f;
     float crossMix = enhancement * 0.1f;
     leftOut = leftIn * (1.0f + enhancement) + rightIn * crossMix;
     rightOut = rightIn * (1.0f + enhancement) + leftIn * crossMix;
-    float spatialGain = 1.0f + (m_spatialWidth - 1.0f) * 0.2f;
+    float spatialGain = 1.0f + (width - 1.0f) * 0.2f;
     leftOut *= spatialGain;
     rightOut *= spatialGain;
 }
@@ -125,10 +160,64 @@ void BinauralProcessor::setSampleRate(int sampleRate) {
     AudioProcessor::setSampleRate(sampleRate);
     updateHRTFCoeffs();
     setupSpatialProcessing();
+    snapParameters();
 }
 
 void BinauralProcessor::reset() {
     clearDelayBuffer();
+    m_hrtf.clear();
+    snapParameters();
+}
+
+void BinauralProcessor::snapParameters() {
+    m_widthRamp.snap();
+    m_distanceGainRamp.snap();
+}
+
+int BinauralProcessor::getTailSamples() const {
+    return MAX_ITD_SAMPLES + m_hrtf.tailSamples();
+}
+
+int BinauralProcessor::getLatencySamples() const {
+    return m_hrtf.latency();
+}
+
+bool BinauralProcessor::allocateState() {
+    if (m_stateAllocated) return true;
+    float* storage = m_providedState;
+    if (!storage) {
+        m_hrtfStorage.reset(new(std::nothrow) float[STATE_BYTES / sizeof(float)]);
+        if (!m_hrtfStorage) return false;
+        storage = m_hrtfStorage.get();
+    }
+    m_hrtf.setStorage(storage);
+    m_stateAllocated = true;
+    return true;
+}
+
+void BinauralProcessor::releaseState() {
+    m_hrtf.setStorage(nullptr);
+    m_hrtfStorage.reset();
+    m_stateAllocated = false;
+}
+
+size_t BinauralProcessor::getStateBytes() const {
+    return m_stateAllocated ? STATE_BYTES : 0;
+}
+
+void BinauralProcessor::designHrtf(const std::shared_ptr<const HrirDatabase>& hrirs, float azimuth,
+                                   float elevation) {
+    if (m_hrtfGrid && (m_hrtfGrid->source() != hrirs.get() || m_hrtfGrid->sampleRate() != m_sampleRate)) {
+        m_hrtfGrid.reset();
+        m_hrtfPairs.clear();
+    }
+    if (hrirs && !m_hrtfGrid) m_hrtfGrid = HrtfGrid::acquire(hrirs, m_sampleRate);
+    if (!m_hrtfGrid) {
+        postHrtf(std::make_unique<HrtfRenderer::Design>());
+        return;
+    }
+    postHrtf(HrtfRenderer::design(*m_hrtfGrid, m_hrtfPairs, clamp(azimuth, -180.0f, 180.0f),
+                                  clamp(elevation, -90.0f, 90.0f)));
 }
 
 void BinauralProcessor::setParameter(int param, float value) {
@@ -151,8 +240,7 @@ float BinauralProcessor::getParameter(int param) const {
 }
 
 void BinauralProcessor::setDistance(float distance) {
-    m_distance = clamp(distance, 0.0f, 1.0f);
-    updateDistanceSimulation();
+    setCoeffs(designCoeffs(distance, m_spatialWidth));
 }
 
 void BinauralProcessor::setAzimuth(float azimuth) {
@@ -166,7 +254,7 @@ void BinauralProcessor::setElevation(float elevation) {
 }
 
 void BinauralProcessor::setSpatialWidth(float width) {
-    m_spatialWidth = clamp(width, 0.5f, 3.0f);
+    setCoeffs(designCoeffs(m_distance, width));
 }
 
 void BinauralProcessor::updateHRTFCoeffs() {
@@ -185,21 +273,37 @@ void BinauralProcessor::updateHRTFCoeffs() {
     float elevationGain = 0.8f + 0.2f * cosf(abs(elevationRad));
     m_hrtfCoeffs.leftGain = leftGain * elevationGain;
     m_hrtfCoeffs.rightGain = rightGain * elevationGain;
+    // Per-sample terms of processHRTF(), kept off the audio thread
+    m_hrtfCoeffs.elevationFilter = 0.85f + 0.15f * cosf(elevationRad);
+    m_hrtfCoeffs.phaseShift = sinf(azimuthRad) * 0.1f;
+}
+
+BinauralProcessor::Coeffs BinauralProcessor::designCoeffs(float distance, float spatialWidth) {
+    Coeffs coeffs;
+    coeffs.distance = clamp(distance, 0.0f, 1.0f);
+    coeffs.spatialWidth = clamp(spatialWidth, 0.5f, 3.0f);
+    coeffs.distanceAtten = 1.0f / (1.0f + coeffs.distance * 1.8f);
+    coeffs.airAbsorption = 0.08f + coeffs.distance * 0.18f;
+    return coeffs;
 }
 
-void BinauralProcessor::updateDistanceSimulation() {
-    m_distanceAtten = 1.0f / (1.0f + m_distance * 1.8f);
-    m_airAbsorption = 0.08f + m_distance * 0.18f;
+void BinauralProcessor::setCoeffs(const Coeffs& coeffs) {
+    m_distance = coeffs.distance;
+    m_spatialWidth = coeffs.spatialWidth;
+    m_distanceAtten = coeffs.distanceAtten;
+    m_airAbsorption = coeffs.airAbsorption;
+    const int rampFrames = SmoothedParam::rampFrames(m_sampleRate);
+    m_widthRamp.setTarget(m_spatialWidth, rampFrames);
+    m_distanceGainRamp.setTarget(m_distanceAtten * (1.0f - m_airAbsorption * m_distance), rampFrames);
 }
 
 void BinauralProcessor::setupSpatialProcessing() {
-    m_decorrelationDelay = (int)(3.0f * m_sampleRate / 1000.0f);
-    m_decorrelationDelay = clamp(m_decorrelationDelay, 1, MAX_ITD_SAMPLES - 1);
+    // 3 ms at any rate below the line's 42 kHz limit, whole samples or not
+    m_decorrelationDelay = clamp(3.0f * m_sampleRate / 1000.0f, 1.5f, MAX_ITD_SAMPLES - 1);
 }
 
 void BinauralProcessor::clearDelayBuffer() {
-    memset(m_delayBuffer, 0, sizeof(m_delayBuffer));
-    memset(m_decorrelationBuffer, 0, sizeof(m_decorrelationBuffer));
-    m_delayIndex[0] = 0;
-    m_delayIndex[1] = 0;
+    m_decorrelationLine[0].clear();
+    m_decorrelationLine[1].clear();
+    m_decorrelationTap[0] = m_decorrelationTap[1] = {};
 }
\ No newline at end of file
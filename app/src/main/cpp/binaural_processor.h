@@ -2,6 +2,9 @@
 #define BINAURAL_PROCESSOR_H
 
 #include "audio_processor.h"
+#include "delay_line.h"
+#include "hrtf_renderer.h"
+#include <memory>
 
 class BinauralProcessor : public AudioProcessor {
 public:
@@ -10,12 +13,20 @@ public:
 
     // Core processing
     void process(const float* input, float* output, int frames) override;
+    // leftOut/rightOut may alias leftIn/rightIn for in-place processing
     void process(const float* leftIn, const float* rightIn,
             float* leftOut, float* rightOut, int frames);
 
     // Configuration
     void setSampleRate(int sampleRate) override;
     void reset() override;
+    int getTailSamples() const override;
+    int getLatencySamples() const override;
+    bool allocateState() override;
+    void releaseState() override;
+    size_t getStateBytes() const override;
+    static const size_t STATE_BYTES;        // HRTF convolvers
+    void snapParameters() override;
 
     // Parameter control
     void setParameter(int param, float value) override;
@@ -27,6 +38,31 @@ public:
     void setElevation(float elevation);
     void setSpatialWidth(float width);
 
+    // Distance and width with the attenuation they derive; see
+    // EQProcessor::Coeffs.
+    struct Coeffs {
+        float distance;
+        float spatialWidth;
+        float distanceAtten;
+        float airAbsorption;
+    };
+    static Coeffs designCoeffs(float distance, float spatialWidth);
+    void setCoeffs(const Coeffs& coeffs);
+
+    // Command thread: switches the HRTF stage from the gain approximation
+    // to convolution with measured (or modelled) head responses from hrirs
+    // for a source direction, or back with hrirs == nullptr. The change is
+    // picked up at the next block. The set is resampled onto an HrtfGrid
+    // once per set and rate; after that a direction is a cache lookup or a
+    // grid blend. See HrtfRenderer.
+    void designHrtf(const std::shared_ptr<const HrirDatabase>& hrirs, float azimuth, float elevation);
+    // Command thread: memory behind the HRTF directions, the grid (shared
+    // with other instances at the same rate) and this instance's pairs.
+    size_t getHrtfGridBytes() const { return m_hrtfGrid ? m_hrtfGrid->bytes() : 0; }
+    size_t getHrtfCacheBytes() const { return m_hrtfPairs.bytes(); }
+    // Command thread: queues a design made elsewhere.
+    void postHrtf(std::unique_ptr<HrtfRenderer::Design> design) { m_hrtf.post(std::move(design)); }
+
 private:
     // GUARANTEED FIX: Reordered member declarations to match initialization order and fix warning.
     // Sony Café Mode parameters
@@ -39,6 +75,10 @@ private:
     float m_distanceAtten;
     float m_airAbsorption;
 
+    // What process() actually applies, ramped towards the parameters above
+    SmoothedParam m_widthRamp;
+    SmoothedParam m_distanceGainRamp;   // m_distanceAtten * air absorption
+
     // Sony-specific HRTF coefficients
     struct HRTFCoeffs {
         float leftDelay;
@@ -47,26 +87,37 @@ private:
         float rightGain;
         float leftFilter[3];
         float rightFilter[3];
+        float elevationFilter;
+        float phaseShift;
     };
 
     HRTFCoeffs m_hrtfCoeffs;
 
-    // Delay lines for ITD simulation and decorrelation
+    // Delay lines for decorrelation, small enough to live in the processor
     static const int MAX_ITD_SAMPLES = 128;
-    float m_delayBuffer[2][MAX_ITD_SAMPLES]{};
     float m_decorrelationBuffer[2][MAX_ITD_SAMPLES]{};
-    int m_delayIndex[2]{};
+    DelayLine<MAX_ITD_SAMPLES> m_decorrelationLine[2];   // over m_decorrelationBuffer
+    DelayLine<MAX_ITD_SAMPLES>::AllpassState m_decorrelationTap[2];
     int m_itdSamples;
-    int m_decorrelationDelay;
+    float m_decorrelationDelay;
+
+    // HRTF convolution, used instead of processHRTF() while a design is
+    // installed
+    HrtfRenderer m_hrtf;
+    std::unique_ptr<float[]> m_hrtfStorage;    // allocateState() without provided storage
+    std::shared_ptr<const HrtfGrid> m_hrtfGrid;    // command thread, with m_hrtfPairs
+    HrtfPairCache m_hrtfPairs;
+    bool m_stateAllocated = false;
 
     // Sony-specific processing methods
+    void applyWidthAndDecorrelation(float leftIn, float rightIn, float& leftOut, float& rightOut, float width);
     void processHRTF(float leftIn, float rightIn, float& leftOut, float& rightOut);
-    void applyDistanceSimulation(float leftIn, float rightIn, float& leftOut, float& rightOut);
-    void applySoundstageWidening(float leftIn, float rightIn, float& leftOut, float& rightOut);
+    void applyDistanceSimulation(float leftIn, float rightIn, float& leftOut, float& rightOut,
+                                 float distanceGain);
+    void applySoundstageWidening(float leftIn, float rightIn, float& leftOut, float& rightOut, float width);
 
     // Utility functions
     void updateHRTFCoeffs();
-    void updateDistanceSimulation();
     void setupSpatialProcessing();
     void clearDelayBuffer();
 };
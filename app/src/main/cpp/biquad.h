@@ -0,0 +1,137 @@
+#ifndef BIQUAD_H
+#define BIQUAD_H
+
+#include "audio_processor.h"
+#include <cmath>
+
+// Second-order IIR section with a0 normalized to 1, designed from the RBJ
+// audio EQ cookbook. Design runs off the audio thread (or once per sample
+// rate); processing is five multiplies in transposed direct form II.
+struct Biquad {
+    float b0 = 1.0f;
+    float b1 = 0.0f;
+    float b2 = 0.0f;
+    float a1 = 0.0f;
+    float a2 = 0.0f;
+
+    struct State {
+        float z1 = 0.0f;
+        float z2 = 0.0f;
+    };
+
+    static constexpr float BUTTERWORTH_Q = 0.70710678f;
+
+    static Biquad highPass(float frequency, float q, int sampleRate) {
+        float w0 = 2.0f * (float)M_PI * frequency / (float)sampleRate;
+        float cosw = cosf(w0);
+        float alpha = sinf(w0) / (2.0f * q);
+        return normalized(0.5f * (1.0f + cosw), -(1.0f + cosw), 0.5f * (1.0f + cosw),
+                          1.0f + alpha, -2.0f * cosw, 1.0f - alpha);
+    }
+
+    static Biquad lowPass(float frequency, float q, int sampleRate) {
+        float w0 = 2.0f * (float)M_PI * frequency / (float)sampleRate;
+        float cosw = cosf(w0);
+        float alpha = sinf(w0) / (2.0f * q);
+        return normalized(0.5f * (1.0f - cosw), 1.0f - cosw, 0.5f * (1.0f - cosw),
+                          1.0f + alpha, -2.0f * cosw, 1.0f - alpha);
+    }
+
+    static Biquad peaking(float frequency, float gainDb, float q, int sampleRate) {
+        float a = powf(10.0f, gainDb / 40.0f);
+        float w0 = 2.0f * (float)M_PI * frequency / (float)sampleRate;
+        float cosw = cosf(w0);
+        float alpha = sinf(w0) / (2.0f * q);
+        return normalized(1.0f + alpha * a, -2.0f * cosw, 1.0f - alpha * a,
+                          1.0f + alpha / a, -2.0f * cosw, 1.0f - alpha / a);
+    }
+
+    float process(float input, State& state) const {
+        float output = b0 * input + state.z1;
+        state.z1 = b1 * input - a1 * output + state.z2;
+        state.z2 = b2 * input - a2 * output;
+        return output;
+    }
+
+    // Designed response at one frequency, for tests and tools.
+    float magnitudeDb(float frequency, int sampleRate) const {
+        double w = 2.0 * M_PI * frequency / sampleRate;
+        double c1 = cos(w), s1 = sin(w), c2 = cos(2.0 * w), s2 = sin(2.0 * w);
+        double numRe = b0 + b1 * c1 + b2 * c2, numIm = -(b1 * s1 + b2 * s2);
+        double denRe = 1.0 + a1 * c1 + a2 * c2, denIm = -(a1 * s1 + a2 * s2);
+        double power = (numRe * numRe + numIm * numIm) / (denRe * denRe + denIm * denIm);
+        return (float)(10.0 * log10(power));
+    }
+
+private:
+    static Biquad normalized(float b0, float b1, float b2, float a0, float a1, float a2) {
+        Biquad section;
+        section.b0 = b0 / a0;
+        section.b1 = b1 / a0;
+        section.b2 = b2 / a0;
+        section.a1 = a1 / a0;
+        section.a2 = a2 / a0;
+        return section;
+    }
+};
+
+// Moves a biquad's coefficients linearly to a new design over the usual
+// ramp, all five on the same trajectory. Every point on the way is a convex
+// combination of two stable sections, and the stability triangle of
+// (a1, a2) is convex, so the filter stays stable throughout. A new target
+// mid-ramp restarts all five from where they are, so the next trajectory
+// is again one straight line, from a point already inside the triangle.
+class BiquadRamp {
+public:
+    void setTarget(const Biquad& target, int rampFrames) {
+        if (target.b0 == m_coeff[0].target() && target.b1 == m_coeff[1].target() &&
+            target.b2 == m_coeff[2].target() && target.a1 == m_coeff[3].target() &&
+            target.a2 == m_coeff[4].target()) {
+            return;
+        }
+        m_coeff[0].restart(target.b0, rampFrames);
+        m_coeff[1].restart(target.b1, rampFrames);
+        m_coeff[2].restart(target.b2, rampFrames);
+        m_coeff[3].restart(target.a1, rampFrames);
+        m_coeff[4].restart(target.a2, rampFrames);
+    }
+
+    void snap() {
+        for (SmoothedParam& coeff : m_coeff) coeff.snap();
+    }
+
+    bool isSteady() const {
+        for (const SmoothedParam& coeff : m_coeff) {
+            if (!coeff.isSteady()) return false;
+        }
+        return true;
+    }
+
+    Biquad value() const {
+        Biquad section;
+        section.b0 = m_coeff[0].value();
+        section.b1 = m_coeff[1].value();
+        section.b2 = m_coeff[2].value();
+        section.a1 = m_coeff[3].value();
+        section.a2 = m_coeff[4].value();
+        return section;
+    }
+
+    // Per-frame increments over the next frames, like SmoothedParam::advance().
+    Biquad advance(int frames) {
+        Biquad step;
+        step.b0 = m_coeff[0].advance(frames);
+        step.b1 = m_coeff[1].advance(frames);
+        step.b2 = m_coeff[2].advance(frames);
+        step.a1 = m_coeff[3].advance(frames);
+        step.a2 = m_coeff[4].advance(frames);
+        return step;
+    }
+
+private:
+    // Unity pass-through until the first target arrives
+    SmoothedParam m_coeff[5] = { SmoothedParam(1.0f), SmoothedParam(), SmoothedParam(), SmoothedParam(),
+                                 SmoothedParam() };
+};
+
+#endif // BIQUAD_H
@@ -1,11 +1,14 @@
 #include "audio_effect.h"
-#include <android/log.h>
+#include <atomic>
 #include <cstring>
 #include <cmath>
 #include <algorithm>
 #include <memory>
-#include <chrono>
+#include <new>
+
+#if defined(__ANDROID__)
 #include <jni.h>
+#endif
 
 #include "audio_processor.h"
 #include "binaural_processor.h"
@@ -13,11 +16,19 @@
 #include "eq_processor.h"
 #include "reverb_processor.h"
 #include "dynamic_processor.h"
+#include "dsp_stats.h"
+#include "denormal_guard.h"
+#include "format_converter.h"
+#include "channel_downmix.h"
+#include "triple_buffer.h"
+#include "session_registry.h"
+#include "dsp_arena.h"
+#include "preset_bank.h"
+#include "hrir_database.h"
+#include "quality_governor.h"
 
 #define LOG_TAG "CafeToneEffect"
-#define LOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, LOG_TAG, __VA_ARGS__)
-#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
-#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#include "dsp_log.h"
 
 // --- Forward Declarations ---
 int32_t CafeMode_Command(effect_interface_t** self, uint32_t cmdCode, uint32_t cmdSize, void* pCmdData, uint32_t* replySize, void* pReplyData);
@@ -32,30 +43,674 @@ const effect_descriptor_t gCafeModeDescriptor = {
         EFFECT_CONTROL_API_VERSION, EFFECT_FLAG_TYPE_INSERT, 0, 1, "Sony Café Mode DSP", "CaféTone Audio"
 };
 
-enum { PARAM_INTENSITY, PARAM_SPATIAL_WIDTH, PARAM_DISTANCE };
+enum { PARAM_INTENSITY, PARAM_SPATIAL_WIDTH, PARAM_DISTANCE, PARAM_BLOCK_SIZE, PARAM_IDLE_RECLAIM_MS,
+       PARAM_PREFAULT,         // DspArena::PrefaultMode
+       PARAM_PRESET,           // PresetBank index, -1 once a user parameter moves off it
+       PARAM_STAGE_MASK,       // bit (stage - STAGE_EQ) per DspStage, see STAGE_MASK_ALL
+       PARAM_QUALITY_TIER,     // best QualityTier allowed
+       PARAM_QUALITY_AUTO,     // 1 lets the governor step below PARAM_QUALITY_TIER
+       PARAM_EQ_MODE,          // EQProcessor::Mode
+       PARAM_EQ_PARTITION,     // FIR partition size in frames, power of two
+       PARAM_EQ_LATENCY,       // GET_PARAM only: FIR EQ latency in frames, 0 for the cascade
+       PARAM_HEADPHONE_CURVE,  // SET_PARAM only, see setHeadphoneCurve()
+       PARAM_HRTF_MODE,        // 1 renders the binaural stage through the HRIR set
+       PARAM_HRTF_AZIMUTH,     // degrees, positive to the right
+       PARAM_HRTF_ELEVATION,   // degrees, positive up
+       PARAM_HRTF_GRID_BYTES,  // GET_PARAM only: HRTF direction grid in use, shared across instances
+       PARAM_HRTF_CACHE_BYTES, // GET_PARAM only: this instance's cached HRTF pairs
+};
+
+// The five processing stages, EQ to dynamics, in DspStage order.
+static const int NUM_CHAIN_STAGES = STAGE_DYNAMICS - STAGE_EQ + 1;
+static const int STAGE_MASK_ALL = (1 << NUM_CHAIN_STAGES) - 1;
+
+// Instrumentation parameters. GET_PARAM replies carry an int32 status followed
+// by the report structure from dsp_stats.h as packed floats.
+enum {
+    PARAM_STAGE_STATS_BASE = 0x100,   // + DspStage -> DspStageReport
+    PARAM_CALLBACK_STATS = 0x180,     // -> DspCallbackReport
+    PARAM_STATS_RESET = 0x181,        // SET_PARAM, value ignored
+    PARAM_QUALITY_STATUS = 0x182,     // -> QualityReport
+};
+
+// One coherent parameter set with every coefficient already derived for the
+// current sample rate. Designed on the command thread and handed to the
+// audio thread through a TripleBuffer; the callback installs it before its
+// first sub-block with plain copies, so no trig or pow runs there and no
+// stage ever sees half of an update.
+struct ChainSnapshot {
+    int blockSize;
+    int idleReclaimMs;
+    int stageMask;
+    int qualityTier;
+    bool autoQuality;
+    ChainCoeffs coeffs;
+};
+
+template <typename T>
+using ArenaPtr = std::unique_ptr<T, DspArena::Destroy>;
 
 // --- Enhanced Effect Context ---
+// Lives at the start of its own DspArena, followed by the processors and
+// their delay lines; see createContext().
+// Who the delay lines' pages belong to. The audio thread binds and
+// unbinds the lines; the syscalls that drop and populate their pages run on
+// the command thread, while the lines are unbound.
+enum ChainState {
+    CHAIN_UNBOUND,      // free for the audio thread to bind
+    CHAIN_RECLAIMED,    // unbound by an idle reclaim, pages still to drop
+    CHAIN_PREPARING,    // the command thread is dropping/populating them
+    CHAIN_BOUND,        // in use by the audio thread
+};
+
 struct CafeModeContext {
     effect_interface_t mItfe;
-    std::unique_ptr<EQProcessor> eqProcessor;
-    std::unique_ptr<HaasProcessor> haasProcessor;
-    std::unique_ptr<BinauralProcessor> binauralProcessor;
-    std::unique_ptr<ReverbProcessor> reverbProcessor;
-    std::unique_ptr<DynamicProcessor> dynamicProcessor;
+    ArenaPtr<EQProcessor> eqProcessor;
+    ArenaPtr<HaasProcessor> haasProcessor;
+    ArenaPtr<BinauralProcessor> binauralProcessor;
+    ArenaPtr<ReverbProcessor> reverbProcessor;
+    ArenaPtr<DynamicProcessor> dynamicProcessor;
+    // User parameters as last set; owned by the command thread, which
+    // publishes them to the audio thread as ChainSnapshots.
     float intensity = 0.7f;
     float spatialWidth = 0.6f;
     float distance = 0.8f;
+    // Selected preset, whose precomputed coefficients replace the design
+    // step for every rate the bank covers. Mapped on first selection.
+    int preset = -1;
+    std::shared_ptr<const PresetBank> presets;
+    // Distance-indexed EQ designs at the current rate; command thread.
+    std::shared_ptr<const DistanceTable> distanceTable;
+    // EQ engine and the FIR design inputs; command thread. firDirty forces
+    // a redesign at the next publish, which otherwise only happens when the
+    // roll-off frequencies move.
+    int eqMode = EQProcessor::MODE_CASCADE;
+    int eqPartition = FirEq::DEFAULT_PARTITION;
+    HeadphoneCurve headphoneCurve;
+    EQProcessor::Coeffs firCoeffs{};
+    bool firDirty = false;
+    // HRTF rendering in the binaural stage; command thread. The HRIR set is
+    // mapped when the mode is first switched on; hrtfDirty queues a new
+    // design at the next publish.
+    bool hrtf = false;
+    float hrtfAzimuth = 0.0f;
+    float hrtfElevation = -20.0f;
+    std::shared_ptr<const HrirDatabase> hrirs;
+    bool hrtfDirty = false;
     bool enabled = false;
-    static const int MAX_BUFFER_SIZE = 4096;
-    float inputBuffer[2][MAX_BUFFER_SIZE]{};
-    float eqBuffer[2][MAX_BUFFER_SIZE]{};
-    float haasBuffer[2][MAX_BUFFER_SIZE]{};
-    float binauralBuffer[2][MAX_BUFFER_SIZE]{};
-    float reverbBuffer[2][MAX_BUFFER_SIZE]{};
-    float outputBuffer[2][MAX_BUFFER_SIZE]{};
+    static const int MAX_BLOCK_SIZE = 1024;       // capacity of one internal sub-block
+    static const int MIN_BLOCK_SIZE = 16;
+    static const int DEFAULT_BLOCK_SIZE = 64;     // fused-pipeline tile, 1 KB of buffers
+    int blockSize = DEFAULT_BLOCK_SIZE;
+    static const int DEFAULT_IDLE_RECLAIM_MS = 10000;
+    int idleReclaimMs = DEFAULT_IDLE_RECLAIM_MS;  // 0 keeps the delay lines forever
+    int stageMask = STAGE_MASK_ALL;
+    int qualityTier = QUALITY_FULL;
+    bool autoQuality = true;
+    TripleBuffer<ChainSnapshot> snapshots;
+    // Audio thread: the dry/wet mix ramps to each new intensity like the
+    // processors' own parameters. Ramps are skipped (snapped) until the
+    // chain has produced output since the last reset, and while idle or
+    // disabled, where there is nothing audible to protect.
+    SmoothedParam wetGain;
+    bool primed = false;
+    // Audio thread: per-stage crossfade between the stage's input (0) and
+    // its output (1), following the stage mask; targets arrive with the
+    // first snapshot like every other parameter. A stage whose fade rests
+    // at 0 is not run at all, and one that missed blocks that way is reset
+    // before it fades back in, so stale delay lines never surface.
+    SmoothedParam stageMix[NUM_CHAIN_STAGES];
+    bool stageStale[NUM_CHAIN_STAGES]{};
+    // Audio thread: the tier actually run, from the snapshot's request and
+    // the measured callback cost. Tier changes go through the same ramps.
+    QualityGovernor quality;
+    // The chain is strictly linear and every stage accepts aliased in/out
+    // pointers, so the whole wet path runs in place in one work buffer. The
+    // dry copy is kept for the intensity mix. 8 KB per buffer at capacity.
+    float dryBuffer[2][MAX_BLOCK_SIZE]{};
+    float wetBuffer[2][MAX_BLOCK_SIZE]{};
+    float fadeBuffer[2][MAX_BLOCK_SIZE]{};   // a stage's input while it crossfades
+    // The dry path delayed by the wet path's latency (FIR EQ and HRTF), so the
+    // mix does not comb. Fed whenever the chain runs, so a latency that
+    // appears with a new design finds the ring already filled. Two rings in
+    // the arena's delay-line pages.
+    static const int DRY_DELAY_FRAMES = 4096;
+    float* dryDelay = nullptr;
+    int dryDelayIndex = 0;
     int sampleRate = 48000;
+    // Negotiated through EFFECT_CMD_SET_CONFIG; until then the effect runs on
+    // interleaved stereo int16 at 48 kHz as it always has.
+    effect_config_t config{};
+    int inputFormat = AUDIO_FORMAT_PCM_16_BIT;
+    int outputFormat = AUDIO_FORMAT_PCM_16_BIT;
+    bool accumulate = false;
+    // 5.1/7.1 input is folded to stereo on the way in; output is always stereo.
+    int inputChannels = 2;
+    std::unique_ptr<ChannelDownmix> downmix;
+    // Silence detection: once the input has been silent and the wet output
+    // below SILENCE_THRESHOLD for longer than the chain's delay-line memory,
+    // the chain is skipped until the input comes back. Processor state is
+    // left as is, so resuming continues the (inaudible) tails seamlessly.
+    static constexpr float SILENCE_THRESHOLD = 1.0e-5f;   // -100 dBFS
+    bool idle = true;
+    int quietFrames = 0;
+    // The processors' delay lines (~300 KB) are bound the first time the
+    // chain has to run on real input, and their pages given back once the
+    // chain has been idle or disabled for idleReclaimMs (PREFAULT_POPULATE
+    // faults them straight back in while enabled). Streams that rarely play
+    // (alarm, dtmf, ...) then only cost the context and the processor
+    // objects. stateReady is the audio thread's view; chainState says who
+    // may touch the lines, see ChainState.
+    bool stateReady = false;
+    std::atomic<int> chainState{ CHAIN_UNBOUND };
+    uint64_t idleRunFrames = 0;
+    DspStats stats;
+    // Owns the memory this context lives in; see destroyContext().
+    DspArena arena;
+    float* delayLines = nullptr;      // page-aligned tail of the arena
+    size_t delayLineBytes = 0;
+    int prefaultMode = DspArena::PREFAULT_POPULATE;
 };
 
+static_assert(CafeModeContext::DRY_DELAY_FRAMES >
+                      FirEq::MAX_PARTITION + FirEq::MAX_TAPS / 2 + HrtfRenderer::PARTITION + HrtfGrid::DELAY,
+              "dry delay shorter than the longest wet-path latency");
+
+static const int MIN_SAMPLE_RATE = 8000;
+static const int MAX_SAMPLE_RATE = 192000;
+
+static void initDefaultConfig(CafeModeContext* ctx) {
+    for (buffer_config_t* cfg : { &ctx->config.inputCfg, &ctx->config.outputCfg }) {
+        cfg->samplingRate = (uint32_t)ctx->sampleRate;
+        cfg->channels = AUDIO_CHANNEL_OUT_STEREO;
+        cfg->format = AUDIO_FORMAT_PCM_16_BIT;
+        cfg->mask = EFFECT_CONFIG_ALL;
+    }
+    ctx->config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+    ctx->config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+}
+
+static void resetProcessors(CafeModeContext* ctx) {
+    ctx->eqProcessor->reset();
+    ctx->haasProcessor->reset();
+    ctx->binauralProcessor->reset();
+    ctx->reverbProcessor->reset();
+    ctx->dynamicProcessor->reset();
+    if (ctx->downmix) ctx->downmix->reset();
+    if (ctx->dryDelay) memset(ctx->dryDelay, 0, 2 * CafeModeContext::DRY_DELAY_FRAMES * sizeof(float));
+    ctx->dryDelayIndex = 0;
+    ctx->wetGain.snap();
+    ctx->primed = false;
+    // Cleared delay lines hold no tail, so the chain starts out idle
+    ctx->idle = true;
+    ctx->quietFrames = 0;
+}
+
+// Audio thread, only on the transition between silence and playback, never
+// per block. The delay lines come from the arena, so acquiring just binds and
+// zeroes them; with the pages populated that takes no page faults. False
+// while the command thread is dropping or populating them.
+static bool acquireChainState(CafeModeContext* ctx) {
+    int state = ctx->chainState.load(std::memory_order_acquire);
+    if ((state != CHAIN_UNBOUND && state != CHAIN_RECLAIMED) ||
+        !ctx->chainState.compare_exchange_strong(state, CHAIN_BOUND, std::memory_order_acq_rel)) {
+        return false;
+    }
+    ctx->stateReady = ctx->eqProcessor->allocateState() && ctx->haasProcessor->allocateState() &&
+                      ctx->binauralProcessor->allocateState() && ctx->reverbProcessor->allocateState() &&
+                      ctx->dynamicProcessor->allocateState();
+    if (!ctx->stateReady) ctx->chainState.store(CHAIN_UNBOUND, std::memory_order_release);
+    return ctx->stateReady;
+}
+
+// Audio thread. Only unbinds the lines; their pages go back to the kernel
+// from the command thread (prepareChainState()), no syscall here.
+static void releaseChainState(CafeModeContext* ctx) {
+    ctx->eqProcessor->releaseState();
+    ctx->haasProcessor->releaseState();
+    ctx->binauralProcessor->releaseState();
+    ctx->reverbProcessor->releaseState();
+    ctx->dynamicProcessor->releaseState();
+    ctx->dryDelayIndex = 0;
+    // Filters and envelopes restart from rest along with the delay lines
+    ctx->eqProcessor->reset();
+    ctx->haasProcessor->reset();
+    ctx->binauralProcessor->reset();
+    ctx->reverbProcessor->reset();
+    ctx->dynamicProcessor->reset();
+    ctx->stateReady = false;
+    ctx->idle = true;
+    ctx->quietFrames = 0;
+    ctx->chainState.store(CHAIN_RECLAIMED, std::memory_order_release);
+}
+
+// Command thread. Faults the delay-line pages in ahead of the first
+// non-silent callback, which would otherwise take ~70 page faults while
+// zeroing them: on enable, and again after every idle reclaim. Page
+// contents are left alone, so a running callback is unaffected.
+static void prefaultChainState(CafeModeContext* ctx) {
+    if (ctx->prefaultMode != DspArena::PREFAULT_POPULATE || !ctx->delayLines) return;
+    if (!DspArena::populate(ctx->delayLines, ctx->delayLineBytes)) {
+        LOGV("Delay-line prefault unavailable, pages fault in on first use");
+    }
+}
+
+// Command thread, at the start of every command. Acts on an idle reclaim
+// the audio thread flagged: drops the lines' stale pages and, for an
+// enabled effect in PREFAULT_POPULATE, populates them again, so the next
+// playback binds zero pages without faulting. The pages then stay
+// resident; PREFAULT_NONE is the mode that trades those faults for memory.
+// A playback starting meanwhile runs dry until this returns.
+static void prepareChainState(CafeModeContext* ctx) {
+    int state = CHAIN_RECLAIMED;
+    if (!ctx->chainState.compare_exchange_strong(state, CHAIN_PREPARING, std::memory_order_acq_rel)) return;
+    if (ctx->delayLines) DspArena::discard(ctx->delayLines, ctx->delayLineBytes);
+    if (ctx->enabled) prefaultChainState(ctx);
+    ctx->chainState.store(CHAIN_UNBOUND, std::memory_order_release);
+}
+
+static void setPrefaultMode(CafeModeContext* ctx, int mode) {
+    mode = std::clamp(mode, (int)DspArena::PREFAULT_NONE, (int)DspArena::PREFAULT_LOCK);
+    if (mode == DspArena::PREFAULT_LOCK) {
+        if (!ctx->arena.lock()) {
+            LOGE("Cannot lock %zu byte arena (RLIMIT_MEMLOCK?), populating instead", ctx->arena.capacity());
+            mode = DspArena::PREFAULT_POPULATE;
+        }
+    } else {
+        ctx->arena.unlock();
+    }
+    ctx->prefaultMode = mode;
+    if (ctx->enabled) prefaultChainState(ctx);
+}
+
+static int chainTailFrames(const CafeModeContext* ctx) {
+    return ctx->eqProcessor->getTailSamples() + ctx->haasProcessor->getTailSamples() +
+           ctx->binauralProcessor->getTailSamples() + ctx->reverbProcessor->getTailSamples() +
+           ctx->dynamicProcessor->getTailSamples();
+}
+
+// Latency of the wet path that the dry path has to match: the EQ's and the
+// binaural stage's, each unless its stage is masked off and not running.
+static int wetLatency(const CafeModeContext* ctx) {
+    auto running = [ctx](int stage) {
+        const SmoothedParam& mix = ctx->stageMix[stage - STAGE_EQ];
+        return !mix.isSteady() || mix.value() != 0.0f;
+    };
+    int latency = 0;
+    if (running(STAGE_EQ)) latency += ctx->eqProcessor->getLatencySamples();
+    if (running(STAGE_BINAURAL)) latency += ctx->binauralProcessor->getLatencySamples();
+    return latency;
+}
+
+// Audio thread: pushes the dry block through the ring and, unless
+// writeOnly, replaces it with the block from latency frames ago.
+static void delayDry(CafeModeContext* ctx, float* left, float* right, int frames, int latency, bool writeOnly) {
+    if (!ctx->dryDelay) return;
+    const int mask = CafeModeContext::DRY_DELAY_FRAMES - 1;
+    float* ringL = ctx->dryDelay;
+    float* ringR = ctx->dryDelay + CafeModeContext::DRY_DELAY_FRAMES;
+    int index = ctx->dryDelayIndex;
+    if (writeOnly || latency == 0) {
+        for (int i = 0; i < frames; i++) {
+            ringL[(index + i) & mask] = left[i];
+            ringR[(index + i) & mask] = right[i];
+        }
+    } else {
+        for (int i = 0; i < frames; i++) {
+            const int write = (index + i) & mask;
+            const int read = (index + i - latency) & mask;
+            ringL[write] = left[i];
+            ringR[write] = right[i];
+            left[i] = ringL[read];
+            right[i] = ringR[read];
+        }
+    }
+    ctx->dryDelayIndex = (index + frames) & mask;
+}
+
+// Command thread: queues a new FIR design when the EQ runs in an FIR mode
+// and its target moved, or when the mode, partition size, correction curve
+// or rate changed. The design (tens of FFTs on fine grids) never runs on the
+// audio thread; the EQ crossfades to it at its next partition boundary.
+static void updateFirEq(CafeModeContext* ctx, const EQProcessor::Coeffs& eq) {
+    const bool fir = ctx->eqMode != EQProcessor::MODE_CASCADE;
+    const bool moved = eq.highPassFreq != ctx->firCoeffs.highPassFreq || eq.lowPassFreq != ctx->firCoeffs.lowPassFreq;
+    if (!ctx->firDirty && !(fir && moved)) return;
+    ctx->eqProcessor->designFir((EQProcessor::Mode)ctx->eqMode, eq, ctx->headphoneCurve, ctx->eqPartition);
+    ctx->firCoeffs = eq;
+    ctx->firDirty = false;
+}
+
+// Command thread: the latency of the FIR EQ as configured, for GET_PARAM.
+static int firLatency(const CafeModeContext* ctx) {
+    if (ctx->eqMode == EQProcessor::MODE_CASCADE) return 0;
+    const FirDesign::Phase phase =
+            ctx->eqMode == EQProcessor::MODE_LINEAR_PHASE ? FirDesign::LINEAR_PHASE : FirDesign::MINIMUM_PHASE;
+    return FirEq::latencyFor(phase, ctx->eqPartition, ctx->sampleRate);
+}
+
+// Command thread: queues the HRTF design for the current direction and
+// rate, or the switch back to the gain approximation. Like the FIR EQ's,
+// the design never runs on the audio thread.
+static void updateHrtf(CafeModeContext* ctx) {
+    if (!ctx->hrtfDirty) return;
+    const std::shared_ptr<const HrirDatabase> hrirs = ctx->hrtf ? ctx->hrirs : nullptr;
+    if (hrirs && hrirs->rateIndex(ctx->sampleRate) < 0) {
+        LOGW("HRIR set has no %d Hz responses, HRTF rendering off", ctx->sampleRate);
+    }
+    ctx->binauralProcessor->designHrtf(hrirs, ctx->hrtfAzimuth, ctx->hrtfElevation);
+    ctx->hrtfDirty = false;
+    LOGV("HRTF memory: grid %zu KB, pair cache %zu KB", ctx->binauralProcessor->getHrtfGridBytes() / 1024,
+         ctx->binauralProcessor->getHrtfCacheBytes() / 1024);
+}
+
+static float blockPeak(const float* left, const float* right, int frames) {
+    float peak = 0.0f;
+    for (int i = 0; i < frames; i++) {
+        peak = std::max(peak, std::max(fabsf(left[i]), fabsf(right[i])));
+    }
+    return peak;
+}
+
+// Command thread: derives a snapshot from the current parameters and sample
+// rate and makes it the one the next callback picks up. A selected preset
+// that the bank has precomputed for this rate is copied instead.
+static void publishSnapshot(CafeModeContext* ctx) {
+    ChainSnapshot& snapshot = ctx->snapshots.writable();
+    snapshot.blockSize = ctx->blockSize;
+    snapshot.idleReclaimMs = ctx->idleReclaimMs;
+    snapshot.stageMask = ctx->stageMask;
+    snapshot.qualityTier = ctx->qualityTier;
+    snapshot.autoQuality = ctx->autoQuality;
+    const ChainCoeffs* precomputed = ctx->preset >= 0 ? ctx->presets->record(ctx->preset, ctx->sampleRate) : nullptr;
+    if (precomputed) {
+        snapshot.coeffs = *precomputed;
+    } else {
+        snapshot.coeffs = ChainCoeffs::design(ctx->intensity, ctx->spatialWidth, ctx->distance,
+                                              ctx->haasProcessor->getParameter(1), *ctx->distanceTable);
+    }
+    updateFirEq(ctx, snapshot.coeffs.eq);
+    updateHrtf(ctx);
+    ctx->snapshots.publish();
+}
+
+// Audio thread: points the stage crossfades and the reverb's reflection
+// count at the user's stage mask as limited by the active quality tier.
+// MINIMAL drops the reverb stage, the most expensive one, entirely.
+static void applyQualityTier(CafeModeContext* ctx, int stageMask) {
+    const int tier = ctx->quality.activeTier();
+    if (tier >= QUALITY_MINIMAL) stageMask &= ~(1 << (STAGE_REVERB - STAGE_EQ));
+    ctx->reverbProcessor->setReducedReflections(tier >= QUALITY_REDUCED);
+    for (int i = 0; i < NUM_CHAIN_STAGES; i++) {
+        ctx->stageMix[i].setTarget((stageMask >> i) & 1 ? 1.0f : 0.0f, SmoothedParam::rampFrames(ctx->sampleRate));
+    }
+}
+
+// Audio thread, before a callback's first sub-block. Sets the processors'
+// ramp targets; the values themselves move as blocks are processed.
+static void applySnapshot(CafeModeContext* ctx, const ChainSnapshot& snapshot) {
+    const ChainCoeffs& coeffs = snapshot.coeffs;
+    ctx->eqProcessor->setCoeffs(coeffs.eq);
+    ctx->haasProcessor->setCoeffs(coeffs.haas);
+    ctx->binauralProcessor->setCoeffs(coeffs.binaural);
+    ctx->dynamicProcessor->setDistanceCompression(coeffs.distanceCompression);
+    ctx->wetGain.setTarget(coeffs.intensity, SmoothedParam::rampFrames(ctx->sampleRate));
+    ctx->quality.configure(snapshot.qualityTier, snapshot.autoQuality);
+    applyQualityTier(ctx, snapshot.stageMask);
+}
+
+static void snapParameters(CafeModeContext* ctx) {
+    ctx->eqProcessor->snapParameters();
+    ctx->haasProcessor->snapParameters();
+    ctx->binauralProcessor->snapParameters();
+    ctx->reverbProcessor->snapParameters();
+    ctx->dynamicProcessor->snapParameters();
+    ctx->wetGain.snap();
+    for (SmoothedParam& mix : ctx->stageMix) mix.snap();
+}
+
+// Command thread: switches all user parameters to a preset from the bank at
+// once. The whole chain changes at the next callback boundary, like any
+// other snapshot.
+static int32_t selectPreset(CafeModeContext* ctx, int preset) {
+    if (!ctx->presets) ctx->presets = PresetBank::shared();
+    if (!ctx->presets) {
+        LOGE("No preset bank available");
+        return -EINVAL;
+    }
+    if (preset < 0 || preset >= ctx->presets->presetCount()) {
+        LOGE("Preset %d out of range (%d presets)", preset, ctx->presets->presetCount());
+        return -EINVAL;
+    }
+    const ChainCoeffs& values = ctx->presets->anyRecord(preset);
+    ctx->intensity = values.intensity;
+    ctx->spatialWidth = values.spatialWidth;
+    ctx->distance = values.distance;
+    ctx->preset = preset;
+    if (!ctx->presets->record(preset, ctx->sampleRate)) {
+        LOGW("Preset '%s' has no %d Hz record, designing it", ctx->presets->name(preset), ctx->sampleRate);
+    }
+    LOGV("Preset %d ('%s') selected", preset, ctx->presets->name(preset));
+    return 0;
+}
+
+// Command thread: updates one user parameter and publishes the result.
+// Returns -EINVAL for ids that are not chain parameters.
+static int32_t setChainParameter(CafeModeContext* ctx, int32_t paramId, float value) {
+    switch (paramId) {
+        case PARAM_INTENSITY:
+            ctx->intensity = std::clamp(value, 0.0f, 1.0f);
+            ctx->preset = -1;
+            LOGV("Sony Café Mode intensity set to: %.2f", ctx->intensity);
+            break;
+        case PARAM_SPATIAL_WIDTH:
+            ctx->spatialWidth = std::clamp(value, 0.0f, 1.0f);
+            ctx->preset = -1;
+            LOGV("Sony Café Mode spatial width set to: %.2f", ctx->spatialWidth);
+            break;
+        case PARAM_DISTANCE:
+            ctx->distance = std::clamp(value, 0.0f, 1.0f);
+            ctx->preset = -1;
+            LOGV("Sony Café Mode distance set to: %.2f", ctx->distance);
+            break;
+        case PARAM_PRESET: {
+            int32_t status = selectPreset(ctx, (int)value);
+            if (status != 0) return status;
+            break;
+        }
+        case PARAM_BLOCK_SIZE:
+            ctx->blockSize = std::clamp((int)value, (int)CafeModeContext::MIN_BLOCK_SIZE,
+                                        (int)CafeModeContext::MAX_BLOCK_SIZE);
+            LOGV("Internal block size set to: %d frames", ctx->blockSize);
+            break;
+        case PARAM_STAGE_MASK:
+            ctx->stageMask = (int)value & STAGE_MASK_ALL;
+            LOGV("Stage mask set to: 0x%02x", ctx->stageMask);
+            break;
+        case PARAM_QUALITY_TIER:
+            ctx->qualityTier = std::clamp((int)value, (int)QUALITY_FULL, NUM_QUALITY_TIERS - 1);
+            LOGV("Quality tier set to: %d", ctx->qualityTier);
+            break;
+        case PARAM_QUALITY_AUTO:
+            ctx->autoQuality = value != 0.0f;
+            LOGV("Automatic quality %s", ctx->autoQuality ? "on" : "off");
+            break;
+        case PARAM_EQ_MODE:
+            ctx->eqMode = std::clamp((int)value, (int)EQProcessor::MODE_CASCADE, EQProcessor::NUM_MODES - 1);
+            ctx->firDirty = true;
+            LOGV("EQ mode set to: %d", ctx->eqMode);
+            break;
+        case PARAM_EQ_PARTITION:
+            ctx->eqPartition = FirEq::clampPartition((int)value);
+            ctx->firDirty = ctx->firDirty || ctx->eqMode != EQProcessor::MODE_CASCADE;
+            LOGV("EQ partition set to: %d frames", ctx->eqPartition);
+            break;
+        case PARAM_HRTF_MODE:
+            if (value != 0.0f && !ctx->hrirs) ctx->hrirs = HrirDatabase::shared();
+            if (value != 0.0f && !ctx->hrirs) {
+                LOGE("No HRIR set available");
+                return -EINVAL;
+            }
+            ctx->hrtf = value != 0.0f;
+            ctx->hrtfDirty = true;
+            LOGV("HRTF rendering %s", ctx->hrtf ? "on" : "off");
+            break;
+        case PARAM_HRTF_AZIMUTH:
+            ctx->hrtfAzimuth = std::clamp(value, -180.0f, 180.0f);
+            ctx->hrtfDirty = ctx->hrtf;
+            LOGV("HRTF azimuth set to: %.1f", ctx->hrtfAzimuth);
+            break;
+        case PARAM_HRTF_ELEVATION:
+            ctx->hrtfElevation = std::clamp(value, -90.0f, 90.0f);
+            ctx->hrtfDirty = ctx->hrtf;
+            LOGV("HRTF elevation set to: %.1f", ctx->hrtfElevation);
+            break;
+        case PARAM_IDLE_RECLAIM_MS:
+            ctx->idleReclaimMs = std::max((int)value, 0);
+            LOGV("Idle state reclaim set to: %d ms", ctx->idleReclaimMs);
+            break;
+        case PARAM_PREFAULT:
+            setPrefaultMode(ctx, (int)value);
+            LOGV("Prefault mode set to: %d", ctx->prefaultMode);
+            break;
+        default:
+            return -EINVAL;
+    }
+    publishSnapshot(ctx);
+    return 0;
+}
+
+// Command thread: replaces the headphone correction the FIR EQ modes add to
+// the café curve. The SET_PARAM payload after the parameter id is an int32
+// point count followed by that many (frequency Hz, gain dB) float pairs; a
+// count of 0 removes the correction.
+static int32_t setHeadphoneCurve(CafeModeContext* ctx, const void* data, uint32_t size) {
+    int32_t count = 0;
+    if (size < sizeof(count)) return -EINVAL;
+    memcpy(&count, data, sizeof(count));
+    if (count < 0 || count > HeadphoneCurve::MAX_POINTS ||
+        size < sizeof(count) + (size_t)count * 2 * sizeof(float)) {
+        return -EINVAL;
+    }
+    float frequencies[HeadphoneCurve::MAX_POINTS];
+    float gains[HeadphoneCurve::MAX_POINTS];
+    const auto* points = static_cast<const uint8_t*>(data) + sizeof(count);
+    for (int i = 0; i < count; i++) {
+        memcpy(&frequencies[i], points + (size_t)i * 2 * sizeof(float), sizeof(float));
+        memcpy(&gains[i], points + ((size_t)i * 2 + 1) * sizeof(float), sizeof(float));
+    }
+    if (!ctx->headphoneCurve.set(frequencies, gains, count)) return -EINVAL;
+    ctx->firDirty = ctx->firDirty || ctx->eqMode != EQProcessor::MODE_CASCADE;
+    LOGV("Headphone correction set: %d points", ctx->headphoneCurve.pointCount());
+    publishSnapshot(ctx);
+    return 0;
+}
+
+// Validates and applies a new I/O configuration: stereo, 5.1 or 7.1 in,
+// stereo out, at the same rate and in any supported PCM format on either side.
+static int32_t setConfig(CafeModeContext* ctx, const effect_config_t* config) {
+    const buffer_config_t& in = config->inputCfg;
+    const buffer_config_t& out = config->outputCfg;
+    if (in.samplingRate != out.samplingRate ||
+        (int)in.samplingRate < MIN_SAMPLE_RATE || (int)in.samplingRate > MAX_SAMPLE_RATE) {
+        LOGE("SET_CONFIG: unsupported sample rate %u -> %u", in.samplingRate, out.samplingRate);
+        return -EINVAL;
+    }
+    if (out.channels != AUDIO_CHANNEL_OUT_STEREO) {
+        LOGE("SET_CONFIG: unsupported output channel mask 0x%x", out.channels);
+        return -EINVAL;
+    }
+    if (!isSupportedPcmFormat(in.format) || !isSupportedPcmFormat(out.format)) {
+        LOGE("SET_CONFIG: unsupported format %d -> %d", in.format, out.format);
+        return -EINVAL;
+    }
+    if (out.accessMode != EFFECT_BUFFER_ACCESS_WRITE && out.accessMode != EFFECT_BUFFER_ACCESS_ACCUMULATE) {
+        LOGE("SET_CONFIG: unsupported output access mode %d", out.accessMode);
+        return -EINVAL;
+    }
+    if (in.channels != AUDIO_CHANNEL_OUT_STEREO) {
+        if (!ctx->downmix) {
+            ctx->downmix.reset(new(std::nothrow) ChannelDownmix());
+            if (!ctx->downmix) return -ENOMEM;
+        }
+        if (!ctx->downmix->setLayout(in.channels)) {
+            LOGE("SET_CONFIG: unsupported input channel mask 0x%x", in.channels);
+            return -EINVAL;
+        }
+        ctx->downmix->setSampleRate((int)in.samplingRate);
+    }
+
+    ctx->config = *config;
+    ctx->inputFormat = in.format;
+    ctx->outputFormat = out.format;
+    ctx->accumulate = out.accessMode == EFFECT_BUFFER_ACCESS_ACCUMULATE;
+    ctx->inputChannels = in.channels == AUDIO_CHANNEL_OUT_STEREO ? 2 : ctx->downmix->getChannelCount();
+    if ((int)in.samplingRate != ctx->sampleRate) {
+        ctx->sampleRate = (int)in.samplingRate;
+        ctx->eqProcessor->setSampleRate(ctx->sampleRate);
+        ctx->haasProcessor->setSampleRate(ctx->sampleRate);
+        ctx->binauralProcessor->setSampleRate(ctx->sampleRate);
+        ctx->reverbProcessor->setSampleRate(ctx->sampleRate);
+        ctx->dynamicProcessor->setSampleRate(ctx->sampleRate);
+        ctx->distanceTable = DistanceTable::forRate(ctx->sampleRate);
+        ctx->firDirty = ctx->firDirty || ctx->eqMode != EQProcessor::MODE_CASCADE;
+        ctx->hrtfDirty = ctx->hrtfDirty || ctx->hrtf;
+        // Supersedes any snapshot still pending at the old rate.
+        publishSnapshot(ctx);
+    }
+    resetProcessors(ctx);
+    LOGI("Configured for %d Hz, %d -> 2 channels, format %d -> %d%s", ctx->sampleRate, ctx->inputChannels,
+         ctx->inputFormat, ctx->outputFormat, ctx->accumulate ? " (accumulate)" : "");
+    return 0;
+}
+
+// Lays one instance out in a single arena: the context (with its dry/wet
+// tiles) and the processors in processing order, then the delay lines
+// starting on a fresh page so idle reclaim can drop exactly those pages.
+// Returns nullptr if the mapping fails.
+static CafeModeContext* createContext() {
+    size_t objectBytes = DspArena::alignUp(sizeof(CafeModeContext)) + DspArena::alignUp(sizeof(EQProcessor)) +
+                         DspArena::alignUp(sizeof(HaasProcessor)) + DspArena::alignUp(sizeof(BinauralProcessor)) +
+                         DspArena::alignUp(sizeof(ReverbProcessor)) + DspArena::alignUp(sizeof(DynamicProcessor));
+    const size_t dryDelayBytes = 2 * CafeModeContext::DRY_DELAY_FRAMES * sizeof(float);
+    size_t capacity = DspArena::alignUp(objectBytes, DspArena::pageSize()) +
+                      DspArena::alignUp(EQProcessor::STATE_BYTES) + DspArena::alignUp(dryDelayBytes) +
+                      DspArena::alignUp(HaasProcessor::STATE_BYTES) + DspArena::alignUp(BinauralProcessor::STATE_BYTES) +
+                      ReverbProcessor::STATE_BYTES;
+    DspArena arena;
+    if (!arena.reserve(capacity)) return nullptr;
+
+    auto* ctx = arena.create<CafeModeContext>();
+    ctx->eqProcessor.reset(arena.create<EQProcessor>());
+    ctx->haasProcessor.reset(arena.create<HaasProcessor>());
+    ctx->binauralProcessor.reset(arena.create<BinauralProcessor>());
+    ctx->reverbProcessor.reset(arena.create<ReverbProcessor>());
+    ctx->dynamicProcessor.reset(arena.create<DynamicProcessor>());
+
+    arena.alignToPage();
+    auto* eqState = static_cast<float*>(arena.allocate(EQProcessor::STATE_BYTES));
+    ctx->dryDelay = static_cast<float*>(arena.allocate(dryDelayBytes));
+    auto* haasState = static_cast<float*>(arena.allocate(HaasProcessor::STATE_BYTES));
+    auto* binauralState = static_cast<float*>(arena.allocate(BinauralProcessor::STATE_BYTES));
+    auto* reverbState = static_cast<float*>(arena.allocate(ReverbProcessor::STATE_BYTES));
+    ctx->eqProcessor->setStateStorage(eqState);
+    ctx->haasProcessor->setStateStorage(haasState);
+    ctx->binauralProcessor->setStateStorage(binauralState);
+    ctx->reverbProcessor->setStateStorage(reverbState);
+    ctx->delayLines = eqState;
+    ctx->delayLineBytes = (size_t)((char*)reverbState - (char*)eqState) + ReverbProcessor::STATE_BYTES;
+
+    ctx->arena = std::move(arena);
+    return ctx;
+}
+
+static void destroyContext(CafeModeContext* ctx) {
+    if (!ctx) return;
+    // Take the mapping out first: the context is about to end inside it
+    DspArena arena = std::move(ctx->arena);
+    ctx->~CafeModeContext();
+}
+
 // --- C-Style Interface Implementation ---
 extern "C" {
 CafeModeContext* g_context = nullptr;
@@ -69,29 +724,28 @@ int32_t EffectCreate(const effect_uuid_t* uuid, [[maybe_unused]] int32_t session
         return -EINVAL;
     }
 
-    auto* ctx = new(std::nothrow) CafeModeContext;
+    auto* ctx = createContext();
     if (!ctx) {
         LOGE("EffectCreate: Memory allocation failed");
         return -ENOMEM;
     }
 
     ctx->mItfe = gCafeModeInterface;
+    initDefaultConfig(ctx);
 
     try {
-        ctx->eqProcessor = std::make_unique<EQProcessor>();
-        ctx->haasProcessor = std::make_unique<HaasProcessor>();
-        ctx->binauralProcessor = std::make_unique<BinauralProcessor>();
-        ctx->reverbProcessor = std::make_unique<ReverbProcessor>();
-        ctx->dynamicProcessor = std::make_unique<DynamicProcessor>();
         ctx->eqProcessor->setSampleRate(ctx->sampleRate);
         ctx->haasProcessor->setSampleRate(ctx->sampleRate);
         ctx->binauralProcessor->setSampleRate(ctx->sampleRate);
         ctx->reverbProcessor->setSampleRate(ctx->sampleRate);
         ctx->dynamicProcessor->setSampleRate(ctx->sampleRate);
-        LOGI("Sony Café Mode DSP chain initialized successfully");
+        ctx->distanceTable = DistanceTable::forRate(ctx->sampleRate);
+        publishSnapshot(ctx);
+        LOGI("Sony Café Mode DSP chain initialized successfully (%d shared tables live)",
+             SessionRegistry::liveTableCount());
     } catch (const std::bad_alloc& e) {
         LOGE("EffectCreate: DSP processor allocation failed");
-        delete ctx;
+        destroyContext(ctx);
         return -ENOMEM;
     }
 
@@ -102,7 +756,7 @@ int32_t EffectCreate(const effect_uuid_t* uuid, [[maybe_unused]] int32_t session
 int32_t EffectRelease(effect_interface_t** itfe) {
     LOGI("EffectRelease called");
     if (!itfe || !*itfe) return -EINVAL;
-    delete reinterpret_cast<CafeModeContext*>(*itfe);
+    destroyContext(reinterpret_cast<CafeModeContext*>(*itfe));
     *itfe = nullptr;
     return 0;
 }
@@ -125,17 +779,17 @@ audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM = {
         .get_descriptor = EffectGetDescriptor
 };
 
+#if defined(__ANDROID__)
 // GUARANTEED FIX: Added [[maybe_unused]] to JNI parameters to silence compiler warnings.
 JNIEXPORT jint JNICALL
 Java_com_cafetone_audio_dsp_CafeModeDSP_nativeInit([[maybe_unused]] JNIEnv *env, [[maybe_unused]] jobject thiz) {
     if (g_context == nullptr) {
-        g_context = new(std::nothrow) CafeModeContext();
+        g_context = createContext();
         if (g_context) {
-            g_context->eqProcessor = std::make_unique<EQProcessor>();
-            g_context->haasProcessor = std::make_unique<HaasProcessor>();
-            g_context->binauralProcessor = std::make_unique<BinauralProcessor>();
-            g_context->reverbProcessor = std::make_unique<ReverbProcessor>();
-            g_context->dynamicProcessor = std::make_unique<DynamicProcessor>();
+            initDefaultConfig(g_context);
+            // publishSnapshot() designs from it, as in EffectCreate
+            g_context->distanceTable = DistanceTable::forRate(g_context->sampleRate);
+            publishSnapshot(g_context);
         }
     }
     return g_context != nullptr ? 0 : -1;
@@ -143,18 +797,73 @@ Java_com_cafetone_audio_dsp_CafeModeDSP_nativeInit([[maybe_unused]] JNIEnv *env,
 
 JNIEXPORT void JNICALL
 Java_com_cafetone_audio_dsp_CafeModeDSP_nativeRelease([[maybe_unused]] JNIEnv *env, [[maybe_unused]] jobject thiz) {
-delete g_context;
+destroyContext(g_context);
 g_context = nullptr;
 }
 
 JNIEXPORT void JNICALL
 Java_com_cafetone_audio_dsp_CafeModeDSP_nativeSetParameter([[maybe_unused]] JNIEnv *env, [[maybe_unused]] jobject thiz, jint param_id, jfloat value) {
 if (g_context == nullptr) return;
-switch (param_id) {
-case PARAM_INTENSITY: g_context->intensity = value; break;
-case PARAM_SPATIAL_WIDTH: g_context->spatialWidth = value; break;
-case PARAM_DISTANCE: g_context->distance = value; break;
+setChainParameter(g_context, param_id, value);
+}
+
+// Bit (stage - STAGE_EQ) per DspStage from EQ to dynamics; cleared stages
+// fade out and stop running. The layout is mirrored in CafeModeDSP.kt.
+JNIEXPORT void JNICALL
+Java_com_cafetone_audio_dsp_CafeModeDSP_nativeSetStageMask([[maybe_unused]] JNIEnv *env, [[maybe_unused]] jobject thiz, jint mask) {
+if (g_context == nullptr) return;
+setChainParameter(g_context, PARAM_STAGE_MASK, (float)mask);
 }
+
+// Maps a preset bank (see preset_bank.h) for PARAM_PRESET. Returns the
+// number of presets, -1 if the file is missing or malformed.
+JNIEXPORT jint JNICALL
+Java_com_cafetone_audio_dsp_CafeModeDSP_nativeLoadPresets(JNIEnv *env, [[maybe_unused]] jobject thiz, jstring path) {
+if (g_context == nullptr || path == nullptr) return -1;
+const char* chars = env->GetStringUTFChars(path, nullptr);
+if (chars == nullptr) return -1;
+std::shared_ptr<const PresetBank> bank = PresetBank::open(chars);
+env->ReleaseStringUTFChars(path, chars);
+if (!bank) return -1;
+g_context->presets = bank;
+g_context->preset = -1;
+return bank->presetCount();
+}
+
+// Maps an HRIR set (see hrir_database.h) for the HRTF mode, replacing the
+// default one. Returns the number of measured directions, -1 if the file is
+// missing or malformed.
+JNIEXPORT jint JNICALL
+Java_com_cafetone_audio_dsp_CafeModeDSP_nativeLoadHrirs(JNIEnv *env, [[maybe_unused]] jobject thiz, jstring path) {
+if (g_context == nullptr || path == nullptr) return -1;
+const char* chars = env->GetStringUTFChars(path, nullptr);
+if (chars == nullptr) return -1;
+std::shared_ptr<const HrirDatabase> hrirs = HrirDatabase::open(chars);
+env->ReleaseStringUTFChars(path, chars);
+if (!hrirs) return -1;
+g_context->hrirs = hrirs;
+g_context->hrtfDirty = g_context->hrtf;
+publishSnapshot(g_context);
+return hrirs->measurementCount();
+}
+
+// Headphone correction for the FIR EQ modes as parallel frequency (Hz) and
+// gain (dB) arrays; empty arrays remove it. Returns 0 or -EINVAL.
+JNIEXPORT jint JNICALL
+Java_com_cafetone_audio_dsp_CafeModeDSP_nativeSetHeadphoneCurve(JNIEnv *env, [[maybe_unused]] jobject thiz, jfloatArray frequencies, jfloatArray gains) {
+if (g_context == nullptr || frequencies == nullptr || gains == nullptr) return -EINVAL;
+const jsize count = env->GetArrayLength(frequencies);
+if (count != env->GetArrayLength(gains) || count > HeadphoneCurve::MAX_POINTS) return -EINVAL;
+uint8_t payload[sizeof(int32_t) + HeadphoneCurve::MAX_POINTS * 2 * sizeof(float)];
+const int32_t points = count;
+memcpy(payload, &points, sizeof(points));
+for (jsize i = 0; i < count; i++) {
+jfloat pair[2];
+env->GetFloatArrayRegion(frequencies, i, 1, &pair[0]);
+env->GetFloatArrayRegion(gains, i, 1, &pair[1]);
+memcpy(payload + sizeof(points) + (size_t)i * sizeof(pair), pair, sizeof(pair));
+}
+return setHeadphoneCurve(g_context, payload, (uint32_t)(sizeof(points) + (size_t)count * 2 * sizeof(float)));
 }
 
 JNIEXPORT jfloat JNICALL
@@ -164,6 +873,18 @@ switch (param_id) {
 case PARAM_INTENSITY: return g_context->intensity;
 case PARAM_SPATIAL_WIDTH: return g_context->spatialWidth;
 case PARAM_DISTANCE: return g_context->distance;
+case PARAM_PRESET: return (float)g_context->preset;
+case PARAM_STAGE_MASK: return (float)g_context->stageMask;
+case PARAM_QUALITY_TIER: return (float)g_context->qualityTier;
+case PARAM_QUALITY_AUTO: return g_context->autoQuality ? 1.0f : 0.0f;
+case PARAM_EQ_MODE: return (float)g_context->eqMode;
+case PARAM_EQ_PARTITION: return (float)g_context->eqPartition;
+case PARAM_EQ_LATENCY: return (float)firLatency(g_context);
+case PARAM_HRTF_MODE: return g_context->hrtf ? 1.0f : 0.0f;
+case PARAM_HRTF_AZIMUTH: return g_context->hrtfAzimuth;
+case PARAM_HRTF_ELEVATION: return g_context->hrtfElevation;
+case PARAM_HRTF_GRID_BYTES: return (float)g_context->binauralProcessor->getHrtfGridBytes();
+case PARAM_HRTF_CACHE_BYTES: return (float)g_context->binauralProcessor->getHrtfCacheBytes();
 default: return 0.0f;
 }
 }
@@ -175,54 +896,319 @@ g_context->enabled = enabled;
 }
 }
 
+// Flattened per-stage reports (NUM_DSP_STAGES x 5 floats) followed by the
+// callback report (7 floats); the layout is mirrored in CafeModeDSP.kt.
+JNIEXPORT jfloatArray JNICALL
+Java_com_cafetone_audio_dsp_CafeModeDSP_nativeGetStageStats(JNIEnv *env, [[maybe_unused]] jobject thiz) {
+const int stageFloats = sizeof(DspStageReport) / sizeof(float);
+const int callbackFloats = sizeof(DspCallbackReport) / sizeof(float);
+float values[NUM_DSP_STAGES * stageFloats + callbackFloats] = {};
+if (g_context != nullptr) {
+for (int stage = 0; stage < NUM_DSP_STAGES; stage++) {
+DspStageReport report = g_context->stats.stageReport(stage);
+memcpy(&values[stage * stageFloats], &report, sizeof(report));
+}
+DspCallbackReport callback = g_context->stats.callbackReport();
+memcpy(&values[NUM_DSP_STAGES * stageFloats], &callback, sizeof(callback));
+}
+const jsize count = (jsize)(sizeof(values) / sizeof(values[0]));
+jfloatArray result = env->NewFloatArray(count);
+if (result != nullptr) {
+env->SetFloatArrayRegion(result, 0, count, values);
+}
+return result;
+}
+
+// QualityReport as 6 floats; the layout is mirrored in CafeModeDSP.kt.
+JNIEXPORT jfloatArray JNICALL
+Java_com_cafetone_audio_dsp_CafeModeDSP_nativeGetQualityStatus(JNIEnv *env, [[maybe_unused]] jobject thiz) {
+QualityReport report{};
+if (g_context != nullptr) {
+report = g_context->quality.report();
+}
+const jsize count = (jsize)(sizeof(report) / sizeof(float));
+jfloatArray result = env->NewFloatArray(count);
+if (result != nullptr) {
+env->SetFloatArrayRegion(result, 0, count, reinterpret_cast<const jfloat*>(&report));
+}
+return result;
+}
+
+JNIEXPORT void JNICALL
+Java_com_cafetone_audio_dsp_CafeModeDSP_nativeResetStageStats([[maybe_unused]] JNIEnv *env, [[maybe_unused]] jobject thiz) {
+if (g_context != nullptr) {
+g_context->stats.requestReset();
+}
+}
+#endif // __ANDROID__
+
 } // extern "C"
 
+// Runs one stage from in to out (which may alias) under its stage-mask
+// crossfade. Fully masked stages are skipped and their input passed on; a
+// stage that is fading is blended with its input, per sample.
+template <typename Stage>
+static void runStage(CafeModeContext* ctx, int stage, Stage* processor, const float* inL, const float* inR,
+                     float* outL, float* outR, int frames) {
+    const int index = stage - STAGE_EQ;
+    SmoothedParam& mix = ctx->stageMix[index];
+    if (mix.isSteady() && mix.value() == 0.0f) {
+        ctx->stageStale[index] = true;
+        if (outL != inL) memcpy(outL, inL, (size_t)frames * sizeof(float));
+        if (outR != inR) memcpy(outR, inR, (size_t)frames * sizeof(float));
+        return;
+    }
+    if (ctx->stageStale[index]) {
+        processor->reset();
+        ctx->stageStale[index] = false;
+    }
+    if (mix.isSteady()) {
+        processor->process(inL, inR, outL, outR, frames);
+        return;
+    }
+
+    const float* srcL = inL;
+    const float* srcR = inR;
+    if (outL == inL) {
+        memcpy(ctx->fadeBuffer[0], inL, (size_t)frames * sizeof(float));
+        memcpy(ctx->fadeBuffer[1], inR, (size_t)frames * sizeof(float));
+        srcL = ctx->fadeBuffer[0];
+        srcR = ctx->fadeBuffer[1];
+    }
+    processor->process(inL, inR, outL, outR, frames);
+    const float gain = mix.value();
+    const float step = mix.advance(frames);
+    for (int i = 0; i < frames; i++) {
+        const float g = gain + step * (float)i;
+        outL[i] = srcL[i] + (outL[i] - srcL[i]) * g;
+        outR[i] = srcR[i] + (outR[i] - srcR[i]) * g;
+    }
+}
+
+// Runs the whole chain over one internal sub-block as a fused pipeline: the
+// PCM deinterleave, all five stages and the mix/clamp/PCM pack touch
+// only the two small tile buffers, which stay in L1 between stages instead
+// of streaming every intermediate result through memory. Processor state
+// (delay lines, filters, envelopes) lives in the processors, so consecutive
+// calls continue seamlessly across sub-block and callback boundaries.
+//
+// The mix short-circuits at its ends: at intensity 0, or with every stage
+// masked off, the stages do not run at all, and at 1 the input is
+// converted straight into the wet buffer and no dry copy or mix is made.
+// Ramps through either end still take the full path, so the switch is as
+// smooth as any other intensity change.
+// Returns true if the sub-block was skipped as silence.
+static bool processSubBlock(CafeModeContext* ctx, const void* in, void* out, int frames,
+                            int tailFrames, uint64_t* stageNs) {
+    uint64_t t0 = dspNowNs(), t1;
+
+    float* __restrict dryL = ctx->dryBuffer[0];
+    float* __restrict dryR = ctx->dryBuffer[1];
+    float* __restrict wetL = ctx->wetBuffer[0];
+    float* __restrict wetR = ctx->wetBuffer[1];
+    bool anyStage = false;
+    for (const SmoothedParam& mix : ctx->stageMix) anyStage = anyStage || !mix.isSteady() || mix.value() != 0.0f;
+    const bool dryOnly = !anyStage || (ctx->wetGain.isSteady() && ctx->wetGain.value() == 0.0f);
+    // With no stage running, intensity 1 still means the dry path
+    const bool wetOnly = !dryOnly && ctx->wetGain.isSteady() && ctx->wetGain.value() == 1.0f;
+    float* inL = wetOnly ? wetL : dryL;
+    float* inR = wetOnly ? wetR : dryR;
+
+    if (ctx->inputChannels > 2) {
+        ctx->downmix->process(in, ctx->inputFormat, inL, inR, frames);
+    } else {
+        deinterleaveStereo(in, ctx->inputFormat, inL, inR, frames);
+    }
+    const bool inputSilent = blockPeak(inL, inR, frames) <= CafeModeContext::SILENCE_THRESHOLD;
+    if (ctx->idle) {
+        if (inputSilent) {
+            // Silent in, nothing left in the tails: silent out.
+            if (!ctx->accumulate) {
+                memset(out, 0, (size_t)frames * pcmBytesPerSample(ctx->outputFormat) * 2);
+            }
+            stageNs[STAGE_INPUT_CONVERT] += dspNowNs() - t0;
+            return true;
+        }
+        ctx->idle = false;
+        ctx->quietFrames = 0;
+    }
+    if (!ctx->stateReady && !acquireChainState(ctx)) {
+        // No memory for the delay lines, or the command thread is preparing
+        // them: pass the input through dry.
+        interleaveStereo(inL, inR, out, ctx->outputFormat, frames, ctx->accumulate);
+        stageNs[STAGE_INPUT_CONVERT] += dspNowNs() - t0;
+        return false;
+    }
+    t1 = dspNowNs();
+    stageNs[STAGE_INPUT_CONVERT] += t1 - t0;
+
+    const int latency = wetLatency(ctx);
+    if (dryOnly) {
+        // Nothing of the wet path is heard. The stages restart from rest
+        // when intensity comes back, and their tails no longer matter.
+        for (bool& stale : ctx->stageStale) stale = true;
+        delayDry(ctx, dryL, dryR, frames, latency, false);
+        ctx->quietFrames = inputSilent ? std::min(ctx->quietFrames + frames, tailFrames) : 0;
+        ctx->idle = ctx->quietFrames >= tailFrames;
+        interleaveStereo(dryL, dryR, out, ctx->outputFormat, frames, ctx->accumulate);
+        stageNs[STAGE_OUTPUT_CONVERT] += dspNowNs() - t1;
+        return false;
+    }
+
+    // EQ reads the input copy and produces the wet buffer; every later stage
+    // then works in place. The dry copy is delayed to match once the EQ has
+    // read it (or only recorded, when there is none).
+    if (wetOnly) delayDry(ctx, inL, inR, frames, latency, true);
+    runStage(ctx, STAGE_EQ, ctx->eqProcessor.get(), inL, inR, wetL, wetR, frames);
+    if (!wetOnly) delayDry(ctx, dryL, dryR, frames, wetLatency(ctx), false);
+    t0 = dspNowNs();
+    stageNs[STAGE_EQ] += t0 - t1;
+
+    runStage(ctx, STAGE_HAAS, ctx->haasProcessor.get(), wetL, wetR, wetL, wetR, frames);
+    t1 = dspNowNs();
+    stageNs[STAGE_HAAS] += t1 - t0;
+
+    runStage(ctx, STAGE_BINAURAL, ctx->binauralProcessor.get(), wetL, wetR, wetL, wetR, frames);
+    t0 = dspNowNs();
+    stageNs[STAGE_BINAURAL] += t0 - t1;
+
+    runStage(ctx, STAGE_REVERB, ctx->reverbProcessor.get(), wetL, wetR, wetL, wetR, frames);
+    t1 = dspNowNs();
+    stageNs[STAGE_REVERB] += t1 - t0;
+
+    runStage(ctx, STAGE_DYNAMICS, ctx->dynamicProcessor.get(), wetL, wetR, wetL, wetR, frames);
+    t0 = dspNowNs();
+    stageNs[STAGE_DYNAMICS] += t0 - t1;
+
+    if (inputSilent && blockPeak(wetL, wetR, frames) <= CafeModeContext::SILENCE_THRESHOLD) {
+        ctx->quietFrames = std::min(ctx->quietFrames + frames, tailFrames);
+        ctx->idle = ctx->quietFrames >= tailFrames;
+    } else {
+        ctx->quietFrames = 0;
+    }
+
+    // The mix goes back into the wet buffer so the format-specific pack can
+    // run as one conversion loop.
+    if (!wetOnly) {
+        float wetGain = ctx->wetGain.value();
+        const float wetStep = ctx->wetGain.advance(frames);
+        if (wetStep == 0.0f) {
+            const float dryGain = 1.0f - wetGain;
+            for (int i = 0; i < frames; i++) {
+                wetL[i] = dryL[i] * dryGain + wetL[i] * wetGain;
+                wetR[i] = dryR[i] * dryGain + wetR[i] * wetGain;
+            }
+        } else {
+            for (int i = 0; i < frames; i++) {
+                const float g = wetGain + wetStep * (float)i;
+                wetL[i] = dryL[i] * (1.0f - g) + wetL[i] * g;
+                wetR[i] = dryR[i] * (1.0f - g) + wetR[i] * g;
+            }
+        }
+    }
+    interleaveStereo(wetL, wetR, out, ctx->outputFormat, frames, ctx->accumulate);
+    stageNs[STAGE_OUTPUT_CONVERT] += dspNowNs() - t0;
+    return false;
+}
+
+// Frees the delay lines once the chain has had nothing to do for the
+// configured time; the next non-silent block allocates them again.
+static void reclaimIdleState(CafeModeContext* ctx, int idleReclaimMs) {
+    if (!ctx->stateReady || idleReclaimMs <= 0) return;
+    if (ctx->idleRunFrames * 1000 >= (uint64_t)idleReclaimMs * (uint64_t)ctx->sampleRate) {
+        releaseChainState(ctx);
+    }
+}
+
 int32_t CafeMode_Process(effect_interface_t** self, audio_buffer_t* in, audio_buffer_t* out) {
     auto* ctx = reinterpret_cast<CafeModeContext*>(*self);
-    if (!ctx || !in || !out || !in->s16 || !out->s16 || in->frameCount == 0) {
+    if (!ctx || !in || !out || !in->raw || !out->raw || in->frameCount == 0) {
         return -EINVAL;
     }
+    // Decaying tails would otherwise end in subnormals; see DenormalGuard
+    const DenormalGuard denormals;
+
+    // Parameter changes land here, once per callback, never mid-block.
+    if (ctx->snapshots.fetch()) {
+        applySnapshot(ctx, ctx->snapshots.current());
+        if (!ctx->enabled || !ctx->primed || ctx->idle) snapParameters(ctx);
+    }
+    const ChainSnapshot& snapshot = ctx->snapshots.current();
 
-    auto start_time = std::chrono::high_resolution_clock::now();
+    const int totalFrames = (int)in->frameCount;
+    const uint64_t startNs = dspNowNs();
+    ctx->stats.beginCallback(startNs, totalFrames, ctx->sampleRate);
+
+    const int inFrameBytes = pcmBytesPerSample(ctx->inputFormat) * ctx->inputChannels;
+    const int outFrameBytes = pcmBytesPerSample(ctx->outputFormat) * 2;
+    const auto* inBytes = static_cast<const uint8_t*>(in->raw);
+    auto* outBytes = static_cast<uint8_t*>(out->raw);
+    if (in->raw == out->raw && outFrameBytes > inFrameBytes) {
+        // In place with a wider output frame (s16 in, float out): each
+        // sub-block's output would land on input later sub-blocks have yet
+        // to read. The buffer holds the whole output, so move the input to
+        // its end first; the output then never catches up with it.
+        const size_t inputBytes = (size_t)totalFrames * inFrameBytes;
+        uint8_t* moved = outBytes + (size_t)totalFrames * outFrameBytes - inputBytes;
+        memmove(moved, in->raw, inputBytes);
+        inBytes = moved;
+    }
 
     if (!ctx->enabled) {
-        if (in->raw != out->raw) {
-            memcpy(out->raw, in->raw, in->frameCount * sizeof(int16_t) * 2);
+        if (ctx->inputFormat == ctx->outputFormat && ctx->inputChannels == 2 && !ctx->accumulate) {
+            if (in->raw != out->raw) {
+                memcpy(out->raw, in->raw, (size_t)totalFrames * inFrameBytes);
+            }
+        } else {
+            // Format change, downmix or accumulate still has to go through float.
+            for (int offset = 0; offset < totalFrames; offset += CafeModeContext::MAX_BLOCK_SIZE) {
+                int frames = std::min((int)CafeModeContext::MAX_BLOCK_SIZE, totalFrames - offset);
+                const uint8_t* src = inBytes + (size_t)offset * inFrameBytes;
+                if (ctx->inputChannels > 2) {
+                    ctx->downmix->process(src, ctx->inputFormat, ctx->dryBuffer[0], ctx->dryBuffer[1], frames);
+                } else {
+                    deinterleaveStereo(src, ctx->inputFormat, ctx->dryBuffer[0], ctx->dryBuffer[1], frames);
+                }
+                interleaveStereo(ctx->dryBuffer[0], ctx->dryBuffer[1], outBytes + (size_t)offset * outFrameBytes,
+                                 ctx->outputFormat, frames, ctx->accumulate);
+            }
         }
+        ctx->idleRunFrames += totalFrames;
+        reclaimIdleState(ctx, snapshot.idleReclaimMs);
+        ctx->stats.endCallback(dspNowNs() - startNs, totalFrames, ctx->sampleRate);
         return 0;
     }
 
-    int frames = std::min((size_t)CafeModeContext::MAX_BUFFER_SIZE, in->frameCount);
-
-    for (int i = 0; i < frames; i++) {
-        ctx->inputBuffer[0][i] = in->s16[i * 2] / 32768.0f;
-        ctx->inputBuffer[1][i] = in->s16[i * 2 + 1] / 32768.0f;
+    // Walk the host buffer in internal sub-blocks: deep-buffer and offload
+    // outputs can hand us far more than one block, and a small block keeps
+    // every stage's working set cache-resident regardless of the host size.
+    uint64_t stageNs[NUM_DSP_STAGES] = {};
+    const int blockSize = snapshot.blockSize;
+    const int tailFrames = chainTailFrames(ctx);
+    int idleFrames = 0;
+    for (int offset = 0; offset < totalFrames; offset += blockSize) {
+        int frames = std::min(blockSize, totalFrames - offset);
+        if (processSubBlock(ctx, inBytes + (size_t)offset * inFrameBytes, outBytes + (size_t)offset * outFrameBytes,
+                            frames, tailFrames, stageNs)) {
+            idleFrames += frames;
+        }
     }
+    ctx->primed = true;
+    ctx->stats.recordIdleFrames(idleFrames);
+    ctx->idleRunFrames = ctx->idle ? ctx->idleRunFrames + totalFrames : 0;
+    reclaimIdleState(ctx, snapshot.idleReclaimMs);
 
-    ctx->eqProcessor->process(ctx->inputBuffer[0], ctx->eqBuffer[0], frames);
-    ctx->eqProcessor->process(ctx->inputBuffer[1], ctx->eqBuffer[1], frames);
-    ctx->haasProcessor->process(ctx->eqBuffer[0], ctx->eqBuffer[1], ctx->haasBuffer[0], ctx->haasBuffer[1], frames);
-    ctx->binauralProcessor->process(ctx->haasBuffer[0], ctx->haasBuffer[1], ctx->binauralBuffer[0], ctx->binauralBuffer[1], frames);
-    ctx->reverbProcessor->process(ctx->binauralBuffer[0], ctx->binauralBuffer[1], ctx->reverbBuffer[0], ctx->reverbBuffer[1], frames);
-    ctx->dynamicProcessor->process(ctx->reverbBuffer[0], ctx->reverbBuffer[1], ctx->outputBuffer[0], ctx->outputBuffer[1], frames);
-
-    for (int i = 0; i < frames; i++) {
-        float dryLeft = ctx->inputBuffer[0][i];
-        float dryRight = ctx->inputBuffer[1][i];
-        float wetLeft = ctx->outputBuffer[0][i];
-        float wetRight = ctx->outputBuffer[1][i];
-        float finalLeft = dryLeft * (1.0f - ctx->intensity) + wetLeft * ctx->intensity;
-        float finalRight = dryRight * (1.0f - ctx->intensity) + wetRight * ctx->intensity;
-        out->s16[i * 2] = (int16_t)(std::clamp(finalLeft, -1.0f, 1.0f) * 32767.0f);
-        out->s16[i * 2 + 1] = (int16_t)(std::clamp(finalRight, -1.0f, 1.0f) * 32767.0f);
+    for (int stage = 0; stage < STAGE_TOTAL; stage++) {
+        ctx->stats.recordStage(stage, stageNs[stage], totalFrames);
     }
-
-    auto end_time = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time);
-
-    if (duration.count() > 10000) {
-        LOGE("Real-time constraint violated: %lld μs (target: <10,000 μs)", (long long)duration.count());
+    const uint64_t elapsedNs = dspNowNs() - startNs;
+    // Only callbacks that ran the chain say anything about the tier's cost
+    if (idleFrames < totalFrames && ctx->quality.update(elapsedNs, totalFrames, ctx->sampleRate)) {
+        applyQualityTier(ctx, snapshot.stageMask);
     }
+    // Overruns are counted, not logged: logging from the audio thread would
+    // only make a missed deadline worse.
+    ctx->stats.endCallback(elapsedNs, totalFrames, ctx->sampleRate);
 
     return 0;
 }
@@ -230,10 +1216,36 @@ int32_t CafeMode_Process(effect_interface_t** self, audio_buffer_t* in, audio_bu
 int32_t CafeMode_Command(effect_interface_t** self, uint32_t cmdCode, uint32_t cmdSize, void* pCmdData, uint32_t* replySize, void* pReplyData) {
     auto* ctx = reinterpret_cast<CafeModeContext*>(*self);
     if (!ctx) return -EINVAL;
+    prepareChainState(ctx);
 
     switch (cmdCode) {
+        case EFFECT_CMD_INIT:
+            if (!pReplyData || !replySize || *replySize < sizeof(int32_t)) return -EINVAL;
+            resetProcessors(ctx);
+            *(int32_t*)pReplyData = 0;
+            return 0;
+
+        case EFFECT_CMD_RESET:
+            resetProcessors(ctx);
+            return 0;
+
+        case EFFECT_CMD_SET_CONFIG:
+            if (!pCmdData || cmdSize != sizeof(effect_config_t) || !pReplyData || !replySize ||
+                *replySize < sizeof(int32_t)) {
+                return -EINVAL;
+            }
+            *(int32_t*)pReplyData = setConfig(ctx, (const effect_config_t*)pCmdData);
+            return 0;
+
+        case EFFECT_CMD_GET_CONFIG:
+            if (!pReplyData || !replySize || *replySize < sizeof(effect_config_t)) return -EINVAL;
+            memcpy(pReplyData, &ctx->config, sizeof(effect_config_t));
+            *replySize = sizeof(effect_config_t);
+            return 0;
+
         case EFFECT_CMD_ENABLE:
             LOGI("Sony Café Mode DSP enabled");
+            prefaultChainState(ctx);
             ctx->enabled = true;
             return 0;
 
@@ -246,29 +1258,16 @@ int32_t CafeMode_Command(effect_interface_t** self, uint32_t cmdCode, uint32_t c
             if (!pCmdData || cmdSize < 8 || !replySize || *replySize < 4) return -EINVAL;
             int32_t paramId = *(int32_t*)pCmdData;
             float value = *(float*)((char*)pCmdData + sizeof(int32_t));
-            *(int32_t*)pReplyData = 0;
-            switch (paramId) {
-                case PARAM_INTENSITY:
-                    ctx->intensity = std::clamp(value, 0.0f, 1.0f);
-                    LOGV("Sony Café Mode intensity set to: %.2f", ctx->intensity);
-                    break;
-                case PARAM_SPATIAL_WIDTH:
-                    ctx->spatialWidth = std::clamp(value, 0.0f, 1.0f);
-                    ctx->haasProcessor->setDelayAmount(ctx->spatialWidth * 20.0f);
-                    ctx->binauralProcessor->setSpatialWidth(1.0f + ctx->spatialWidth * 0.7f);
-                    LOGV("Sony Café Mode spatial width set to: %.2f", ctx->spatialWidth);
-                    break;
-                case PARAM_DISTANCE:
-                    ctx->distance = std::clamp(value, 0.0f, 1.0f);
-                    ctx->binauralProcessor->setDistance(ctx->distance);
-                    ctx->eqProcessor->setHighPassFilter(40.0f + ctx->distance * 160.0f);
-                    ctx->eqProcessor->setLowPassFilter(12000.0f - ctx->distance * 4000.0f);
-                    ctx->dynamicProcessor->setDistanceCompression(ctx->distance);
-                    LOGV("Sony Café Mode distance set to: %.2f", ctx->distance);
-                    break;
-                default:
-                    *(int32_t*)pReplyData = -EINVAL;
-                    LOGE("Unknown parameter ID: %d", paramId);
+            if (paramId == PARAM_STATS_RESET) {
+                ctx->stats.requestReset();
+                *(int32_t*)pReplyData = 0;
+            } else if (paramId == PARAM_HEADPHONE_CURVE) {
+                *(int32_t*)pReplyData = setHeadphoneCurve(ctx, (char*)pCmdData + sizeof(int32_t),
+                                                          cmdSize - sizeof(int32_t));
+                if (*(int32_t*)pReplyData != 0) LOGE("Headphone curve rejected");
+            } else {
+                *(int32_t*)pReplyData = setChainParameter(ctx, paramId, value);
+                if (*(int32_t*)pReplyData != 0) LOGE("Parameter %d rejected", paramId);
             }
             return 0;
         }
@@ -278,10 +1277,48 @@ int32_t CafeMode_Command(effect_interface_t** self, uint32_t cmdCode, uint32_t c
             int32_t paramId = *(int32_t*)pCmdData;
             float* valuePtr = (float*)((char*)pReplyData + sizeof(int32_t));
             *(int32_t*)pReplyData = 0;
+
+            if (paramId >= PARAM_STAGE_STATS_BASE && paramId < PARAM_STAGE_STATS_BASE + (int)NUM_DSP_STAGES) {
+                if (*replySize < sizeof(int32_t) + sizeof(DspStageReport)) return -EINVAL;
+                DspStageReport report = ctx->stats.stageReport(paramId - PARAM_STAGE_STATS_BASE);
+                memcpy(valuePtr, &report, sizeof(report));
+                *replySize = sizeof(int32_t) + sizeof(report);
+                return 0;
+            }
+            if (paramId == PARAM_CALLBACK_STATS) {
+                if (*replySize < sizeof(int32_t) + sizeof(DspCallbackReport)) return -EINVAL;
+                DspCallbackReport report = ctx->stats.callbackReport();
+                memcpy(valuePtr, &report, sizeof(report));
+                *replySize = sizeof(int32_t) + sizeof(report);
+                return 0;
+            }
+            if (paramId == PARAM_QUALITY_STATUS) {
+                if (*replySize < sizeof(int32_t) + sizeof(QualityReport)) return -EINVAL;
+                QualityReport report = ctx->quality.report();
+                memcpy(valuePtr, &report, sizeof(report));
+                *replySize = sizeof(int32_t) + sizeof(report);
+                return 0;
+            }
+
             switch (paramId) {
                 case PARAM_INTENSITY: *valuePtr = ctx->intensity; break;
                 case PARAM_SPATIAL_WIDTH: *valuePtr = ctx->spatialWidth; break;
                 case PARAM_DISTANCE: *valuePtr = ctx->distance; break;
+                case PARAM_BLOCK_SIZE: *valuePtr = (float)ctx->blockSize; break;
+                case PARAM_IDLE_RECLAIM_MS: *valuePtr = (float)ctx->idleReclaimMs; break;
+                case PARAM_PREFAULT: *valuePtr = (float)ctx->prefaultMode; break;
+                case PARAM_PRESET: *valuePtr = (float)ctx->preset; break;
+                case PARAM_STAGE_MASK: *valuePtr = (float)ctx->stageMask; break;
+                case PARAM_QUALITY_TIER: *valuePtr = (float)ctx->qualityTier; break;
+                case PARAM_QUALITY_AUTO: *valuePtr = ctx->autoQuality ? 1.0f : 0.0f; break;
+                case PARAM_EQ_MODE: *valuePtr = (float)ctx->eqMode; break;
+                case PARAM_EQ_PARTITION: *valuePtr = (float)ctx->eqPartition; break;
+                case PARAM_EQ_LATENCY: *valuePtr = (float)firLatency(ctx); break;
+                case PARAM_HRTF_MODE: *valuePtr = ctx->hrtf ? 1.0f : 0.0f; break;
+                case PARAM_HRTF_AZIMUTH: *valuePtr = ctx->hrtfAzimuth; break;
+                case PARAM_HRTF_ELEVATION: *valuePtr = ctx->hrtfElevation; break;
+                case PARAM_HRTF_GRID_BYTES: *valuePtr = (float)ctx->binauralProcessor->getHrtfGridBytes(); break;
+                case PARAM_HRTF_CACHE_BYTES: *valuePtr = (float)ctx->binauralProcessor->getHrtfCacheBytes(); break;
                 default: *(int32_t*)pReplyData = -EINVAL;
             }
             return 0;
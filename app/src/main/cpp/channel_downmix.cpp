@@ -0,0 +1,122 @@
+#include "channel_downmix.h"
+#include "audio_effect.h"
+#include "format_converter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+const float kMinus3dB = 0.70710678f;
+
+} // namespace
+
+ChannelDownmix::ChannelDownmix()
+        : m_sampleRate(48000)
+        , m_channels(0)
+        , m_taps{} {
+    reset();
+}
+
+bool ChannelDownmix::setLayout(uint32_t channelMask) {
+    if (channelMask != AUDIO_CHANNEL_OUT_5POINT1 && channelMask != AUDIO_CHANNEL_OUT_5POINT1_SIDE &&
+        channelMask != AUDIO_CHANNEL_OUT_7POINT1) {
+        return false;
+    }
+
+    // ITU-R BS.775 angles. With a single surround pair it sits at 110
+    // degrees whichever mask bits carry it; 7.1 splits into sides at 90 and
+    // backs at 150.
+    const bool sevenOne = channelMask == AUDIO_CHANNEL_OUT_7POINT1;
+    const float back = sevenOne ? 150.0f : 110.0f;
+    const float side = sevenOne ? 90.0f : 110.0f;
+    const struct {
+        uint32_t bit;
+        Tap tap;
+    } speakers[] = {
+        { AUDIO_CHANNEL_OUT_FRONT_LEFT, { PLACE_LEFT, -30.0f, 1.0f, {}, {} } },
+        { AUDIO_CHANNEL_OUT_FRONT_RIGHT, { PLACE_RIGHT, 30.0f, 1.0f, {}, {} } },
+        { AUDIO_CHANNEL_OUT_FRONT_CENTER, { PLACE_BOTH, 0.0f, kMinus3dB, {}, {} } },
+        { AUDIO_CHANNEL_OUT_LOW_FREQUENCY, { PLACE_BOTH, 0.0f, 0.5f, {}, {} } },
+        { AUDIO_CHANNEL_OUT_BACK_LEFT, { PLACE_BINAURAL, -back, kMinus3dB, {}, {} } },
+        { AUDIO_CHANNEL_OUT_BACK_RIGHT, { PLACE_BINAURAL, back, kMinus3dB, {}, {} } },
+        { AUDIO_CHANNEL_OUT_SIDE_LEFT, { PLACE_BINAURAL, -side, kMinus3dB, {}, {} } },
+        { AUDIO_CHANNEL_OUT_SIDE_RIGHT, { PLACE_BINAURAL, side, kMinus3dB, {}, {} } },
+    };
+
+    // Interleaved channel order is ascending mask bit order.
+    m_channels = 0;
+    for (const auto& speaker : speakers) {
+        if (channelMask & speaker.bit) m_taps[m_channels++] = speaker.tap;
+    }
+    updateTaps();
+    reset();
+    return true;
+}
+
+void ChannelDownmix::setSampleRate(int sampleRate) {
+    m_sampleRate = sampleRate;
+    updateTaps();
+}
+
+void ChannelDownmix::reset() {
+    memset(m_history, 0, sizeof(m_history));
+}
+
+void ChannelDownmix::process(const void* input, int format, float* left, float* right, int frames) {
+    frames = std::min(frames, (int)MAX_BLOCK_SIZE);
+
+    float* planes[MAX_CHANNELS];
+    for (int c = 0; c < m_channels; c++) planes[c] = m_history[c] + MAX_DELAY_SAMPLES;
+    deinterleave(input, format, m_channels, planes, frames);
+
+    memset(left, 0, frames * sizeof(float));
+    memset(right, 0, frames * sizeof(float));
+    float* outputs[2] = { left, right };
+    for (int c = 0; c < m_channels; c++) {
+        const Tap& tap = m_taps[c];
+        for (int ear = 0; ear < 2; ear++) {
+            const float gain = tap.gain[ear];
+            if (gain == 0.0f) continue;
+            const float* __restrict src = planes[c] - tap.delay[ear];
+            float* __restrict dst = outputs[ear];
+            for (int i = 0; i < frames; i++) {
+                dst[i] += src[i] * gain;
+            }
+        }
+        // Keep the newest MAX_DELAY_SAMPLES as history for the next block.
+        memmove(m_history[c], m_history[c] + frames, MAX_DELAY_SAMPLES * sizeof(float));
+    }
+}
+
+void ChannelDownmix::updateTaps() {
+    for (int c = 0; c < m_channels; c++) {
+        Tap& tap = m_taps[c];
+        tap.delay[0] = tap.delay[1] = 0;
+        switch (tap.placement) {
+            case PLACE_LEFT:
+                tap.gain[0] = tap.level;
+                tap.gain[1] = 0.0f;
+                break;
+            case PLACE_RIGHT:
+                tap.gain[0] = 0.0f;
+                tap.gain[1] = tap.level;
+                break;
+            case PLACE_BOTH:
+                tap.gain[0] = tap.gain[1] = tap.level;
+                break;
+            case PLACE_BINAURAL: {
+                // Same cues as BinauralProcessor::updateHRTFCoeffs at 0 elevation.
+                float azimuthRad = tap.azimuth * (float)M_PI / 180.0f;
+                float itdMs = fabsf(sinf(azimuthRad)) * 0.8f;
+                int itdSamples = std::clamp((int)(itdMs * m_sampleRate / 1000.0f), 0, MAX_DELAY_SAMPLES - 1);
+                float farGain = 1.0f - fabsf(tap.azimuth) / 180.0f * 0.4f;
+                int nearEar = tap.azimuth < 0.0f ? 0 : 1;
+                tap.gain[nearEar] = tap.level;
+                tap.gain[1 - nearEar] = tap.level * farGain;
+                tap.delay[1 - nearEar] = itdSamples;
+                break;
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef CHANNEL_DOWNMIX_H
+#define CHANNEL_DOWNMIX_H
+
+#include <cstdint>
+
+// Folds 5.1 / 7.1 input into the stereo pair the chain runs on.
+//
+// Every input channel becomes one row of a gain/delay matrix: front left and
+// right pass straight through, the centre and LFE are split equally, and the
+// surround channels are placed at their real speaker angle with the same
+// ITD (0.8 ms * sin(azimuth)) and ILD (-40% at 180 degrees) model the
+// binaural stage uses for rear positioning. The far ear gets the delayed,
+// attenuated copy. Each matrix entry is a plain multiply-add over a
+// contiguous block, so the cost grows linearly with the channel count.
+class ChannelDownmix {
+public:
+    static const int MAX_CHANNELS = 8;
+    static const int MAX_BLOCK_SIZE = 1024;
+
+    ChannelDownmix();
+
+    // Accepts 5.1 (back or side surrounds) and 7.1 masks; returns false and
+    // leaves the current layout untouched for anything else.
+    bool setLayout(uint32_t channelMask);
+    void setSampleRate(int sampleRate);
+    void reset();
+
+    int getChannelCount() const { return m_channels; }
+
+    // Interleaved PCM in the given AUDIO_FORMAT_PCM_* -> planar stereo.
+    // frames must not exceed MAX_BLOCK_SIZE.
+    void process(const void* input, int format, float* left, float* right, int frames);
+
+private:
+    // Covers the 0.8 ms maximum ITD up to 192 kHz.
+    static const int MAX_DELAY_SAMPLES = 256;
+
+    enum Placement {
+        PLACE_LEFT,         // straight to the left ear
+        PLACE_RIGHT,
+        PLACE_BOTH,         // equal split, no delay (centre, LFE)
+        PLACE_BINAURAL      // ITD/ILD for the speaker's azimuth
+    };
+
+    struct Tap {
+        Placement placement;
+        float azimuth;      // degrees, negative = left
+        float level;        // downmix level before the binaural cues
+        float gain[2];
+        int delay[2];
+    };
+
+    int m_sampleRate;
+    int m_channels;
+    Tap m_taps[MAX_CHANNELS];
+
+    // Per channel: MAX_DELAY_SAMPLES of history followed by the current block.
+    float m_history[MAX_CHANNELS][MAX_DELAY_SAMPLES + MAX_BLOCK_SIZE];
+
+    void updateTaps();
+};
+
+#endif // CHANNEL_DOWNMIX_H
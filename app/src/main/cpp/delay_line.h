@@ -0,0 +1,162 @@
+#ifndef DELAY_LINE_H
+#define DELAY_LINE_H
+
+#include "audio_processor.h"
+#include <algorithm>
+#include <cstring>
+
+// An integer delay time that changes without clicks: the new delay fades in
+// while the old one fades out over the usual parameter ramp. A change that
+// arrives mid-fade waits for it to finish (only the latest one is kept), so
+// no more than two taps are ever mixed.
+//
+// Per block, like SmoothedParam: beginBlock() returns the taps to mix and
+// the fade between them, with a per-sample increment that is exactly zero
+// once the delay is steady (then previous == delay and fade == 1).
+class DelayTap {
+public:
+    struct Block {
+        int delay;
+        int previous;
+        float fade;   // weight of delay against previous
+        float step;
+    };
+
+    explicit DelayTap(int delay = 1) : m_delay(delay), m_previous(delay), m_target(delay), m_fade(1.0f) {}
+
+    void setTarget(int delay, int rampFrames) {
+        m_target = delay;
+        m_rampFrames = rampFrames;
+        if (m_fade.isSteady()) start();
+    }
+
+    void snap() {
+        m_delay = m_previous = m_target;
+        m_fade = SmoothedParam(1.0f);
+    }
+
+    int delay() const { return m_delay; }
+    int target() const { return m_target; }
+    bool isSteady() const { return m_fade.isSteady() && m_target == m_delay; }
+
+    Block beginBlock(int frames) {
+        Block block = { m_delay, m_previous, m_fade.value(), m_fade.advance(frames) };
+        if (m_fade.isSteady()) {
+            m_previous = m_delay;
+            start();
+        }
+        return block;
+    }
+
+private:
+    void start() {
+        if (m_target == m_delay) return;
+        m_previous = m_delay;
+        m_delay = m_target;
+        m_fade = SmoothedParam(0.0f);
+        m_fade.setTarget(1.0f, m_rampFrames);
+    }
+
+    int m_delay;
+    int m_previous;
+    int m_target;
+    int m_rampFrames = 0;
+    SmoothedParam m_fade;
+};
+
+// Circular buffer of N samples, N a power of two, so wrapping is a mask
+// instead of a modulo. The line does not own its memory: processors point
+// it at their arena state (or a member array) with setStorage().
+//
+// Delays count back from the write position: tap(d) read before write(x)
+// returns the input from d samples ago, so tap(1) is the previous sample and
+// tap(N) (equally tap(0)) the oldest one, about to be overwritten.
+template <int N>
+class DelayLine {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "DelayLine size must be a power of two");
+
+public:
+    static const int SIZE = N;
+    static const int MASK = N - 1;
+    static constexpr size_t STATE_BYTES = N * sizeof(float);
+
+    // Up to two contiguous pieces of the buffer, split where it wraps.
+    struct Spans {
+        const float* first;
+        int firstFrames;
+        const float* second;   // continues first, from the start of the buffer
+        int secondFrames;
+    };
+
+    void setStorage(float* storage) { m_buffer = storage; }
+    bool hasStorage() const { return m_buffer != nullptr; }
+
+    void clear() {
+        if (m_buffer) memset(m_buffer, 0, STATE_BYTES);
+        m_position = 0;
+    }
+
+    void write(float input) {
+        m_buffer[m_position] = input;
+        m_position = (m_position + 1) & MASK;
+    }
+
+    // frames <= N
+    void write(const float* input, int frames) {
+        const int first = std::min(frames, N - m_position);
+        memcpy(m_buffer + m_position, input, first * sizeof(float));
+        memcpy(m_buffer, input + first, (frames - first) * sizeof(float));
+        m_position = (m_position + frames) & MASK;
+    }
+
+    float tap(int delay) const { return m_buffer[(m_position - delay) & MASK]; }
+
+    // `frames` consecutive samples, the first of them `delay` back. Read
+    // before writing a block, frames <= delay keeps to the past; after
+    // writing it, tap the block itself at delay + frames.
+    Spans spans(int delay, int frames) const {
+        const int start = (m_position - delay) & MASK;
+        const int first = std::min(frames, N - start);
+        return { m_buffer + start, first, m_buffer, frames - first };
+    }
+
+    void read(int delay, float* output, int frames) const {
+        const Spans s = spans(delay, frames);
+        memcpy(output, s.first, s.firstFrames * sizeof(float));
+        memcpy(output + s.firstFrames, s.second, s.secondFrames * sizeof(float));
+    }
+
+    // A DelayTap's current mix; advance block.fade by block.step per sample.
+    float tap(const DelayTap::Block& block) const {
+        const float from = tap(block.previous);
+        return from + (tap(block.delay) - from) * block.fade;
+    }
+
+    // Fractional delay by a first-order Thiran allpass, 1.5 <= delay <= N - 1:
+    // flat magnitude, and a group delay equal to `delay` at DC. Keeps one
+    // AllpassState per tap, so read it exactly once per sample.
+    struct AllpassState {
+        float previous = 0.0f;
+    };
+
+    float tapAllpass(float delay, AllpassState& state) const {
+        int whole = (int)delay;
+        float fraction = delay - (float)whole;
+        // Move the fractional part into [0.5, 1.5), where the coefficient
+        // stays within (-0.2, 1/3] and the pole well inside the unit circle
+        if (fraction < 0.5f) {
+            whole--;
+            fraction += 1.0f;
+        }
+        const float coeff = (1.0f - fraction) / (1.0f + fraction);
+        const float output = tap(whole + 1) + coeff * (tap(whole) - state.previous);
+        state.previous = output;
+        return output;
+    }
+
+private:
+    float* m_buffer = nullptr;
+    int m_position = 0;
+};
+
+#endif // DELAY_LINE_H
@@ -0,0 +1,63 @@
+#ifndef DENORMAL_GUARD_H
+#define DENORMAL_GUARD_H
+
+#include <cstdint>
+
+// Flushes subnormal floats to zero for as long as it is in scope, and puts
+// the caller's floating-point mode back on the way out.
+//
+// Every recursive stage in the chain (the EQ cascade, the reverb loop, the
+// dynamics envelopes) decays towards zero once its input goes silent, and
+// spends the last few hundred dB of that decay in subnormals, which cost
+// tens to hundreds of cycles per operation on both x86 and ARM cores. The
+// audio that far down is inaudible; flushing it costs nothing.
+//
+// x86 sets FTZ and DAZ in MXCSR; arm64 sets FZ in FPCR and armv7 FZ in
+// FPSCR, which on ARM covers both results and inputs. Other targets are
+// left as they are.
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
+
+class DenormalGuard {
+public:
+    DenormalGuard() {
+#if defined(__SSE2__) || defined(_M_X64)
+        m_saved = _mm_getcsr();
+        _mm_setcsr(m_saved | FTZ_DAZ);
+#elif defined(__aarch64__)
+        uint64_t fpcr;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(fpcr));
+        m_saved = fpcr;
+        fpcr |= ARM_FZ;
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(fpcr));
+#elif defined(__arm__) && defined(__ARM_FP)
+        uint32_t fpscr;
+        __asm__ __volatile__("vmrs %0, fpscr" : "=r"(fpscr));
+        m_saved = fpscr;
+        fpscr |= ARM_FZ;
+        __asm__ __volatile__("vmsr fpscr, %0" : : "r"(fpscr));
+#endif
+    }
+
+    ~DenormalGuard() {
+#if defined(__SSE2__) || defined(_M_X64)
+        _mm_setcsr((unsigned int)m_saved);
+#elif defined(__aarch64__)
+        __asm__ __volatile__("msr fpcr, %0" : : "r"(m_saved));
+#elif defined(__arm__) && defined(__ARM_FP)
+        __asm__ __volatile__("vmsr fpscr, %0" : : "r"((uint32_t)m_saved));
+#endif
+    }
+
+    DenormalGuard(const DenormalGuard&) = delete;
+    DenormalGuard& operator=(const DenormalGuard&) = delete;
+
+private:
+    static const unsigned int FTZ_DAZ = 0x8040;     // MXCSR bits 15 and 6
+    static const uint32_t ARM_FZ = 1u << 24;        // FPCR / FPSCR
+    uint64_t m_saved = 0;
+};
+
+#endif // DENORMAL_GUARD_H
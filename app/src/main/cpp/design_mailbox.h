@@ -0,0 +1,70 @@
+#ifndef DESIGN_MAILBOX_H
+#define DESIGN_MAILBOX_H
+
+#include <atomic>
+#include <memory>
+
+// Hands designs of type T from the command thread to the audio thread and
+// back without blocking or freeing on the audio thread. post() queues the
+// newest design (dropping one the audio thread has not taken yet), take()
+// picks it up, and retire() returns a design the audio thread no longer
+// uses, which the command thread frees on its next post() or collect().
+//
+// The audio thread holds at most two designs, the active one and one it is
+// crossfading from, and every take() displaces exactly one of them. The
+// way back has a slot for each, and take() only waits for a free one: a
+// design posted after the last collect() finds at most the one retire its
+// predecessor's crossfade made since, so it is never held up.
+template <typename T>
+class DesignMailbox {
+public:
+    DesignMailbox() = default;
+    ~DesignMailbox() {
+        delete m_pending.load();
+        collect();
+    }
+    DesignMailbox(const DesignMailbox&) = delete;
+    DesignMailbox& operator=(const DesignMailbox&) = delete;
+
+    // Command thread.
+    void post(std::unique_ptr<T> design) {
+        collect();
+        // Never picked up by the audio thread: ours to free
+        delete m_pending.exchange(design.release(), std::memory_order_acq_rel);
+    }
+
+    void collect() {
+        for (std::atomic<T*>& slot : m_retired) delete slot.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    // Audio thread. nullptr if nothing is queued, or if both retired slots
+    // still wait for collect() and the design take() displaces would have
+    // nowhere to go.
+    T* take() {
+        if (!m_pending.load(std::memory_order_relaxed) || !hasFreeSlot()) return nullptr;
+        return m_pending.exchange(nullptr, std::memory_order_acq_rel);
+    }
+
+    // Audio thread: once per design a take() displaced.
+    void retire(T* design) {
+        for (std::atomic<T*>& slot : m_retired) {
+            if (!slot.load(std::memory_order_acquire)) {
+                slot.store(design, std::memory_order_release);
+                return;
+            }
+        }
+    }
+
+private:
+    bool hasFreeSlot() const {
+        for (const std::atomic<T*>& slot : m_retired) {
+            if (!slot.load(std::memory_order_acquire)) return true;
+        }
+        return false;
+    }
+
+    std::atomic<T*> m_pending{ nullptr };
+    std::atomic<T*> m_retired[2]{};
+};
+
+#endif // DESIGN_MAILBOX_H
@@ -0,0 +1,49 @@
+#include "distance_table.h"
+#include "session_registry.h"
+#include <algorithm>
+
+namespace {
+
+float lerp(float a, float b, float t) {
+    return a + (b - a) * t;
+}
+
+Biquad lerp(const Biquad& a, const Biquad& b, float t) {
+    Biquad section;
+    section.b0 = lerp(a.b0, b.b0, t);
+    section.b1 = lerp(a.b1, b.b1, t);
+    section.b2 = lerp(a.b2, b.b2, t);
+    section.a1 = lerp(a.a1, b.a1, t);
+    section.a2 = lerp(a.a2, b.a2, t);
+    return section;
+}
+
+} // namespace
+
+DistanceTable::DistanceTable(int sampleRate) : m_sampleRate(sampleRate) {
+    for (int i = 0; i < POINTS; i++) {
+        float distance = (float)i / (float)(POINTS - 1);
+        m_eq[i] = EQProcessor::designCoeffs(highPassFreq(distance), lowPassFreq(distance), sampleRate);
+    }
+}
+
+std::shared_ptr<const DistanceTable> DistanceTable::forRate(int sampleRate) {
+    return SessionRegistry::acquire<DistanceTable>(SessionRegistry::TABLE_DISTANCE_COEFFS, sampleRate,
+                                                   [sampleRate]() { return new DistanceTable(sampleRate); });
+}
+
+EQProcessor::Coeffs DistanceTable::eq(float distance) const {
+    float position = std::clamp(distance, 0.0f, 1.0f) * (float)(POINTS - 1);
+    int index = std::min((int)position, POINTS - 2);
+    float t = position - (float)index;
+    if (t == 0.0f) return m_eq[index];
+
+    const EQProcessor::Coeffs& a = m_eq[index];
+    const EQProcessor::Coeffs& b = m_eq[index + 1];
+    EQProcessor::Coeffs coeffs;
+    coeffs.highPassFreq = lerp(a.highPassFreq, b.highPassFreq, t);
+    coeffs.lowPassFreq = lerp(a.lowPassFreq, b.lowPassFreq, t);
+    coeffs.highPass = lerp(a.highPass, b.highPass, t);
+    coeffs.lowPass = lerp(a.lowPass, b.lowPass, t);
+    return coeffs;
+}
@@ -0,0 +1,42 @@
+#ifndef DISTANCE_TABLE_H
+#define DISTANCE_TABLE_H
+
+#include "eq_processor.h"
+#include <memory>
+
+// The EQ roll-off designs for the whole distance range at one sample rate,
+// POINTS evenly spaced values from 0 to 1. A distance change, which a
+// slider delivers in bursts, is then an interpolation between two entries
+// instead of two biquad designs with their trig. Interpolating biquads
+// coefficient by coefficient stays stable for the same reason as the
+// processor's own ramps (see BiquadRamp), and the cutoffs move linearly
+// with distance, so neighbouring entries differ by about 1 Hz at the
+// high-pass and 30 Hz at the low-pass.
+//
+// Built on first use for each rate and shared through the SessionRegistry,
+// so every rate the effect accepts has one, not only a precompiled few.
+// The other distance-driven parameters (binaural attenuation, dynamics
+// compression) are a few multiplies and need no table.
+class DistanceTable {
+public:
+    static const int POINTS = 128;
+
+    // Command thread; takes the registry mutex.
+    static std::shared_ptr<const DistanceTable> forRate(int sampleRate);
+
+    // The distance-to-cutoff mapping the chain uses.
+    static float highPassFreq(float distance) { return 40.0f + distance * 160.0f; }
+    static float lowPassFreq(float distance) { return 12000.0f - distance * 4000.0f; }
+
+    int sampleRate() const { return m_sampleRate; }
+    // Exact at the table points, linearly interpolated between them.
+    EQProcessor::Coeffs eq(float distance) const;
+
+private:
+    explicit DistanceTable(int sampleRate);
+
+    int m_sampleRate;
+    EQProcessor::Coeffs m_eq[POINTS];
+};
+
+#endif // DISTANCE_TABLE_H
@@ -0,0 +1,73 @@
+#include "dsp_arena.h"
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdint>
+
+// Linux 5.14; older headers (and kernels) lack it, the call then fails with
+// EINVAL and callers fall back to faulting on first touch.
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+
+DspArena::~DspArena() {
+    if (m_base) {
+        munmap(m_base, m_capacity);
+    }
+}
+
+size_t DspArena::pageSize() {
+    static const size_t size = (size_t)sysconf(_SC_PAGESIZE);
+    return size;
+}
+
+bool DspArena::reserve(size_t capacity) {
+    if (m_base) return false;
+    capacity = alignUp(capacity, pageSize());
+    void* base = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return false;
+    m_base = static_cast<char*>(base);
+    m_capacity = capacity;
+    m_used = 0;
+    return true;
+}
+
+void* DspArena::allocate(size_t bytes) {
+    size_t offset = alignUp(m_used);
+    if (!m_base || offset + bytes > m_capacity) return nullptr;
+    m_used = offset + bytes;
+    return m_base + offset;
+}
+
+void DspArena::alignToPage() {
+    m_used = alignUp(m_used, pageSize());
+}
+
+bool DspArena::populate(void* data, size_t bytes) {
+    uintptr_t start = (uintptr_t)data & ~(pageSize() - 1);
+    uintptr_t end = alignUp((uintptr_t)data + bytes, pageSize());
+    return madvise((void*)start, end - start, MADV_POPULATE_WRITE) == 0;
+}
+
+void DspArena::discard(void* data, size_t bytes) {
+    // Only pages entirely inside the range; neighbours keep their contents
+    uintptr_t start = alignUp((uintptr_t)data, pageSize());
+    uintptr_t end = ((uintptr_t)data + bytes) & ~(pageSize() - 1);
+    if (end > start) {
+        madvise((void*)start, end - start, MADV_DONTNEED);
+    }
+}
+
+bool DspArena::lock() {
+    if (!m_base) return false;
+    if (!m_locked) {
+        m_locked = mlock(m_base, m_capacity) == 0;
+    }
+    return m_locked;
+}
+
+void DspArena::unlock() {
+    if (m_locked) {
+        munlock(m_base, m_capacity);
+        m_locked = false;
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef DSP_ARENA_H
+#define DSP_ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+// One contiguous, page-backed block per effect instance. The context, every
+// processor and the delay lines are placed in it back to back in processing
+// order, each on a 64-byte (cache line, widest SIMD load) boundary, so one
+// callback walks a single mapping front to back instead of six scattered
+// heap blocks.
+//
+// The block comes straight from anonymous mmap: untouched pages cost no
+// memory, and discard() hands pages back to the kernel while keeping the
+// address range. Objects are bump-allocated and never freed individually;
+// the whole block goes away with the arena.
+class DspArena {
+public:
+    static const size_t ALIGNMENT = 64;
+
+    // How delay-line pages are brought in before the audio thread needs them.
+    enum PrefaultMode {
+        PREFAULT_NONE,        // first touch on the audio thread faults them in
+        PREFAULT_POPULATE,    // populated from the command thread on enable and after reclaim
+        PREFAULT_LOCK,        // whole arena locked resident (mlock)
+    };
+
+    DspArena() = default;
+    ~DspArena();
+    DspArena(DspArena&& other) noexcept { swap(other); }
+    DspArena& operator=(DspArena&& other) noexcept { swap(other); return *this; }
+    DspArena(const DspArena&) = delete;
+    DspArena& operator=(const DspArena&) = delete;
+
+    // Maps capacity bytes (rounded up to whole pages) of zeroed memory.
+    bool reserve(size_t capacity);
+
+    // Next ALIGNMENT-aligned bytes, or nullptr once the arena is full.
+    void* allocate(size_t bytes);
+    // Starts the next allocation on a fresh page, so what follows can be
+    // discarded without touching what came before.
+    void alignToPage();
+
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(alignof(T) <= ALIGNMENT, "over-aligned type");
+        void* storage = allocate(sizeof(T));
+        return storage ? new (storage) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    // Deleter for objects placed with create(): runs the destructor only,
+    // the memory belongs to the arena.
+    struct Destroy {
+        template <typename T>
+        void operator()(T* object) const { object->~T(); }
+    };
+
+    // Faults the pages of [data, data + bytes) in without changing their
+    // contents, so it is safe next to a running audio thread. Returns false
+    // if the kernel cannot do that (no MADV_POPULATE_WRITE).
+    static bool populate(void* data, size_t bytes);
+    // Drops the whole pages inside [data, data + bytes); they read back as
+    // zero and are faulted in again on the next touch. A no-op on locked pages.
+    static void discard(void* data, size_t bytes);
+
+    // mlock()s the whole arena, which also populates it. Fails under
+    // RLIMIT_MEMLOCK, in which case nothing is locked.
+    bool lock();
+    void unlock();
+    bool isLocked() const { return m_locked; }
+
+    size_t capacity() const { return m_capacity; }
+    size_t used() const { return m_used; }
+    static size_t pageSize();
+    static size_t alignUp(size_t bytes, size_t alignment = ALIGNMENT) {
+        return (bytes + alignment - 1) & ~(alignment - 1);
+    }
+
+private:
+    void swap(DspArena& other) noexcept {
+        std::swap(m_base, other.m_base);
+        std::swap(m_capacity, other.m_capacity);
+        std::swap(m_used, other.m_used);
+        std::swap(m_locked, other.m_locked);
+    }
+
+    char* m_base = nullptr;
+    size_t m_capacity = 0;
+    size_t m_used = 0;
+    bool m_locked = false;
+};
+
+#endif // DSP_ARENA_H
@@ -0,0 +1,45 @@
+#ifndef DSP_LOG_H
+#define DSP_LOG_H
+
+// Logging shim so the DSP chain builds both on-device (logcat) and on a
+// plain Linux host (stderr). Translation units define LOG_TAG before
+// including this header.
+
+#ifndef LOG_TAG
+#define LOG_TAG "CafeToneDSP"
+#endif
+
+#if defined(__ANDROID__)
+
+#include <android/log.h>
+
+#define LOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+#else
+
+#include <cstdio>
+
+// Host builds write to stderr. Tools raise the threshold to silence the
+// per-instance info messages (0 = verbose, 1 = info, 2 = warn, 3 = error).
+inline int gCafeToneHostLogLevel = 1;
+
+#define CAFETONE_HOST_LOG(level, prefix, ...)                   \
+    do {                                                        \
+        if ((level) >= gCafeToneHostLogLevel) {                 \
+            fprintf(stderr, "%s/%s: ", prefix, LOG_TAG);        \
+            fprintf(stderr, __VA_ARGS__);                       \
+            fputc('\n', stderr);                                \
+        }                                                       \
+    } while (0)
+
+#define LOGV(...) CAFETONE_HOST_LOG(0, "V", __VA_ARGS__)
+#define LOGI(...) CAFETONE_HOST_LOG(1, "I", __VA_ARGS__)
+#define LOGW(...) CAFETONE_HOST_LOG(2, "W", __VA_ARGS__)
+#define LOGE(...) CAFETONE_HOST_LOG(3, "E", __VA_ARGS__)
+
+#endif
+
+#endif // DSP_LOG_H
@@ -0,0 +1,181 @@
+#include "dsp_stats.h"
+#include <algorithm>
+#include <climits>
+#include <ctime>
+
+const char* dspStageName(int stage) {
+    switch (stage) {
+        case STAGE_INPUT_CONVERT: return "input_convert";
+        case STAGE_EQ: return "eq";
+        case STAGE_HAAS: return "haas";
+        case STAGE_BINAURAL: return "binaural";
+        case STAGE_REVERB: return "reverb";
+        case STAGE_DYNAMICS: return "dynamics";
+        case STAGE_OUTPUT_CONVERT: return "output_convert";
+        case STAGE_TOTAL: return "total";
+        default: return "unknown";
+    }
+}
+
+uint64_t dspNowNs() {
+    // CLOCK_MONOTONIC is served from the vDSO on Android and Linux, so this
+    // costs tens of nanoseconds and never enters the kernel.
+    timespec ts{};
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+DspStats::DspStats()
+    : m_resetRequested(false)
+    , m_lastCallbackNs(0)
+    , m_lastPeriodNs(0) {
+    resetCounters();
+}
+
+void DspStats::beginCallback(uint64_t nowNs, int frames, int sampleRate) {
+    if (m_resetRequested.load(std::memory_order_acquire)) {
+        resetCounters();
+        m_resetRequested.store(false, std::memory_order_release);
+    }
+
+    if (m_lastCallbackNs != 0) {
+        uint64_t interval = nowNs - m_lastCallbackNs;
+        uint64_t jitter = interval > m_lastPeriodNs ? interval - m_lastPeriodNs : m_lastPeriodNs - interval;
+        bump(m_intervalNsSum, interval);
+        bump(m_jitterNsSum, jitter);
+        if (jitter > m_maxJitterNs.load(std::memory_order_relaxed)) {
+            m_maxJitterNs.store(jitter, std::memory_order_relaxed);
+        }
+    }
+    m_lastCallbackNs = nowNs;
+    m_lastPeriodNs = sampleRate > 0 ? (uint64_t)frames * 1000000000ull / (uint64_t)sampleRate : 0;
+}
+
+void DspStats::recordStage(int stage, uint64_t elapsedNs, int frames) {
+    if (stage < 0 || stage >= NUM_DSP_STAGES || frames <= 0) return;
+    StageCounters& s = m_stages[stage];
+
+    uint64_t ps = elapsedNs * 1000ull / (uint64_t)frames;
+    uint32_t psPerFrame = (uint32_t)std::min<uint64_t>(ps, UINT32_MAX);
+
+    bump(s.calls, (uint64_t)1);
+    bump(s.frames, (uint64_t)frames);
+    bump(s.totalNs, elapsedNs);
+    if (psPerFrame < s.minPsPerFrame.load(std::memory_order_relaxed)) {
+        s.minPsPerFrame.store(psPerFrame, std::memory_order_relaxed);
+    }
+    if (psPerFrame > s.maxPsPerFrame.load(std::memory_order_relaxed)) {
+        s.maxPsPerFrame.store(psPerFrame, std::memory_order_relaxed);
+    }
+    bump(s.histogram[bucketIndex(psPerFrame)], 1u);
+}
+
+void DspStats::endCallback(uint64_t elapsedNs, int frames, int sampleRate) {
+    recordStage(STAGE_TOTAL, elapsedNs, frames);
+    bump(m_callbacks, (uint64_t)1);
+
+    if (sampleRate <= 0 || frames <= 0) return;
+    uint64_t periodNs = (uint64_t)frames * 1000000000ull / (uint64_t)sampleRate;
+    if (periodNs == 0) return;
+    if (elapsedNs > periodNs) bump(m_overruns, (uint64_t)1);
+    uint32_t load = (uint32_t)std::min<uint64_t>(elapsedNs * 1000ull / periodNs, UINT32_MAX);
+    if (load > m_maxLoadPermille.load(std::memory_order_relaxed)) {
+        m_maxLoadPermille.store(load, std::memory_order_relaxed);
+    }
+}
+
+void DspStats::recordIdleFrames(int frames) {
+    if (frames > 0) bump(m_idleFrames, (uint64_t)frames);
+}
+
+DspStageReport DspStats::stageReport(int stage) const {
+    DspStageReport report{};
+    if (stage < 0 || stage >= NUM_DSP_STAGES) return report;
+    const StageCounters& s = m_stages[stage];
+
+    uint64_t calls = s.calls.load(std::memory_order_relaxed);
+    if (calls == 0) return report;
+    uint64_t frames = s.frames.load(std::memory_order_relaxed);
+
+    report.calls = (float)calls;
+    report.minNsPerFrame = s.minPsPerFrame.load(std::memory_order_relaxed) / 1000.0f;
+    report.maxNsPerFrame = s.maxPsPerFrame.load(std::memory_order_relaxed) / 1000.0f;
+    report.meanNsPerFrame = frames > 0 ? (float)((double)s.totalNs.load(std::memory_order_relaxed) / frames) : 0.0f;
+
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        counts[i] = s.histogram[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    uint64_t target = (total * 99 + 99) / 100;
+    uint64_t cumulative = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        cumulative += counts[i];
+        if (cumulative >= target && counts[i] > 0) {
+            report.p99NsPerFrame = bucketMidpoint(i) / 1000.0f;
+            break;
+        }
+    }
+    // The bucket midpoint can overshoot the true extremes; keep it in range.
+    report.p99NsPerFrame = std::clamp(report.p99NsPerFrame, report.minNsPerFrame, report.maxNsPerFrame);
+    return report;
+}
+
+DspCallbackReport DspStats::callbackReport() const {
+    DspCallbackReport report{};
+    uint64_t callbacks = m_callbacks.load(std::memory_order_relaxed);
+    report.callbacks = (float)callbacks;
+    if (callbacks > 1) {
+        report.meanIntervalUs = (float)(m_intervalNsSum.load(std::memory_order_relaxed) / 1000.0 / (callbacks - 1));
+        report.meanJitterUs = (float)(m_jitterNsSum.load(std::memory_order_relaxed) / 1000.0 / (callbacks - 1));
+    }
+    report.maxJitterUs = m_maxJitterNs.load(std::memory_order_relaxed) / 1000.0f;
+    report.overruns = (float)m_overruns.load(std::memory_order_relaxed);
+    report.maxLoad = m_maxLoadPermille.load(std::memory_order_relaxed) / 1000.0f;
+    uint64_t frames = m_stages[STAGE_TOTAL].frames.load(std::memory_order_relaxed);
+    if (frames > 0) {
+        report.idleRatio = (float)((double)m_idleFrames.load(std::memory_order_relaxed) / frames);
+    }
+    return report;
+}
+
+void DspStats::requestReset() {
+    m_resetRequested.store(true, std::memory_order_release);
+}
+
+void DspStats::resetCounters() {
+    for (auto& s : m_stages) {
+        s.calls.store(0, std::memory_order_relaxed);
+        s.frames.store(0, std::memory_order_relaxed);
+        s.totalNs.store(0, std::memory_order_relaxed);
+        s.minPsPerFrame.store(UINT32_MAX, std::memory_order_relaxed);
+        s.maxPsPerFrame.store(0, std::memory_order_relaxed);
+        for (auto& bucket : s.histogram) bucket.store(0, std::memory_order_relaxed);
+    }
+    m_callbacks.store(0, std::memory_order_relaxed);
+    m_intervalNsSum.store(0, std::memory_order_relaxed);
+    m_jitterNsSum.store(0, std::memory_order_relaxed);
+    m_maxJitterNs.store(0, std::memory_order_relaxed);
+    m_overruns.store(0, std::memory_order_relaxed);
+    m_maxLoadPermille.store(0, std::memory_order_relaxed);
+    m_idleFrames.store(0, std::memory_order_relaxed);
+    m_lastCallbackNs = 0;
+    m_lastPeriodNs = 0;
+}
+
+int DspStats::bucketIndex(uint32_t value) {
+    if (value < 4) return (int)value;
+    int octave = 31 - __builtin_clz(value);
+    int sub = (int)(value >> (octave - 2)) - 4;
+    return octave * 4 + sub;
+}
+
+uint32_t DspStats::bucketMidpoint(int index) {
+    if (index < 4) return (uint32_t)index;
+    int octave = index / 4;
+    uint32_t sub = (uint32_t)(index % 4);
+    uint64_t lower = (uint64_t)(4 + sub) << (octave - 2);
+    uint64_t width = 1ull << (octave - 2);
+    return (uint32_t)std::min<uint64_t>(lower + width / 2, UINT32_MAX);
+}
@@ -0,0 +1,107 @@
+#ifndef DSP_STATS_H
+#define DSP_STATS_H
+
+#include <atomic>
+#include <cstdint>
+
+// Realtime budget instrumentation for CafeMode_Process.
+//
+// Costs are recorded in picoseconds per frame so the numbers stay comparable
+// across buffer sizes. Wall-clock time is used rather than CPU cycles: phone
+// cores change frequency under DVFS, and the deadline that matters is the
+// buffer period in wall-clock time.
+//
+// Threading: the audio thread is the only writer (plain relaxed load/store,
+// no read-modify-write), any other thread may read at any time. Readers can
+// observe fields from different callbacks, which is fine for statistics.
+// Resets are requested from the reader side and applied by the audio thread
+// at the start of its next callback.
+
+enum DspStage {
+    STAGE_INPUT_CONVERT = 0,   // PCM -> float deinterleave, 5.1/7.1 downmix
+    STAGE_EQ,
+    STAGE_HAAS,
+    STAGE_BINAURAL,
+    STAGE_REVERB,
+    STAGE_DYNAMICS,
+    STAGE_OUTPUT_CONVERT,      // dry/wet mix, clamp, float -> PCM
+    STAGE_TOTAL,               // the whole process() call
+    NUM_DSP_STAGES
+};
+
+const char* dspStageName(int stage);
+
+uint64_t dspNowNs();
+
+struct DspStageReport {
+    float calls;
+    float minNsPerFrame;
+    float meanNsPerFrame;
+    float p99NsPerFrame;
+    float maxNsPerFrame;
+};
+
+struct DspCallbackReport {
+    float callbacks;
+    float meanIntervalUs;
+    float meanJitterUs;        // |actual interval - previous buffer period|
+    float maxJitterUs;
+    float overruns;            // calls whose cost exceeded the buffer period
+    float maxLoad;             // worst cost / buffer period ratio seen
+    float idleRatio;           // share of frames skipped by the silence detector
+};
+
+class DspStats {
+public:
+    DspStats();
+
+    // Audio thread only.
+    void beginCallback(uint64_t nowNs, int frames, int sampleRate);
+    void recordStage(int stage, uint64_t elapsedNs, int frames);
+    void endCallback(uint64_t elapsedNs, int frames, int sampleRate);
+    void recordIdleFrames(int frames);
+
+    // Any thread.
+    DspStageReport stageReport(int stage) const;
+    DspCallbackReport callbackReport() const;
+    void requestReset();
+
+private:
+    static const int HISTOGRAM_BUCKETS = 128;   // 4 sub-buckets per power of two
+
+    struct StageCounters {
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> frames;
+        std::atomic<uint64_t> totalNs;
+        std::atomic<uint32_t> minPsPerFrame;
+        std::atomic<uint32_t> maxPsPerFrame;
+        std::atomic<uint32_t> histogram[HISTOGRAM_BUCKETS];
+    };
+
+    StageCounters m_stages[NUM_DSP_STAGES];
+
+    std::atomic<uint64_t> m_callbacks;
+    std::atomic<uint64_t> m_intervalNsSum;
+    std::atomic<uint64_t> m_jitterNsSum;
+    std::atomic<uint64_t> m_maxJitterNs;
+    std::atomic<uint64_t> m_overruns;
+    std::atomic<uint32_t> m_maxLoadPermille;
+    std::atomic<uint64_t> m_idleFrames;
+    std::atomic<bool> m_resetRequested;
+
+    // Audio-thread private.
+    uint64_t m_lastCallbackNs;
+    uint64_t m_lastPeriodNs;
+
+    void resetCounters();
+
+    static int bucketIndex(uint32_t value);
+    static uint32_t bucketMidpoint(int index);
+
+    template <typename T>
+    static void bump(std::atomic<T>& counter, T amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+};
+
+#endif // DSP_STATS_H
@@ -6,6 +6,8 @@ DynamicProcessor::DynamicProcessor()
         : m_distanceCompression(0.8f)
         , m_makeupGain(1.0f)
         , m_softLimitingEnabled(true)
+        , m_compressionRamp(0.8f)
+        , m_makeupGainRamp(1.0f)
         , m_limiterThreshold(0.9f)
         , m_limiterRatio(10.0f) {
 
@@ -43,6 +45,12 @@ void DynamicProcessor::process(const float* leftIn, const float* rightIn,
         return;
     }
 
+    // Both steps are exactly zero unless a parameter is ramping
+    float compression = m_compressionRamp.value();
+    float makeupGain = m_makeupGainRamp.value();
+    const float compressionStep = m_compressionRamp.advance(frames);
+    const float makeupGainStep = m_makeupGainRamp.advance(frames);
+
     for (int i = 0; i < frames; i++) {
         float leftSample = leftIn[i];
         float rightSample = rightIn[i];
@@ -51,18 +59,21 @@ void DynamicProcessor::process(const float* leftIn, const float* rightIn,
         processMultiBandCompressor(leftSample, leftSample, 0);
         processMultiBandCompressor(rightSample, rightSample, 1);
 
-        applyDistanceCompression(leftSample, 0);
-        applyDistanceCompression(rightSample, 1);
+        applyDistanceCompression(leftSample, 0, compression);
+        applyDistanceCompression(rightSample, 1, compression);
 
         if (m_softLimitingEnabled) {
             applySoftLimiter(leftSample, rightSample);
         }
 
-        leftSample *= m_makeupGain;
-        rightSample *= m_makeupGain;
+        leftSample *= makeupGain;
+        rightSample *= makeupGain;
 
         leftOut[i] = leftSample;
         rightOut[i] = rightSample;
+
+        compression += compressionStep;
+        makeupGain += makeupGainStep;
     }
 }
 
@@ -91,8 +102,7 @@ float DynamicProcessor::processCompressorBand(float input, CompressorBand& band)
     return input * gain * band.gain;
 }
 
-void DynamicProcessor::applyDistanceCompression(float& sample, int band) {
-    float compressionAmount = m_distanceCompression;
+void DynamicProcessor::applyDistanceCompression(float& sample, int band, float compressionAmount) {
     if (band > 1) {
         compressionAmount *= 1.3f;
     }
@@ -148,10 +158,17 @@ float DynamicProcessor::calculateCompressorGain(float input, float threshold, fl
 void DynamicProcessor::setSampleRate(int sampleRate) {
     AudioProcessor::setSampleRate(sampleRate);
     updateCrossoverFilters();
+    snapParameters();
 }
 
 void DynamicProcessor::reset() {
     clearStates();
+    snapParameters();
+}
+
+void DynamicProcessor::snapParameters() {
+    m_compressionRamp.snap();
+    m_makeupGainRamp.snap();
 }
 
 void DynamicProcessor::setParameter(int param, float value) {
@@ -173,10 +190,12 @@ float DynamicProcessor::getParameter(int param) const {
 
 void DynamicProcessor::setDistanceCompression(float amount) {
     m_distanceCompression = clamp(amount, 0.0f, 1.0f);
+    m_compressionRamp.setTarget(m_distanceCompression, SmoothedParam::rampFrames(m_sampleRate));
 }
 
 void DynamicProcessor::setMakeupGain(float gain) {
     m_makeupGain = clamp(gain, 0.1f, 2.0f);
+    m_makeupGainRamp.setTarget(m_makeupGain, SmoothedParam::rampFrames(m_sampleRate));
 }
 
 void DynamicProcessor::setSoftLimiting(bool enabled) {
@@ -10,12 +10,14 @@ public:
 
     // Core processing
     void process(const float* input, float* output, int frames) override;
+    // leftOut/rightOut may alias leftIn/rightIn for in-place processing
     void process(const float* leftIn, const float* rightIn,
             float* leftOut, float* rightOut, int frames);
 
     // Configuration
     void setSampleRate(int sampleRate) override;
     void reset() override;
+    void snapParameters() override;
 
     // Parameter control
     void setParameter(int param, float value) override;
@@ -31,6 +33,8 @@ private:
     float m_distanceCompression;  // Distance compression simulation
     float m_makeupGain;          // Makeup gain compensation
     bool m_softLimitingEnabled;   // Soft limiting for background feel
+    SmoothedParam m_compressionRamp;
+    SmoothedParam m_makeupGainRamp;
 
     // Multi-band compressor (3-band)
     struct CompressorBand {
@@ -65,7 +69,7 @@ private:
     // GUARANTEED FIX: The declaration was correct, the definition was wrong. This is the correct signature.
     void processMultiBandCompressor(float input, float& output, int channel);
     void applySoftLimiter(float& leftSample, float& rightSample);
-    void applyDistanceCompression(float& sample, int band);
+    void applyDistanceCompression(float& sample, int band, float compressionAmount);
     float processCompressorBand(float input, CompressorBand& band);
 
     // Utility functions
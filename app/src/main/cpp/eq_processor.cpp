@@ -1,18 +1,121 @@
 #include "eq_processor.h"
+#include "session_registry.h"
+#include "stereo_simd.h"
+#include <algorithm>
 #include <cmath>
+#include <new>
+
+namespace {
+
+// The steady-state inner loop. Sections and state are copied into locals so
+// they stay in registers; each section only depends on its own state from
+// the previous sample, so consecutive samples overlap across sections.
+template <int NUM_SECTIONS>
+void runCascade(const Biquad* sections, Biquad::State* state, const float* input, float* output, int frames,
+                float gain) {
+    Biquad section[NUM_SECTIONS];
+    Biquad::State z[NUM_SECTIONS];
+    for (int k = 0; k < NUM_SECTIONS; k++) {
+        section[k] = sections[k];
+        z[k] = state[k];
+    }
+    for (int i = 0; i < frames; i++) {
+        float sample = input[i];
+        for (int k = 0; k < NUM_SECTIONS; k++) {
+            sample = section[k].process(sample, z[k]);
+        }
+        output[i] = sample * gain;
+    }
+    for (int k = 0; k < NUM_SECTIONS; k++) state[k] = z[k];
+}
+
+// Stereo counterpart of runCascade(): left and right share coefficients and
+// run in the two lanes of one vector, each lane with its own state. With
+// RAMPED the first numRamped sections advance by steps[] every frame, as in
+// the scalar ramp.
+struct StereoSection {
+    stereo::Vec b0, b1, b2, a1, a2;
+};
+
+StereoSection splatSection(const Biquad& section) {
+    return { stereo::splat(section.b0), stereo::splat(section.b1), stereo::splat(section.b2),
+             stereo::splat(section.a1), stereo::splat(section.a2) };
+}
+
+template <int NUM_SECTIONS, bool RAMPED>
+void runStereoCascade(const Biquad* sections, const Biquad* steps, int numRamped, Biquad::State* leftState,
+                      Biquad::State* rightState, const float* leftIn, const float* rightIn, float* leftOut,
+                      float* rightOut, int frames, float gain) {
+    using namespace stereo;
+    StereoSection section[NUM_SECTIONS];
+    StereoSection step[NUM_SECTIONS];
+    Vec z1[NUM_SECTIONS];
+    Vec z2[NUM_SECTIONS];
+    for (int k = 0; k < NUM_SECTIONS; k++) {
+        section[k] = splatSection(sections[k]);
+        if (RAMPED && k < numRamped) step[k] = splatSection(steps[k]);
+        z1[k] = load(leftState[k].z1, rightState[k].z1);
+        z2[k] = load(leftState[k].z2, rightState[k].z2);
+    }
+    const Vec outputGain = splat(gain);
+    for (int i = 0; i < frames; i++) {
+        Vec sample = load(leftIn[i], rightIn[i]);
+        for (int k = 0; k < NUM_SECTIONS; k++) {
+            const StereoSection& s = section[k];
+            Vec output = add(mul(s.b0, sample), z1[k]);
+            z1[k] = add(sub(mul(s.b1, sample), mul(s.a1, output)), z2[k]);
+            z2[k] = sub(mul(s.b2, sample), mul(s.a2, output));
+            sample = output;
+        }
+        sample = mul(sample, outputGain);
+        leftOut[i] = left(sample);
+        rightOut[i] = right(sample);
+        if (RAMPED) {
+            for (int k = 0; k < numRamped; k++) {
+                section[k].b0 = add(section[k].b0, step[k].b0);
+                section[k].b1 = add(section[k].b1, step[k].b1);
+                section[k].b2 = add(section[k].b2, step[k].b2);
+                section[k].a1 = add(section[k].a1, step[k].a1);
+                section[k].a2 = add(section[k].a2, step[k].a2);
+            }
+        }
+    }
+    for (int k = 0; k < NUM_SECTIONS; k++) {
+        leftState[k] = { stereo::left(z1[k]), stereo::left(z2[k]) };
+        rightState[k] = { stereo::right(z1[k]), stereo::right(z2[k]) };
+    }
+}
+
+void stepCoeffs(Biquad& section, const Biquad& step) {
+    section.b0 += step.b0;
+    section.b1 += step.b1;
+    section.b2 += step.b2;
+    section.a1 += step.a1;
+    section.a2 += step.a2;
+}
+
+void applyGain(float* samples, int frames, float gain) {
+    if (gain == 1.0f) return;
+    for (int i = 0; i < frames; i++) samples[i] *= gain;
+}
+
+// Cookbook designs are only valid below Nyquist; keep a margin.
+float designLimit(int sampleRate) {
+    return sampleRate * 0.45f;
+}
+
+} // namespace
+
+const size_t EQProcessor::STATE_BYTES = FirEq::STATE_BYTES;
 
 EQProcessor::EQProcessor()
     : m_highPassFreq(80.0f)
     , m_lowPassFreq(8000.0f)
-    , m_cafeEQEnabled(true)
-    , m_distanceEQ(0.8f) {
-    
-    // Initialize filter state
-    m_hpState[0] = m_hpState[1] = 0.0f;
-    m_lpState[0] = m_lpState[1] = 0.0f;
+    , m_cafeEQEnabled(true) {
     
     // Setup Sony café EQ bands with exact specifications
     setupSonyCafeEQ();
+    setDistanceEQ(0.8f);
 }
 
 EQProcessor::~EQProcessor() {
@@ -26,117 +129,195 @@ void EQProcessor::process(const float* input, float* output, int frames) {
         }
         return;
     }
-    
-    for (int i = 0; i < frames; i++) {
-        float sample = input[i];
-        
-        // Apply high-pass filter (sub-bass roll-off)
-        sample = processFilter(sample, m_hpCoeff, m_hpState);
-        
-        // Apply low-pass filter (ultra-high cut)
-        sample = processFilter(sample, m_lpCoeff, m_lpState);
-        
-        // Apply Sony café EQ curve
-        if (m_cafeEQEnabled) {
-            sample = applySonyCafeEQ(sample);
-        }
-        
-        // Apply distance-dependent EQ
-        sample = applyDistanceEQ(sample);
-        
-        output[i] = sample;
+
+    if (m_fir.update()) clearCascadeState();
+    if (m_fir.isActive()) {
+        m_fir.process(input, output, frames);
+        applyGain(output, frames, m_outputGain);
+        return;
     }
-}
 
-float EQProcessor::applySonyCafeEQ(float sample) {
-    // Sony Café Mode - Complete Distance EQ Implementation
-    // Reference: Sony WH-1000XM series Listening Mode
-    
-    float processedSample = sample;
-    
-    // 1. Sub-bass roll-off: -6dB at 40Hz
-    float subBassCoeff = 1.0f - 0.5f; // -6dB = 0.5 linear
-    if (m_sampleRate > 0) {
-        float freq40Hz = 40.0f / (m_sampleRate * 0.5f);
-        processedSample *= (1.0f - subBassCoeff * expf(-freq40Hz * 10.0f));
+    if (!m_highPass.isSteady() || !m_lowPass.isSteady()) {
+        const Biquad highPass = m_highPass.value();
+        const Biquad lowPass = m_lowPass.value();
+        const Biquad highPassStep = m_highPass.advance(frames);
+        const Biquad lowPassStep = m_lowPass.advance(frames);
+        processRamped(input, output, frames, highPass, highPassStep, lowPass, lowPassStep);
+        updateRollOffSections();
+        return;
     }
-    
-    // 2. Bass reduction: -5dB at 80Hz
-    float bassCoeff = 1.0f - 0.56f; // -5dB ≈ 0.56 linear
-    if (m_sampleRate > 0) {
-        float freq80Hz = 80.0f / (m_sampleRate * 0.5f);
-        processedSample *= (1.0f - bassCoeff * expf(-freq80Hz * 8.0f));
+
+    // High-pass (sub-bass roll-off), low-pass (ultra-high cut), then the
+    // Sony café curve, with the distance EQ as the output gain
+    if (m_cafeEQEnabled) {
+        runCascade<NUM_SECTIONS>(m_sections, m_state[0], input, output, frames, m_outputGain);
+    } else {
+        runCascade<NUM_ROLL_OFF>(m_sections, m_state[0], input, output, frames, m_outputGain);
     }
-    
-    // 3. Low-mid scoop: -3.5dB at 200-500Hz
-    float lowMidCoeff = 1.0f - 0.67f; // -3.5dB ≈ 0.67 linear
-    if (m_sampleRate > 0) {
-        float freq300Hz = 300.0f / (m_sampleRate * 0.5f); // Center of 200-500Hz
-        processedSample *= (1.0f - lowMidCoeff * expf(-powf(freq300Hz - 0.15f, 2) * 15.0f));
+}
+
+void EQProcessor::process(const float* leftIn, const float* rightIn,
+                          float* leftOut, float* rightOut, int frames) {
+    if (!m_initialized) {
+        for (int i = 0; i < frames; i++) {
+            leftOut[i] = leftIn[i];
+            rightOut[i] = rightIn[i];
+        }
+        return;
     }
-    
-    // 4. Mid transparency: -2.5dB at 1-2kHz
-    float midCoeff = 1.0f - 0.75f; // -2.5dB ≈ 0.75 linear
-    if (m_sampleRate > 0) {
-        float freq1500Hz = 1500.0f / (m_sampleRate * 0.5f); // Center of 1-2kHz
-        processedSample *= (1.0f - midCoeff * expf(-powf(freq1500Hz - 0.3f, 2) * 12.0f));
+
+    if (m_fir.update()) clearCascadeState();
+    if (m_fir.isActive()) {
+        m_fir.process(leftIn, rightIn, leftOut, rightOut, frames);
+        applyGain(leftOut, frames, m_outputGain);
+        applyGain(rightOut, frames, m_outputGain);
+        return;
     }
-    
-    // 5. High-mid roll-off: -5dB at 4-6kHz
-    float highMidCoeff = 1.0f - 0.56f; // -5dB ≈ 0.56 linear
-    if (m_sampleRate > 0) {
-        float freq5kHz = 5000.0f / (m_sampleRate * 0.5f); // Center of 4-6kHz
-        processedSample *= (1.0f - highMidCoeff * expf(-powf(freq5kHz - 0.5f, 2) * 8.0f));
+
+    if (m_highPass.isSteady() && m_lowPass.isSteady()) {
+        if (m_cafeEQEnabled) {
+            runStereoCascade<NUM_SECTIONS, false>(m_sections, nullptr, 0, m_state[0], m_state[1], leftIn, rightIn,
+                                                  leftOut, rightOut, frames, m_outputGain);
+        } else {
+            runStereoCascade<NUM_ROLL_OFF, false>(m_sections, nullptr, 0, m_state[0], m_state[1], leftIn, rightIn,
+                                                  leftOut, rightOut, frames, m_outputGain);
+        }
+        return;
     }
-    
-    // 6. Treble softening: -7dB at 8kHz+
-    float trebleCoeff = 1.0f - 0.45f; // -7dB ≈ 0.45 linear
-    if (m_sampleRate > 0) {
-        float freq8kHz = 8000.0f / (m_sampleRate * 0.5f);
-        if (freq8kHz < 1.0f) {
-            processedSample *= (1.0f - trebleCoeff * (1.0f - expf(-(1.0f - freq8kHz) * 5.0f)));
+
+    // The roll-off sections ramp; both lanes follow the same trajectory
+    Biquad sections[NUM_SECTIONS];
+    std::copy(m_sections, m_sections + NUM_SECTIONS, sections);
+    sections[0] = m_highPass.value();
+    sections[1] = m_lowPass.value();
+    const Biquad steps[NUM_ROLL_OFF] = { m_highPass.advance(frames), m_lowPass.advance(frames) };
+    if (m_cafeEQEnabled) {
+        runStereoCascade<NUM_SECTIONS, true>(sections, steps, NUM_ROLL_OFF, m_state[0], m_state[1], leftIn, rightIn,
+                                             leftOut, rightOut, frames, m_outputGain);
+    } else {
+        runStereoCascade<NUM_ROLL_OFF, true>(sections, steps, NUM_ROLL_OFF, m_state[0], m_state[1], leftIn, rightIn,
+                                             leftOut, rightOut, frames, m_outputGain);
+    }
+    updateRollOffSections();
+}
+
+void EQProcessor::processRamped(const float* input, float* output, int frames,
+                                Biquad highPass, const Biquad& highPassStep,
+                                Biquad lowPass, const Biquad& lowPassStep) {
+    const int numSections = m_cafeEQEnabled ? NUM_SECTIONS : NUM_ROLL_OFF;
+    for (int i = 0; i < frames; i++) {
+        float sample = highPass.process(input[i], m_state[0][0]);
+        sample = lowPass.process(sample, m_state[0][1]);
+        for (int k = NUM_ROLL_OFF; k < numSections; k++) {
+            sample = m_sections[k].process(sample, m_state[0][k]);
         }
+        output[i] = sample * m_outputGain;
+        stepCoeffs(highPass, highPassStep);
+        stepCoeffs(lowPass, lowPassStep);
     }
-    
-    // 7. Ultra-high cut: -11dB at 12kHz+
-    float ultraHighCoeff = 1.0f - 0.28f; // -11dB ≈ 0.28 linear
-    if (m_sampleRate > 0) {
-        float freq12kHz = 12000.0f / (m_sampleRate * 0.5f);
-        if (freq12kHz < 1.0f) {
-            processedSample *= (1.0f - ultraHighCoeff * (1.0f - expf(-(1.0f - freq12kHz) * 3.0f)));
+}
+
+EQProcessor::CafeCurve* EQProcessor::buildCafeCurve(const EQBand* bands, int sampleRate) {
+    auto* curve = new CafeCurve;
+    for (int i = 0; i < NUM_EQ_BANDS; i++) {
+        // Bands at or above the design limit are left flat, e.g. 5 kHz at 8 kHz
+        if (bands[i].frequency < designLimit(sampleRate)) {
+            curve->band[i] = Biquad::peaking(bands[i].frequency, bands[i].gain, bands[i].q, sampleRate);
         }
     }
-    
-    return processedSample;
+    return curve;
 }
 
-float EQProcessor::applyDistanceEQ(float sample) {
-    // Distance-dependent air absorption and psychoacoustic modeling
-    float processedSample = sample;
-    
-    // Air absorption increases with distance and frequency
-    float airAbsorption = m_distanceEQ * 0.2f; // Up to 20% absorption
-    
-    // High-frequency absorption (simulates air resistance)
-    float highFreqAtten = 1.0f - (airAbsorption * 0.6f);
-    processedSample *= highFreqAtten;
-    
-    // Psychoacoustic distance modeling
-    float psychoDistance = 1.0f - (m_distanceEQ * 0.15f); // Up to 15% overall reduction
-    processedSample *= psychoDistance;
-    
-    return processedSample;
+float EQProcessor::magnitudeDb(float frequency) const {
+    const int numSections = m_cafeEQEnabled ? NUM_SECTIONS : NUM_ROLL_OFF;
+    float db = 20.0f * log10f(m_outputGain);
+    db += m_highPass.value().magnitudeDb(frequency, m_sampleRate);
+    db += m_lowPass.value().magnitudeDb(frequency, m_sampleRate);
+    for (int k = NUM_ROLL_OFF; k < numSections; k++) {
+        db += m_sections[k].magnitudeDb(frequency, m_sampleRate);
+    }
+    return db;
 }
 
 void EQProcessor::setSampleRate(int sampleRate) {
     AudioProcessor::setSampleRate(sampleRate);
-    updateHighPassCoeffs();
-    updateLowPassCoeffs();
+    const EQBand* bands = m_eqBands;
+    m_cafeCurve = SessionRegistry::acquire<CafeCurve>(SessionRegistry::TABLE_CAFE_EQ_CURVE, sampleRate,
+                                                      [bands, sampleRate]() { return buildCafeCurve(bands, sampleRate); });
+    for (int i = 0; i < NUM_EQ_BANDS; i++) {
+        m_sections[NUM_ROLL_OFF + i] = m_cafeCurve->band[i];
+    }
+    setCoeffs(designCoeffs(m_highPassFreq, m_lowPassFreq, m_sampleRate));
+    snapParameters();
 }
 
 void EQProcessor::reset() {
-    m_hpState[0] = m_hpState[1] = 0.0f;
-    m_lpState[0] = m_lpState[1] = 0.0f;
+    m_fir.clear();
+    clearCascadeState();
+}
+
+// Also where the cascade restarts from when the FIR engine hands it back.
+void EQProcessor::clearCascadeState() {
+    for (Biquad::State (&channel)[NUM_SECTIONS] : m_state) {
+        for (Biquad::State& state : channel) state = Biquad::State();
+    }
+    snapParameters();
+}
+
+int EQProcessor::getLatencySamples() const {
+    return m_fir.latency();
+}
+
+int EQProcessor::getTailSamples() const {
+    return m_fir.tailSamples();
+}
+
+bool EQProcessor::allocateState() {
+    if (m_stateAllocated) return true;
+    float* storage = m_providedState;
+    if (!storage) {
+        m_firStorage.reset(new(std::nothrow) float[STATE_BYTES / sizeof(float)]);
+        if (!m_firStorage) return false;
+        storage = m_firStorage.get();
+    }
+    m_fir.setStorage(storage);
+    m_stateAllocated = true;
+    return true;
+}
+
+void EQProcessor::releaseState() {
+    m_fir.setStorage(nullptr);
+    m_firStorage.reset();
+    m_stateAllocated = false;
+}
+
+size_t EQProcessor::getStateBytes() const {
+    return m_stateAllocated ? STATE_BYTES : 0;
+}
+
+float EQProcessor::targetDb(const Coeffs& coeffs, float frequency) const {
+    float db = coeffs.highPass.magnitudeDb(frequency, m_sampleRate) + coeffs.lowPass.magnitudeDb(frequency, m_sampleRate);
+    if (m_cafeEQEnabled && m_cafeCurve) {
+        for (const Biquad& band : m_cafeCurve->band) db += band.magnitudeDb(frequency, m_sampleRate);
+    }
+    return db;
+}
+
+void EQProcessor::designFir(Mode mode, const Coeffs& coeffs, const HeadphoneCurve& correction, int partitionSize) {
+    if (mode == MODE_CASCADE) {
+        m_fir.post(std::make_unique<FirEq::Design>());
+        return;
+    }
+    const FirDesign::Phase phase = mode == MODE_LINEAR_PHASE ? FirDesign::LINEAR_PHASE : FirDesign::MINIMUM_PHASE;
+    m_fir.post(FirEq::design([this, &coeffs, &correction](float frequency) {
+        return targetDb(coeffs, frequency) + correction.gainDb(frequency);
+    }, phase, partitionSize, m_sampleRate));
+}
+
+void EQProcessor::snapParameters() {
+    m_highPass.snap();
+    m_lowPass.snap();
+    updateRollOffSections();
 }
 
 void EQProcessor::setParameter(int param, float value) {
@@ -172,13 +353,11 @@ float EQProcessor::getParameter(int param) const {
 }
 
 void EQProcessor::setHighPassFilter(float frequency) {
-    m_highPassFreq = clamp(frequency, 20.0f, 1000.0f);
-    updateHighPassCoeffs();
+    setCoeffs(designCoeffs(frequency, m_lowPassFreq, m_sampleRate));
 }
 
 void EQProcessor::setLowPassFilter(float frequency) {
-    m_lowPassFreq = clamp(frequency, 1000.0f, 20000.0f);
-    updateLowPassCoeffs();
+    setCoeffs(designCoeffs(m_highPassFreq, frequency, m_sampleRate));
 }
 
 void EQProcessor::setCafeEQ(bool enabled) {
@@ -187,24 +366,43 @@ void EQProcessor::setCafeEQ(bool enabled) {
 
 void EQProcessor::setDistanceEQ(float distance) {
     m_distanceEQ = clamp(distance, 0.0f, 1.0f);
+
+    // Distance-dependent air absorption and psychoacoustic modeling
+    float airAbsorption = m_distanceEQ * 0.2f; // Up to 20% absorption
+    float highFreqAtten = 1.0f - (airAbsorption * 0.6f);
+    float psychoDistance = 1.0f - (m_distanceEQ * 0.15f); // Up to 15% overall reduction
+    m_outputGain = highFreqAtten * psychoDistance;
 }
 
-void EQProcessor::updateHighPassCoeffs() {
-    // First-order high-pass filter for sub-bass roll-off
-    float omega = frequencyToRadians(m_highPassFreq);
-    float alpha = omega / (omega + 1.0f);
-    
-    m_hpCoeff[0] = alpha;
-    m_hpCoeff[1] = alpha - 1.0f;
+EQProcessor::Coeffs EQProcessor::designCoeffs(float highPassFreq, float lowPassFreq, int sampleRate) {
+    Coeffs coeffs;
+    coeffs.highPassFreq = clamp(highPassFreq, 20.0f, 1000.0f);
+    coeffs.lowPassFreq = clamp(lowPassFreq, 1000.0f, 20000.0f);
+
+    // Butterworth high-pass for sub-bass roll-off
+    coeffs.highPass = Biquad::highPass(coeffs.highPassFreq, Biquad::BUTTERWORTH_Q, sampleRate);
+
+    // Butterworth low-pass for ultra-high cut; flat if the rate cannot hold it
+    if (coeffs.lowPassFreq < designLimit(sampleRate)) {
+        coeffs.lowPass = Biquad::lowPass(coeffs.lowPassFreq, Biquad::BUTTERWORTH_Q, sampleRate);
+    } else {
+        coeffs.lowPass = Biquad();
+    }
+    return coeffs;
 }
 
-void EQProcessor::updateLowPassCoeffs() {
-    // First-order low-pass filter for ultra-high cut
-    float omega = frequencyToRadians(m_lowPassFreq);
-    float alpha = omega / (omega + 1.0f);
-    
-    m_lpCoeff[0] = alpha;
-    m_lpCoeff[1] = 1.0f - alpha;
+void EQProcessor::setCoeffs(const Coeffs& coeffs) {
+    m_highPassFreq = coeffs.highPassFreq;
+    m_lowPassFreq = coeffs.lowPassFreq;
+    const int rampFrames = SmoothedParam::rampFrames(m_sampleRate);
+    m_highPass.setTarget(coeffs.highPass, rampFrames);
+    m_lowPass.setTarget(coeffs.lowPass, rampFrames);
+    if (m_highPass.isSteady() && m_lowPass.isSteady()) updateRollOffSections();
+}
+
+void EQProcessor::updateRollOffSections() {
+    m_sections[0] = m_highPass.value();
+    m_sections[1] = m_lowPass.value();
 }
 
 void EQProcessor::setupSonyCafeEQ() {
@@ -216,10 +414,3 @@ void EQProcessor::setupSonyCafeEQ() {
     m_eqBands[3] = {1500.0f, -2.5f, 1.0f};  // Mid transparency
     m_eqBands[4] = {5000.0f, -5.0f, 0.9f};  // High-mid roll-off
 }
-
-float EQProcessor::processFilter(float input, float* coeffs, float* state) {
-    // First-order IIR filter implementation
-    float output = coeffs[0] * input + coeffs[1] * state[0];
-    state[0] = output;
-    return output;
-}
\ No newline at end of file
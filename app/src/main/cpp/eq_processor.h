@@ -2,6 +2,9 @@
 #define EQ_PROCESSOR_H
 
 #include "audio_processor.h"
+#include "biquad.h"
+#include "fir_eq.h"
+#include <memory>
 
 class EQProcessor : public AudioProcessor {
 public:
@@ -10,10 +13,21 @@ public:
     
     // Core processing
     void process(const float* input, float* output, int frames) override;
+    // Both channels through the same coefficients with separate filter
+    // state, in one pass with the channels in two SIMD lanes
+    void process(const float* leftIn, const float* rightIn,
+                 float* leftOut, float* rightOut, int frames);
     
     // Configuration
     void setSampleRate(int sampleRate) override;
     void reset() override;
+    void snapParameters() override;
+    int getLatencySamples() const override;
+    int getTailSamples() const override;
+    bool allocateState() override;
+    void releaseState() override;
+    size_t getStateBytes() const override;
+    static const size_t STATE_BYTES;        // FIR convolvers, used in the FIR modes only
     
     // Parameter control
     void setParameter(int param, float value) override;
@@ -24,22 +38,40 @@ public:
     void setLowPassFilter(float frequency);
     void setCafeEQ(bool enabled);
     void setDistanceEQ(float distance);
+
+    // Roll-off filters with their derived coefficients. Designed off the
+    // audio thread with designCoeffs() and installed with setCoeffs(), which
+    // only copies; the filters then ramp to the new sections.
+    struct Coeffs {
+        float highPassFreq;
+        float lowPassFreq;
+        Biquad highPass;
+        Biquad lowPass;
+    };
+    static Coeffs designCoeffs(float highPassFreq, float lowPassFreq, int sampleRate);
+    void setCoeffs(const Coeffs& coeffs);
     
+    // Designed response of the whole cascade at one frequency, output gain
+    // included, for tools that check it against a measurement.
+    float magnitudeDb(float frequency) const;
+
+    // Filter engines. The cascade is the default; the FIR modes realize the
+    // same curve (optionally with a headphone correction on top) as one
+    // long linear- or minimum-phase filter, at a latency of the partition
+    // size plus the filter's group delay. See FirEq.
+    enum Mode {
+        MODE_CASCADE,
+        MODE_LINEAR_PHASE,
+        MODE_MINIMUM_PHASE,
+        NUM_MODES
+    };
+    // Cascade response for coeffs in dB, output gain excluded. Command thread.
+    float targetDb(const Coeffs& coeffs, float frequency) const;
+    // Command thread: designs the FIR for coeffs plus correction and queues
+    // it for the audio thread; MODE_CASCADE queues the switch back.
+    void designFir(Mode mode, const Coeffs& coeffs, const HeadphoneCurve& correction, int partitionSize);
+
 private:
-    // Filter coefficients
-    float m_hpCoeff[2];  // High-pass filter coefficients
-    float m_lpCoeff[2];  // Low-pass filter coefficients
-    
-    // Filter state
-    float m_hpState[2];  // High-pass filter state
-    float m_lpState[2];  // Low-pass filter state
-    
-    // Parameters
-    float m_highPassFreq;
-    float m_lowPassFreq;
-    bool m_cafeEQEnabled;
-    float m_distanceEQ;
-    
     // Sony Café EQ bands (exact specifications)
     struct EQBand {
         float frequency;
@@ -49,16 +81,44 @@ private:
     
     static const int NUM_EQ_BANDS = 5;
     EQBand m_eqBands[NUM_EQ_BANDS];
+
+    // The cascade: high-pass and low-pass roll-off, then one peaking section
+    // per café band when the café EQ is enabled.
+    static const int NUM_ROLL_OFF = 2;
+    static const int NUM_SECTIONS = NUM_ROLL_OFF + NUM_EQ_BANDS;
+    Biquad m_sections[NUM_SECTIONS];        // steady-state coefficients
+    Biquad::State m_state[2][NUM_SECTIONS]; // left (and mono), right
+    BiquadRamp m_highPass;
+    BiquadRamp m_lowPass;
+    float m_outputGain;                     // distance EQ, a broadband gain
     
-    // Sony-specific processing methods
-    float applySonyCafeEQ(float sample);
-    float applyDistanceEQ(float sample);
+    // Parameters
+    float m_highPassFreq;
+    float m_lowPassFreq;
+    bool m_cafeEQEnabled;
+    float m_distanceEQ;
+
+    // The café band sections depend only on the sample rate, so they are
+    // designed once per rate and shared between instances through the
+    // SessionRegistry.
+    struct CafeCurve {
+        Biquad band[NUM_EQ_BANDS];
+    };
+    std::shared_ptr<const CafeCurve> m_cafeCurve;
+    static CafeCurve* buildCafeCurve(const EQBand* bands, int sampleRate);
     
+    // FIR engine, used instead of the cascade while a design is installed
+    FirEq m_fir;
+    std::unique_ptr<float[]> m_firStorage;  // allocateState() without provided storage
+    bool m_stateAllocated = false;
+    void clearCascadeState();
+
+    void processRamped(const float* input, float* output, int frames,
+                       Biquad highPass, const Biquad& highPassStep, Biquad lowPass, const Biquad& lowPassStep);
+
     // Utility functions
-    void updateHighPassCoeffs();
-    void updateLowPassCoeffs();
+    void updateRollOffSections();
     void setupSonyCafeEQ();
-    float processFilter(float input, float* coeffs, float* state);
 };
 
 #endif // EQ_PROCESSOR_H
\ No newline at end of file
@@ -0,0 +1,166 @@
+#include "fft.h"
+#include "session_registry.h"
+#include <cmath>
+#include <utility>
+
+// The real transform runs as a complex FFT of half the size over the even
+// samples (real part) and odd samples (imaginary part), followed by a split
+// step that separates the two spectra again; the inverse undoes the split
+// first. The complex FFT is iterative radix-2 in split form with each
+// stage's twiddles stored contiguously, so the inner loops are unit-stride.
+
+RealFft::RealFft(int size) : m_size(size), m_half(size / 2) {
+    const int m = m_half;
+    for (int i = 1, j = 0; i < m; i++) {
+        int bit = m >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            m_bitReverse.push_back(i);
+            m_bitReverse.push_back(j);
+        }
+    }
+    for (int half = 1; half < m; half <<= 1) {
+        for (int j = 0; j < half; j++) {
+            double angle = -M_PI * j / half;
+            m_twiddleRe.push_back((float)cos(angle));
+            m_twiddleIm.push_back((float)sin(angle));
+        }
+    }
+    for (int k = 0; k <= m / 2; k++) {
+        double angle = -2.0 * M_PI * k / size;
+        m_splitRe.push_back((float)cos(angle));
+        m_splitIm.push_back((float)sin(angle));
+    }
+}
+
+std::shared_ptr<const RealFft> RealFft::forSize(int size) {
+    return SessionRegistry::acquire<RealFft>(SessionRegistry::TABLE_FFT, size,
+                                             [size]() { return new RealFft(size); });
+}
+
+void RealFft::complexForward(float* re, float* im) const {
+    for (size_t p = 0; p < m_bitReverse.size(); p += 2) {
+        std::swap(re[m_bitReverse[p]], re[m_bitReverse[p + 1]]);
+        std::swap(im[m_bitReverse[p]], im[m_bitReverse[p + 1]]);
+    }
+    const float* twRe = m_twiddleRe.data();
+    const float* twIm = m_twiddleIm.data();
+    for (int half = 1; half < m_half; half <<= 1) {
+        for (int i = 0; i < m_half; i += 2 * half) {
+            float* aRe = re + i;
+            float* aIm = im + i;
+            float* bRe = aRe + half;
+            float* bIm = aIm + half;
+            for (int j = 0; j < half; j++) {
+                float tRe = bRe[j] * twRe[j] - bIm[j] * twIm[j];
+                float tIm = bRe[j] * twIm[j] + bIm[j] * twRe[j];
+                bRe[j] = aRe[j] - tRe;
+                bIm[j] = aIm[j] - tIm;
+                aRe[j] += tRe;
+                aIm[j] += tIm;
+            }
+        }
+        twRe += half;
+        twIm += half;
+    }
+}
+
+void RealFft::complexInverse(float* re, float* im) const {
+    // conj(FFT(conj(x))) with the conjugations folded into the twiddles
+    for (size_t p = 0; p < m_bitReverse.size(); p += 2) {
+        std::swap(re[m_bitReverse[p]], re[m_bitReverse[p + 1]]);
+        std::swap(im[m_bitReverse[p]], im[m_bitReverse[p + 1]]);
+    }
+    const float* twRe = m_twiddleRe.data();
+    const float* twIm = m_twiddleIm.data();
+    for (int half = 1; half < m_half; half <<= 1) {
+        for (int i = 0; i < m_half; i += 2 * half) {
+            float* aRe = re + i;
+            float* aIm = im + i;
+            float* bRe = aRe + half;
+            float* bIm = aIm + half;
+            for (int j = 0; j < half; j++) {
+                float tRe = bRe[j] * twRe[j] + bIm[j] * twIm[j];
+                float tIm = bIm[j] * twRe[j] - bRe[j] * twIm[j];
+                bRe[j] = aRe[j] - tRe;
+                bIm[j] = aIm[j] - tIm;
+                aRe[j] += tRe;
+                aIm[j] += tIm;
+            }
+        }
+        twRe += half;
+        twIm += half;
+    }
+}
+
+void RealFft::forward(const float* input, float* re, float* im) const {
+    const int m = m_half;
+    for (int n = 0; n < m; n++) {
+        re[n] = input[2 * n];
+        im[n] = input[2 * n + 1];
+    }
+    complexForward(re, im);
+
+    // Split: X[k] = Ze + W^k Zo and X[m - k] = conj(Ze - W^k Zo), where Ze
+    // and Zo are the spectra of the even and odd samples.
+    const float z0Re = re[0];
+    const float z0Im = im[0];
+    re[0] = z0Re + z0Im;
+    im[0] = 0.0f;
+    re[m] = z0Re - z0Im;
+    im[m] = 0.0f;
+    for (int k = 1; k <= m / 2; k++) {
+        const float aRe = re[k], aIm = im[k];
+        const float bRe = re[m - k], bIm = im[m - k];
+        const float eRe = 0.5f * (aRe + bRe);
+        const float eIm = 0.5f * (aIm - bIm);
+        const float oRe = 0.5f * (aIm + bIm);
+        const float oIm = -0.5f * (aRe - bRe);
+        const float tRe = oRe * m_splitRe[k] - oIm * m_splitIm[k];
+        const float tIm = oRe * m_splitIm[k] + oIm * m_splitRe[k];
+        re[k] = eRe + tRe;
+        im[k] = eIm + tIm;
+        re[m - k] = eRe - tRe;
+        im[m - k] = tIm - eIm;
+    }
+}
+
+void RealFft::unpackInverse(float* re, float* im) const {
+    const int m = m_half;
+    const float x0 = re[0];
+    const float xm = re[m];
+    re[0] = x0 + xm;
+    im[0] = x0 - xm;
+    for (int k = 1; k <= m / 2; k++) {
+        const float pRe = re[k], pIm = im[k];
+        const float qRe = re[m - k], qIm = im[m - k];
+        const float eRe = pRe + qRe;
+        const float eIm = pIm - qIm;
+        const float dRe = pRe - qRe;
+        const float dIm = pIm + qIm;
+        const float oRe = dRe * m_splitRe[k] + dIm * m_splitIm[k];
+        const float oIm = dIm * m_splitRe[k] - dRe * m_splitIm[k];
+        re[k] = eRe - oIm;
+        im[k] = eIm + oRe;
+        re[m - k] = eRe + oIm;
+        im[m - k] = oRe - eIm;
+    }
+    complexInverse(re, im);
+}
+
+void RealFft::inverse(float* re, float* im, float* output) const {
+    unpackInverse(re, im);
+    for (int n = 0; n < m_half; n++) {
+        output[2 * n] = re[n];
+        output[2 * n + 1] = im[n];
+    }
+}
+
+void RealFft::inverseSecondHalf(float* re, float* im, float* output) const {
+    unpackInverse(re, im);
+    for (int n = m_half / 2; n < m_half; n++) {
+        output[2 * n - m_half] = re[n];
+        output[2 * n - m_half + 1] = im[n];
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <memory>
+#include <vector>
+
+// Real-input FFT of a power-of-two size N, for the partitioned convolvers.
+// Spectra are N/2 + 1 bins in split form (separate re and im arrays), which
+// is what the complex multiply-accumulate over many partitions wants: plain
+// float streams the compiler vectorizes without shuffles.
+//
+// forward() computes X[k] = sum x[n] e^(-2 pi i k n / N). inverse() is the
+// unscaled inverse, so inverse(forward(x)) = N x; convolvers fold the 1/N
+// into their filter spectra. Both work in the caller's arrays and never
+// allocate, so they may run on the audio thread.
+//
+// The twiddle and bit-reversal tables depend only on N, so each size is
+// built once and shared through the SessionRegistry (forSize(), command
+// thread only).
+class RealFft {
+public:
+    static const int MIN_SIZE = 4;
+
+    explicit RealFft(int size);
+    static std::shared_ptr<const RealFft> forSize(int size);
+
+    int size() const { return m_size; }
+    int bins() const { return m_size / 2 + 1; }
+
+    // input: size() samples. re, im: bins() each.
+    void forward(const float* input, float* re, float* im) const;
+    // re, im: bins() each, overwritten. output: size() samples.
+    void inverse(float* re, float* im, float* output) const;
+    // Same, writing only the second half of the output (overlap-save keeps
+    // just those) to output[0 .. size()/2).
+    void inverseSecondHalf(float* re, float* im, float* output) const;
+
+private:
+    void complexForward(float* re, float* im) const;
+    void complexInverse(float* re, float* im) const;
+    void unpackInverse(float* re, float* im) const;
+
+    int m_size;
+    int m_half;                       // complex FFT length, N/2
+    std::vector<int> m_bitReverse;    // swap pairs for the N/2 permutation
+    std::vector<float> m_twiddleRe;   // per stage, contiguous: N/2 - 1 entries
+    std::vector<float> m_twiddleIm;
+    std::vector<float> m_splitRe;     // e^(-2 pi i k / N), k < N/4 + 1
+    std::vector<float> m_splitIm;
+};
+
+#endif // FFT_H
@@ -0,0 +1,134 @@
+#include "fir_design.h"
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+namespace {
+
+using Complex = std::complex<double>;
+
+// In-place radix-2 FFT for the design grids; sign -1 forward, +1 inverse
+// (unscaled). Design runs once per parameter change, so plain code in
+// double precision is fine here.
+void transform(std::vector<Complex>& data, int sign) {
+    const size_t n = data.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(data[i], data[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        const double angle = sign * 2.0 * M_PI / (double)len;
+        for (size_t j = 0; j < len / 2; j++) {
+            const Complex w = std::polar(1.0, angle * (double)j);
+            for (size_t i = j; i < n; i += len) {
+                Complex t = w * data[i + len / 2];
+                data[i + len / 2] = data[i] - t;
+                data[i] += t;
+            }
+        }
+    }
+}
+
+// Target magnitude on the full circle of an n-point grid, floored at
+// -120 dB so the logarithm of the minimum-phase design stays finite.
+std::vector<double> sampleMagnitude(const std::function<float(float)>& targetDb, size_t n, int sampleRate) {
+    std::vector<double> magnitude(n);
+    for (size_t k = 0; k <= n / 2; k++) {
+        double db = std::max((double)targetDb((float)((double)k * sampleRate / (double)n)), -120.0);
+        magnitude[k] = pow(10.0, db / 20.0);
+        if (k > 0 && k < n / 2) magnitude[n - k] = magnitude[k];
+    }
+    return magnitude;
+}
+
+std::vector<float> linearPhase(const std::function<float(float)>& targetDb, int length, int sampleRate) {
+    const size_t grid = (size_t)length * 4;
+    std::vector<double> magnitude = sampleMagnitude(targetDb, grid, sampleRate);
+    std::vector<Complex> spectrum(magnitude.begin(), magnitude.end());
+    transform(spectrum, 1);
+
+    // Zero-phase response centred in length - 1 taps
+    const int taps = length - 1;
+    const int centre = FirDesign::groupDelay(length, FirDesign::LINEAR_PHASE);
+    std::vector<float> h(length, 0.0f);
+    for (int n = 0; n < taps; n++) {
+        const size_t index = (size_t)((n - centre + (int)grid) % (int)grid);
+        const double window = 0.5 - 0.5 * cos(2.0 * M_PI * (n + 1) / (double)(taps + 1));
+        h[n] = (float)(spectrum[index].real() / (double)grid * window);
+    }
+    return h;
+}
+
+std::vector<float> minimumPhase(const std::function<float(float)>& targetDb, int length, int sampleRate) {
+    // A fine grid keeps the cepstrum from aliasing onto itself
+    const size_t grid = (size_t)length * 8;
+    std::vector<double> magnitude = sampleMagnitude(targetDb, grid, sampleRate);
+    std::vector<Complex> cepstrum(grid);
+    for (size_t k = 0; k < grid; k++) cepstrum[k] = log(magnitude[k]);
+    transform(cepstrum, 1);
+
+    // Fold the real cepstrum onto positive quefrencies: the result is the
+    // complex cepstrum of the minimum-phase filter with this magnitude.
+    for (size_t n = 0; n < grid; n++) {
+        double value = cepstrum[n].real() / (double)grid;
+        if (n > 0 && n < grid / 2) value *= 2.0;
+        else if (n > grid / 2) value = 0.0;
+        cepstrum[n] = value;
+    }
+    transform(cepstrum, -1);
+    for (Complex& bin : cepstrum) bin = std::exp(bin);
+    transform(cepstrum, 1);
+
+    std::vector<float> h(length);
+    const int fadeStart = length - length / 4;
+    for (int n = 0; n < length; n++) {
+        double value = cepstrum[n].real() / (double)grid;
+        if (n >= fadeStart) value *= 0.5 + 0.5 * cos(M_PI * (n - fadeStart + 1) / (double)(length - fadeStart + 1));
+        h[n] = (float)value;
+    }
+    return h;
+}
+
+} // namespace
+
+bool HeadphoneCurve::set(const float* frequencies, const float* gainsDb, int count) {
+    if (count < 0 || count > MAX_POINTS) return false;
+    std::vector<Point> points;
+    for (int i = 0; i < count; i++) {
+        if (frequencies[i] > 0.0f && std::isfinite(gainsDb[i])) {
+            points.push_back({ log2f(frequencies[i]), gainsDb[i] });
+        }
+    }
+    std::sort(points.begin(), points.end(),
+              [](const Point& a, const Point& b) { return a.logFrequency < b.logFrequency; });
+    m_points = std::move(points);
+    return true;
+}
+
+float HeadphoneCurve::gainDb(float frequency) const {
+    if (m_points.empty()) return 0.0f;
+    const float x = log2f(std::max(frequency, 1.0f));
+    if (x <= m_points.front().logFrequency) return m_points.front().gainDb;
+    if (x >= m_points.back().logFrequency) return m_points.back().gainDb;
+    auto upper = std::upper_bound(m_points.begin(), m_points.end(), x,
+                                  [](float value, const Point& p) { return value < p.logFrequency; });
+    const Point& a = *(upper - 1);
+    const Point& b = *upper;
+    const float span = b.logFrequency - a.logFrequency;
+    return span > 0.0f ? a.gainDb + (b.gainDb - a.gainDb) * (x - a.logFrequency) / span : b.gainDb;
+}
+
+std::vector<float> FirDesign::design(const std::function<float(float)>& targetDb, int length, Phase phase,
+                                     int sampleRate) {
+    return phase == LINEAR_PHASE ? linearPhase(targetDb, length, sampleRate)
+                                 : minimumPhase(targetDb, length, sampleRate);
+}
+
+float FirDesign::magnitudeDb(const std::vector<float>& taps, float frequency, int sampleRate) {
+    const double w = 2.0 * M_PI * frequency / sampleRate;
+    Complex sum = 0.0;
+    for (size_t n = 0; n < taps.size(); n++) sum += (double)taps[n] * std::polar(1.0, -w * (double)n);
+    return (float)(20.0 * log10(std::max(std::abs(sum), 1e-12)));
+}
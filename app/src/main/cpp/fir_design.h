@@ -0,0 +1,56 @@
+#ifndef FIR_DESIGN_H
+#define FIR_DESIGN_H
+
+#include <functional>
+#include <vector>
+
+// A headphone's correction as (frequency, gain) points, e.g. the inverse of
+// a measured response against a target. Interpolated linearly over log
+// frequency and held flat beyond the first and last point. Empty is flat.
+class HeadphoneCurve {
+public:
+    static const int MAX_POINTS = 128;
+
+    // Points need not be sorted; non-positive frequencies are dropped.
+    // Returns false (and leaves the curve unchanged) for more than
+    // MAX_POINTS points.
+    bool set(const float* frequencies, const float* gainsDb, int count);
+    void clear() { m_points.clear(); }
+    bool isFlat() const { return m_points.empty(); }
+    int pointCount() const { return (int)m_points.size(); }
+
+    float gainDb(float frequency) const;
+
+private:
+    struct Point {
+        float logFrequency;
+        float gainDb;
+    };
+    std::vector<Point> m_points;
+};
+
+// Designs an FIR filter from a target magnitude response (in dB at any
+// frequency up to Nyquist) by frequency sampling. Runs off the audio thread:
+// it allocates and transforms in double precision on grids several times
+// the filter length.
+//
+// LINEAR_PHASE is a symmetric filter of length - 1 taps (the last tap is
+// zero), delaying every frequency by (length - 2) / 2 samples; the target is
+// sampled with zero phase and windowed (Hann). MINIMUM_PHASE has the same
+// magnitude with (almost) no delay, derived through the real cepstrum, and
+// is faded out over its last quarter. Frequency resolution is about
+// 2 * sampleRate / length either way.
+class FirDesign {
+public:
+    enum Phase { LINEAR_PHASE, MINIMUM_PHASE };
+
+    // length must be a power of two.
+    static std::vector<float> design(const std::function<float(float)>& targetDb, int length, Phase phase,
+                                     int sampleRate);
+    // Delay of the passband in samples.
+    static int groupDelay(int length, Phase phase) { return phase == LINEAR_PHASE ? (length - 2) / 2 : 0; }
+    // Realized response of taps at one frequency, for tools and tests.
+    static float magnitudeDb(const std::vector<float>& taps, float frequency, int sampleRate);
+};
+
+#endif // FIR_DESIGN_H
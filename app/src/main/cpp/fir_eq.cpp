@@ -0,0 +1,101 @@
+#include "fir_eq.h"
+#include <algorithm>
+
+const size_t FirEq::STATE_BYTES =
+        2 * PartitionedConvolver::maxStateFloats(MAX_TAPS, MIN_PARTITION, MAX_PARTITION) * sizeof(float);
+
+FirEq::~FirEq() {
+    delete m_fading;
+    delete m_active;
+}
+
+int FirEq::tapsForRate(int sampleRate) {
+    int taps = 256;
+    while (taps < MAX_TAPS && taps < sampleRate / 24) taps *= 2;
+    return taps;
+}
+
+int FirEq::clampPartition(int partitionSize) {
+    int size = MIN_PARTITION;
+    while (size * 2 <= std::min(partitionSize, (int)MAX_PARTITION)) size *= 2;
+    return size;
+}
+
+std::unique_ptr<FirEq::Design> FirEq::design(const std::function<float(float)>& targetDb, FirDesign::Phase phase,
+                                             int partitionSize, int sampleRate) {
+    auto result = std::make_unique<Design>();
+    const int length = tapsForRate(sampleRate);
+    const int partition = clampPartition(partitionSize);
+    std::vector<float> taps = FirDesign::design(targetDb, length, phase, sampleRate);
+    result->filter = std::make_unique<FirPartitions>(taps.data(), length, partition);
+    result->phase = phase;
+    result->latency = latencyFor(phase, partition, sampleRate);
+    return result;
+}
+
+void FirEq::post(std::unique_ptr<Design> design) {
+    m_mailbox.post(std::move(design));
+}
+
+void FirEq::collect() {
+    m_mailbox.collect();
+}
+
+void FirEq::setStorage(float* storage) {
+    m_left.setStorage(storage);
+    m_right.setStorage(storage ? storage + STATE_BYTES / sizeof(float) / 2 : nullptr);
+    if (storage) configure();
+}
+
+void FirEq::configure() {
+    if (!m_active || !m_active->filter || !m_left.hasStorage()) return;
+    const FirPartitions& filter = *m_active->filter;
+    m_left.configure(filter.partitionSize(), filter.partitionCount());
+    m_right.configure(filter.partitionSize(), filter.partitionCount());
+}
+
+void FirEq::clear() {
+    m_left.clear();
+    m_right.clear();
+    if (m_fading) {
+        // The crossfade is abandoned with the signal it was blending
+        m_mailbox.retire(m_fading);
+        m_fading = nullptr;
+    }
+}
+
+bool FirEq::update() {
+    if (m_fading && !m_left.isCrossfading()) {
+        m_right.crossfadeFrom(nullptr);
+        m_mailbox.retire(m_fading);
+        m_fading = nullptr;
+    }
+    if (m_fading) return false;
+    Design* next = m_mailbox.take();
+    if (!next) return false;
+
+    const bool wasActive = m_active && m_active->filter;
+    const bool nowActive = next->filter != nullptr;
+    Design* previous = m_active;
+    m_active = next;
+    if (wasActive && nowActive && previous->filter->partitionSize() == next->filter->partitionSize() &&
+        previous->filter->partitionCount() == next->filter->partitionCount() && m_left.hasStorage()) {
+        m_left.crossfadeFrom(previous->filter.get());
+        m_right.crossfadeFrom(previous->filter.get());
+        m_fading = previous;
+    } else {
+        configure();
+        if (previous) m_mailbox.retire(previous);
+    }
+    return wasActive != nowActive;
+}
+
+void FirEq::process(const float* input, float* output, int frames) {
+    m_left.process(input, output, frames, *m_active->filter);
+}
+
+void FirEq::process(const float* leftIn, const float* rightIn, float* leftOut, float* rightOut, int frames) {
+    const FirPartitions& filter = *m_active->filter;
+    m_left.process(leftIn, leftOut, frames, filter);
+    m_right.process(rightIn, rightOut, frames, filter);
+}
@@ -0,0 +1,77 @@
+#ifndef FIR_EQ_H
+#define FIR_EQ_H
+
+#include "design_mailbox.h"
+#include "fir_design.h"
+#include "partitioned_convolver.h"
+#include <memory>
+
+// The FIR engine behind EQProcessor's linear- and minimum-phase modes: a
+// designed filter per target curve, run through one partitioned convolver
+// per channel.
+//
+// Designs are built on the command thread and handed over through a
+// DesignMailbox; the audio thread installs the newest one at its next
+// block and hands the filter it replaced back for the command thread to
+// free. A design with the same partition size crossfades in over one
+// partition; anything else (another partition size, switching the engine
+// on or off) restarts the convolvers.
+class FirEq {
+public:
+    static const int MAX_TAPS = 4096;
+    static const int MIN_PARTITION = 32;
+    static const int MAX_PARTITION = 512;
+    static const int DEFAULT_PARTITION = 128;
+    static const size_t STATE_BYTES;        // both channels at the largest geometry
+
+    struct Design {
+        std::unique_ptr<FirPartitions> filter;   // nullptr: engine off
+        FirDesign::Phase phase = FirDesign::MINIMUM_PHASE;
+        int latency = 0;                         // partition + group delay, samples
+    };
+
+    // Command thread. Filter length for a rate: about 24 Hz resolution,
+    // capped at MAX_TAPS.
+    static int tapsForRate(int sampleRate);
+    // partitionSize is rounded down to a power of two in range.
+    static std::unique_ptr<Design> design(const std::function<float(float)>& targetDb, FirDesign::Phase phase,
+                                          int partitionSize, int sampleRate);
+    static int clampPartition(int partitionSize);
+    static int latencyFor(FirDesign::Phase phase, int partitionSize, int sampleRate) {
+        return clampPartition(partitionSize) + FirDesign::groupDelay(tapsForRate(sampleRate), phase);
+    }
+
+    FirEq() = default;
+    ~FirEq();
+    FirEq(const FirEq&) = delete;
+    FirEq& operator=(const FirEq&) = delete;
+
+    // Command thread: queues a design (an empty one switches the engine
+    // off), replacing one the audio thread has not picked up yet.
+    void post(std::unique_ptr<Design> design);
+    // Command thread: frees designs the audio thread has let go of.
+    void collect();
+
+    // Audio thread. STATE_BYTES of storage; nullptr unbinds.
+    void setStorage(float* storage);
+    // Installs a posted design. Returns true when the engine was switched on
+    // or off, so the caller can reset whatever it ran instead.
+    bool update();
+    bool isActive() const { return m_active && m_active->filter && m_left.hasStorage(); }
+    int latency() const { return isActive() ? m_active->latency : 0; }
+    int tailSamples() const { return isActive() ? m_active->latency + m_active->filter->length() : 0; }
+    void clear();
+    void process(const float* input, float* output, int frames);
+    void process(const float* leftIn, const float* rightIn, float* leftOut, float* rightOut, int frames);
+
+private:
+    void configure();
+
+    DesignMailbox<Design> m_mailbox;
+    Design* m_active = nullptr;       // audio thread
+    Design* m_fading = nullptr;       // audio thread, until the crossfade ends
+    PartitionedConvolver m_left;
+    PartitionedConvolver m_right;
+};
+
+#endif // FIR_EQ_H
@@ -0,0 +1,175 @@
+#include "format_converter.h"
+#include "audio_effect.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+struct CodecS16 {
+    static const int kBytes = 2;
+    static float load(const uint8_t* p) {
+        int16_t v;
+        memcpy(&v, p, sizeof(v));
+        return v * (1.0f / 32768.0f);
+    }
+    static void store(uint8_t* p, float v) {
+        int16_t s = (int16_t)(std::clamp(v, -1.0f, 1.0f) * 32767.0f);
+        memcpy(p, &s, sizeof(s));
+    }
+};
+
+struct CodecS32 {
+    static const int kBytes = 4;
+    static float load(const uint8_t* p) {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        return (float)v * (1.0f / 2147483648.0f);
+    }
+    static void store(uint8_t* p, float v) {
+        // 0.99999994f * 2^31 is the largest float below INT32_MAX.
+        int32_t s = (int32_t)(std::clamp(v, -1.0f, 0.99999994f) * 2147483648.0f);
+        memcpy(p, &s, sizeof(s));
+    }
+};
+
+struct CodecQ8_23 {
+    static const int kBytes = 4;
+    static float load(const uint8_t* p) {
+        int32_t v;
+        memcpy(&v, p, sizeof(v));
+        return (float)v * (1.0f / 8388608.0f);
+    }
+    static void store(uint8_t* p, float v) {
+        int32_t s = (int32_t)(std::clamp(v, -1.0f, 8388607.0f / 8388608.0f) * 8388608.0f);
+        memcpy(p, &s, sizeof(s));
+    }
+};
+
+struct CodecPacked24 {
+    static const int kBytes = 3;
+    static float load(const uint8_t* p) {
+        int32_t v = (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+        return (float)v * (1.0f / 8388608.0f);
+    }
+    static void store(uint8_t* p, float v) {
+        int32_t s = (int32_t)(std::clamp(v, -1.0f, 8388607.0f / 8388608.0f) * 8388608.0f);
+        p[0] = (uint8_t)s;
+        p[1] = (uint8_t)(s >> 8);
+        p[2] = (uint8_t)(s >> 16);
+    }
+};
+
+struct CodecFloat {
+    static const int kBytes = 4;
+    static float load(const uint8_t* p) {
+        float v;
+        memcpy(&v, p, sizeof(v));
+        return v;
+    }
+    static void store(uint8_t* p, float v) {
+        memcpy(p, &v, sizeof(v));
+    }
+};
+
+template <typename Codec>
+void deinterleave(const void* in, float* __restrict left, float* __restrict right, int frames) {
+    const uint8_t* __restrict src = static_cast<const uint8_t*>(in);
+    for (int i = 0; i < frames; i++) {
+        left[i] = Codec::load(src + (2 * i) * Codec::kBytes);
+        right[i] = Codec::load(src + (2 * i + 1) * Codec::kBytes);
+    }
+}
+
+template <typename Codec>
+void deinterleaveN(const void* in, int channels, float* const* out, int frames) {
+    const uint8_t* src = static_cast<const uint8_t*>(in);
+    const int stride = channels * Codec::kBytes;
+    for (int c = 0; c < channels; c++) {
+        const uint8_t* __restrict p = src + c * Codec::kBytes;
+        float* __restrict dst = out[c];
+        for (int i = 0; i < frames; i++) {
+            dst[i] = Codec::load(p + i * stride);
+        }
+    }
+}
+
+template <typename Codec, bool Accumulate>
+void interleave(const float* __restrict left, const float* __restrict right, void* out, int frames) {
+    uint8_t* __restrict dst = static_cast<uint8_t*>(out);
+    for (int i = 0; i < frames; i++) {
+        uint8_t* l = dst + (2 * i) * Codec::kBytes;
+        uint8_t* r = dst + (2 * i + 1) * Codec::kBytes;
+        if (Accumulate) {
+            Codec::store(l, Codec::load(l) + left[i]);
+            Codec::store(r, Codec::load(r) + right[i]);
+        } else {
+            Codec::store(l, left[i]);
+            Codec::store(r, right[i]);
+        }
+    }
+}
+
+template <typename Codec>
+void interleaveAny(const float* left, const float* right, void* out, int frames, bool accumulate) {
+    if (accumulate) {
+        interleave<Codec, true>(left, right, out, frames);
+    } else {
+        interleave<Codec, false>(left, right, out, frames);
+    }
+}
+
+} // namespace
+
+int pcmBytesPerSample(int format) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_16_BIT: return 2;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED: return 3;
+        case AUDIO_FORMAT_PCM_32_BIT:
+        case AUDIO_FORMAT_PCM_8_24_BIT:
+        case AUDIO_FORMAT_PCM_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+bool isSupportedPcmFormat(int format) {
+    return pcmBytesPerSample(format) != 0;
+}
+
+void deinterleaveStereo(const void* in, int format, float* left, float* right, int frames) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_16_BIT: deinterleave<CodecS16>(in, left, right, frames); break;
+        case AUDIO_FORMAT_PCM_32_BIT: deinterleave<CodecS32>(in, left, right, frames); break;
+        case AUDIO_FORMAT_PCM_8_24_BIT: deinterleave<CodecQ8_23>(in, left, right, frames); break;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED: deinterleave<CodecPacked24>(in, left, right, frames); break;
+        case AUDIO_FORMAT_PCM_FLOAT: deinterleave<CodecFloat>(in, left, right, frames); break;
+        default:
+            memset(left, 0, frames * sizeof(float));
+            memset(right, 0, frames * sizeof(float));
+            break;
+    }
+}
+
+void deinterleave(const void* in, int format, int channels, float* const* out, int frames) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_16_BIT: deinterleaveN<CodecS16>(in, channels, out, frames); break;
+        case AUDIO_FORMAT_PCM_32_BIT: deinterleaveN<CodecS32>(in, channels, out, frames); break;
+        case AUDIO_FORMAT_PCM_8_24_BIT: deinterleaveN<CodecQ8_23>(in, channels, out, frames); break;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED: deinterleaveN<CodecPacked24>(in, channels, out, frames); break;
+        case AUDIO_FORMAT_PCM_FLOAT: deinterleaveN<CodecFloat>(in, channels, out, frames); break;
+        default:
+            for (int c = 0; c < channels; c++) memset(out[c], 0, frames * sizeof(float));
+            break;
+    }
+}
+
+void interleaveStereo(const float* left, const float* right, void* out, int format, int frames,
+                      bool accumulate) {
+    switch (format) {
+        case AUDIO_FORMAT_PCM_16_BIT: interleaveAny<CodecS16>(left, right, out, frames, accumulate); break;
+        case AUDIO_FORMAT_PCM_32_BIT: interleaveAny<CodecS32>(left, right, out, frames, accumulate); break;
+        case AUDIO_FORMAT_PCM_8_24_BIT: interleaveAny<CodecQ8_23>(left, right, out, frames, accumulate); break;
+        case AUDIO_FORMAT_PCM_24_BIT_PACKED: interleaveAny<CodecPacked24>(left, right, out, frames, accumulate); break;
+        case AUDIO_FORMAT_PCM_FLOAT: interleaveAny<CodecFloat>(left, right, out, frames, accumulate); break;
+        default: break;
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef FORMAT_CONVERTER_H
+#define FORMAT_CONVERTER_H
+
+#include <cstdint>
+
+// PCM <-> planar float conversion kernels for the effect's I/O buffers.
+//
+// Supported formats are the AUDIO_FORMAT_PCM_* values from audio_effect.h:
+// 16-bit, 32-bit, 8.24 fixed point, packed 24-bit and float. Each kernel is a
+// straight loop over a fixed-size sample codec with restrict-qualified
+// pointers, so the compiler emits NEON/SSE code for the 16/32-bit and float
+// cases; packed 24-bit is byte-addressed and stays scalar.
+//
+// Integer outputs are clamped to full scale. Float outputs keep any headroom
+// above 1.0 since the float mixer path tolerates it.
+
+int pcmBytesPerSample(int format);
+bool isSupportedPcmFormat(int format);
+
+// Interleaved stereo -> two planar float channels.
+void deinterleaveStereo(const void* in, int format, float* left, float* right, int frames);
+
+// Interleaved N-channel frames -> N planar float channels (out[0..channels)).
+void deinterleave(const void* in, int format, int channels, float* const* out, int frames);
+
+// Two planar float channels -> interleaved stereo. With accumulate set, the
+// result is added to what is already in `out` (EFFECT_BUFFER_ACCESS_ACCUMULATE).
+void interleaveStereo(const float* left, const float* right, void* out, int format, int frames,
+                      bool accumulate);
+
+#endif // FORMAT_CONVERTER_H
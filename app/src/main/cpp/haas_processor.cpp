@@ -1,11 +1,29 @@
 #include "haas_processor.h"
+#include <algorithm>
+#include <cassert>
 #include <cstring>
+#include <new>
 #include <cmath>
 
+const size_t HaasProcessor::STATE_BYTES = 2 * Line::STATE_BYTES;
+
+namespace {
+
+// Sony Café Mode rear-positioning constants
+constexpr float PHASE_INVERT_AMOUNT = 0.3f;   // partial phase inversion (200-2kHz range)
+constexpr float ELEVATION_GAIN = 0.85f;       // HRTF elevation -20°: slightly reduced below the ear
+constexpr float DIRECT_GAIN = ((1.0f - PHASE_INVERT_AMOUNT) - PHASE_INVERT_AMOUNT) * ELEVATION_GAIN;
+constexpr float CROSSFEED_AMOUNT = 0.22f;     // 22% mix
+constexpr float CROSSFEED_MS = 10.0f;
+
+} // namespace
+
 HaasProcessor::HaasProcessor()
         : m_delayAmount(5.0f)
         , m_width(0.6f)
         , m_balance(0.0f)
+        , m_widthRamp(0.6f)
+        , m_balanceRamp(0.0f)
         , m_delayCoeff(0.5f) {
 
     clearDelayBuffer();
@@ -21,77 +39,138 @@ void HaasProcessor::process(const float* input, float* output, int frames) {
 
 void HaasProcessor::process(const float* leftIn, const float* rightIn,
                             float* leftOut, float* rightOut, int frames) {
-    if (!m_initialized) return;
-
-    for (int i = 0; i < frames; i++) {
-        // Sony Café Mode - Rear Positioning Effects Implementation
-
-        // Get input signals
-        float leftSignal = leftIn[i];
-        float rightSignal = rightIn[i];
-
-        // 1. Asymmetric delays: L+20ms, R+18ms (Sony specification)
-        int leftDelayIndex = (m_delayIndex[0] - m_leftDelaySamples + MAX_DELAY_SAMPLES) % MAX_DELAY_SAMPLES;
-        int rightDelayIndex = (m_delayIndex[1] - m_rightDelaySamples + MAX_DELAY_SAMPLES) % MAX_DELAY_SAMPLES;
-
-        float delayedLeft = m_delayBuffer[0][leftDelayIndex];
-        float delayedRight = m_delayBuffer[1][rightDelayIndex];
-
-        // 2. Phase inversion (partial, 200-2kHz range)
-        float phaseInvertAmount = 0.3f; // Partial phase inversion
-        float invertedLeft = leftSignal * (1.0f - phaseInvertAmount) - leftSignal * phaseInvertAmount;
-        float invertedRight = rightSignal * (1.0f - phaseInvertAmount) - rightSignal * phaseInvertAmount;
-
-        // 3. HRTF elevation: -20° (behind/below) simulation
-        float elevationGain = 0.85f; // Slightly reduced gain for below-ear perception
-        invertedLeft *= elevationGain;
-        invertedRight *= elevationGain;
+    if (!m_initialized || !m_delayLine[0].hasStorage()) {
+        if (leftOut != leftIn) memcpy(leftOut, leftIn, frames * sizeof(float));
+        if (rightOut != rightIn) memcpy(rightOut, rightIn, frames * sizeof(float));
+        return;
+    }
 
-        // 4. Crossfeed processing: 22% mix with 10ms delay
-        float crossfeedAmount = 0.22f;
-        int crossfeedDelaySamples = (int)(10.0f * m_sampleRate / 1000.0f); // 10ms delay
+    // Both steps are exactly zero unless a parameter is ramping
+    float width = m_widthRamp.value();
+    float balance = m_balanceRamp.value();
+    const float widthStep = m_widthRamp.advance(frames);
+    const float balanceStep = m_balanceRamp.advance(frames);
+    const bool ramping = widthStep != 0.0f || balanceStep != 0.0f;
 
-        int crossfeedLeftIndex = (m_delayIndex[0] - crossfeedDelaySamples + MAX_DELAY_SAMPLES) % MAX_DELAY_SAMPLES;
-        int crossfeedRightIndex = (m_delayIndex[1] - crossfeedDelaySamples + MAX_DELAY_SAMPLES) % MAX_DELAY_SAMPLES;
+    // Single taps unless a delay moved; then each fades to its new length
+    DelayTap::Block leftDelay = m_leftDelay.beginBlock(frames);
+    DelayTap::Block rightDelay = m_rightDelay.beginBlock(frames);
 
-        float crossfeedLeft = m_delayBuffer[1][crossfeedRightIndex] * crossfeedAmount;
-        float crossfeedRight = m_delayBuffer[0][crossfeedLeftIndex] * crossfeedAmount;
+    // Each chunk is written to the lines before its taps are read, so
+    // in-place output never overwrites input that is still to be delayed;
+    // the taps then reach one chunk further back, which must still fit.
+    const int longest = std::max({ leftDelay.delay, leftDelay.previous, rightDelay.delay, rightDelay.previous,
+                                   m_crossfeedSamples });
+    const int chunkLimit = std::min(CHUNK_FRAMES, MAX_DELAY_SAMPLES - longest);
+    assert(chunkLimit >= 1);    // setCoeffs() keeps every delay inside the line
 
-        // Apply Haas effect with Sony-specific parameters
-        leftOut[i] = invertedLeft + delayedRight * m_delayCoeff * m_width + crossfeedLeft;
-        rightOut[i] = invertedRight + delayedLeft * m_delayCoeff * m_width + crossfeedRight;
+    // Lane order: what ends up in the left output, then the right. The
+    // Haas taps cross over (L+20ms into the right output, R+18ms into the
+    // left), as does the crossfeed.
+    float delayed[2][CHUNK_FRAMES];
+    float crossfed[2][CHUNK_FRAMES];
 
-        // Apply stereo width adjustment based on distance
-        float widthFactor = 1.0f + (m_width - 0.5f) * 0.4f;
-        leftOut[i] *= widthFactor;
-        rightOut[i] *= widthFactor;
+    for (int done = 0; done < frames;) {
+        const int n = std::min(frames - done, chunkLimit);
+        m_delayLine[0].write(leftIn + done, n);
+        m_delayLine[1].write(rightIn + done, n);
+        readTap(m_delayLine[1], rightDelay, n, delayed[0]);
+        readTap(m_delayLine[0], leftDelay, n, delayed[1]);
+        m_delayLine[1].read(m_crossfeedSamples + n, crossfed[0], n);
+        m_delayLine[0].read(m_crossfeedSamples + n, crossfed[1], n);
 
-        // Apply balance adjustment for rear positioning
-        if (m_balance > 0.0f) {
-            leftOut[i] *= (1.0f - m_balance * 0.3f);
-            rightOut[i] *= (1.0f + m_balance * 0.3f);
+        const float* inL = leftIn + done;
+        const float* inR = rightIn + done;
+        float* outL = leftOut + done;
+        float* outR = rightOut + done;
+        if (!ramping) {
+            const Gains gains = mixGains(width, balance);
+            for (int i = 0; i < n; i++) {
+                mixFrame(inL[i], inR[i], delayed[0][i], delayed[1][i], crossfed[0][i], crossfed[1][i], gains,
+                         outL[i], outR[i]);
+            }
         } else {
-            leftOut[i] *= (1.0f + m_balance * 0.3f);
-            rightOut[i] *= (1.0f - m_balance * 0.3f);
+            for (int i = 0; i < n; i++) {
+                mixFrame(inL[i], inR[i], delayed[0][i], delayed[1][i], crossfed[0][i], crossfed[1][i],
+                         mixGains(width, balance), outL[i], outR[i]);
+                width += widthStep;
+                balance += balanceStep;
+            }
         }
+        done += n;
+    }
+}
 
-        // Store in delay buffer for next iteration
-        m_delayBuffer[0][m_delayIndex[0]] = leftSignal;
-        m_delayBuffer[1][m_delayIndex[1]] = rightSignal;
+// The per-sample constants of the rear-positioning mix, for one width and
+// balance.
+HaasProcessor::Gains HaasProcessor::mixGains(float width, float balance) const {
+    Gains gains;
+    gains.direct = stereo::splat(DIRECT_GAIN);
+    gains.crossfeed = stereo::splat(CROSSFEED_AMOUNT);
+    gains.haas = stereo::splat(m_delayCoeff * width);
+
+    // Stereo width adjustment based on distance, and balance for rear
+    // positioning: either sign of balance leans the image to the right
+    const float widthFactor = 1.0f + (width - 0.5f) * 0.4f;
+    const float lean = fabsf(balance) * 0.3f;
+    gains.scale = stereo::load(widthFactor * (1.0f - lean), widthFactor * (1.0f + lean));
+    return gains;
+}
+
+// Sony Café Mode - Rear Positioning: the partially phase-inverted,
+// elevation-shaded direct signal, the opposite channel's Haas tap and the
+// crossfeed, then width and balance. Both channels in one vector.
+inline void HaasProcessor::mixFrame(float inL, float inR, float delayedL, float delayedR, float crossfedL,
+                                    float crossfedR, const Gains& gains, float& outL, float& outR) {
+    stereo::Vec mix = stereo::mul(stereo::load(inL, inR), gains.direct);
+    mix = stereo::add(mix, stereo::mul(stereo::load(delayedL, delayedR), gains.haas));
+    mix = stereo::add(mix, stereo::mul(stereo::load(crossfedL, crossfedR), gains.crossfeed));
+    mix = stereo::mul(mix, gains.scale);
+    outL = stereo::left(mix);
+    outR = stereo::right(mix);
+}
 
-        // Update delay indices
-        m_delayIndex[0] = (m_delayIndex[0] + 1) % MAX_DELAY_SAMPLES;
-        m_delayIndex[1] = (m_delayIndex[1] + 1) % MAX_DELAY_SAMPLES;
+// One chunk of a Haas tap, read after the chunk was written; a moving
+// delay blends its old and new taps and carries the fade to the next chunk.
+void HaasProcessor::readTap(const Line& line, DelayTap::Block& tap, int frames, float* output) {
+    if (tap.fade == 1.0f && tap.step == 0.0f) {
+        line.read(tap.delay + frames, output, frames);
+        return;
     }
+    line.read(tap.previous + frames, output, frames);
+    const Line::Spans current = line.spans(tap.delay + frames, frames);
+    float fade = tap.fade;
+    for (int i = 0; i < current.firstFrames; i++, fade += tap.step) {
+        output[i] += (current.first[i] - output[i]) * fade;
+    }
+    float* rest = output + current.firstFrames;
+    for (int i = 0; i < current.secondFrames; i++, fade += tap.step) {
+        rest[i] += (current.second[i] - rest[i]) * fade;
+    }
+    tap.fade = fade;
 }
 
 void HaasProcessor::setSampleRate(int sampleRate) {
     AudioProcessor::setSampleRate(sampleRate);
-    updateDelaySamples();
+    m_crossfeedSamples = std::clamp((int)(CROSSFEED_MS * m_sampleRate / 1000.0f), 1, MAX_DELAY_SAMPLES - 1);
+    setCoeffs(designCoeffs(m_delayAmount, m_width, m_sampleRate));
+    snapParameters();
 }
 
 void HaasProcessor::reset() {
     clearDelayBuffer();
+    snapParameters();
+}
+
+void HaasProcessor::snapParameters() {
+    m_widthRamp.snap();
+    m_balanceRamp.snap();
+    m_leftDelay.snap();
+    m_rightDelay.snap();
+}
+
+int HaasProcessor::getTailSamples() const {
+    return MAX_DELAY_SAMPLES;
 }
 
 void HaasProcessor::setParameter(int param, float value) {
@@ -122,34 +201,70 @@ float HaasProcessor::getParameter(int param) const {
 }
 
 void HaasProcessor::setDelayAmount(float delayMs) {
-    m_delayAmount = clamp(delayMs, 0.0f, 25.0f); // Extended range for Sony effects
-    updateDelaySamples();
+    setCoeffs(designCoeffs(delayMs, m_width, m_sampleRate));
 }
 
 void HaasProcessor::setWidth(float width) {
     m_width = clamp(width, 0.0f, 1.0f);
+    m_widthRamp.setTarget(m_width, SmoothedParam::rampFrames(m_sampleRate));
 }
 
 void HaasProcessor::setBalance(float balance) {
     m_balance = clamp(balance, -1.0f, 1.0f);
+    m_balanceRamp.setTarget(m_balance, SmoothedParam::rampFrames(m_sampleRate));
 }
 
-void HaasProcessor::updateDelaySamples() {
+HaasProcessor::Coeffs HaasProcessor::designCoeffs(float delayMs, float width, int sampleRate) {
+    Coeffs coeffs;
+    coeffs.delayAmount = clamp(delayMs, 0.0f, 25.0f); // Extended range for Sony effects
+
     // Sony Café Mode - Asymmetric delays: L+20ms, R+18ms
-    m_leftDelaySamples = (int)(20.0f * m_sampleRate / 1000.0f);  // 20ms for left
-    m_rightDelaySamples = (int)(18.0f * m_sampleRate / 1000.0f); // 18ms for right
+    int leftDelaySamples = (int)(20.0f * sampleRate / 1000.0f);  // 20ms for left
+    int rightDelaySamples = (int)(18.0f * sampleRate / 1000.0f); // 18ms for right
 
     // Apply width scaling
-    m_leftDelaySamples = (int)(m_leftDelaySamples * (0.5f + m_width * 0.5f));
-    m_rightDelaySamples = (int)(m_rightDelaySamples * (0.5f + m_width * 0.5f));
+    leftDelaySamples = (int)(leftDelaySamples * (0.5f + width * 0.5f));
+    rightDelaySamples = (int)(rightDelaySamples * (0.5f + width * 0.5f));
 
     // Clamp to buffer size
-    m_leftDelaySamples = clamp(m_leftDelaySamples, 0, MAX_DELAY_SAMPLES - 1);
-    m_rightDelaySamples = clamp(m_rightDelaySamples, 0, MAX_DELAY_SAMPLES - 1);
+    coeffs.leftDelaySamples = std::clamp(leftDelaySamples, 0, MAX_DELAY_SAMPLES - 1);
+    coeffs.rightDelaySamples = std::clamp(rightDelaySamples, 0, MAX_DELAY_SAMPLES - 1);
+    return coeffs;
+}
+
+void HaasProcessor::setCoeffs(const Coeffs& coeffs) {
+    m_delayAmount = coeffs.delayAmount;
+    const int rampFrames = SmoothedParam::rampFrames(m_sampleRate);
+    // Preset bank coefficients come from a file and are not clamped
+    m_leftDelay.setTarget(std::clamp(coeffs.leftDelaySamples, 0, MAX_DELAY_SAMPLES - 1), rampFrames);
+    m_rightDelay.setTarget(std::clamp(coeffs.rightDelaySamples, 0, MAX_DELAY_SAMPLES - 1), rampFrames);
+}
+
+bool HaasProcessor::allocateState() {
+    if (m_delayLine[0].hasStorage()) return true;
+    float* storage = m_providedState;
+    if (!storage) {
+        m_delayStorage.reset(new(std::nothrow) float[2 * MAX_DELAY_SAMPLES]);
+        if (!m_delayStorage) return false;
+        storage = m_delayStorage.get();
+    }
+    m_delayLine[0].setStorage(storage);
+    m_delayLine[1].setStorage(storage + MAX_DELAY_SAMPLES);
+    clearDelayBuffer();
+    return true;
+}
+
+void HaasProcessor::releaseState() {
+    m_delayLine[0].setStorage(nullptr);
+    m_delayLine[1].setStorage(nullptr);
+    m_delayStorage.reset();
+}
+
+size_t HaasProcessor::getStateBytes() const {
+    return m_delayLine[0].hasStorage() ? STATE_BYTES : 0;
 }
 
 void HaasProcessor::clearDelayBuffer() {
-    memset(m_delayBuffer, 0, sizeof(m_delayBuffer));
-    m_delayIndex[0] = 0;
-    m_delayIndex[1] = 0;
+    m_delayLine[0].clear();
+    m_delayLine[1].clear();
 }
\ No newline at end of file
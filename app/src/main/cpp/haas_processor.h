@@ -2,6 +2,9 @@
 #define HAAS_PROCESSOR_H
 
 #include "audio_processor.h"
+#include "delay_line.h"
+#include "stereo_simd.h"
+#include <memory>
 
 class HaasProcessor : public AudioProcessor {
 public:
@@ -10,12 +13,19 @@ public:
     
     // Core processing
     void process(const float* input, float* output, int frames) override;
+    // leftOut/rightOut may alias leftIn/rightIn for in-place processing
     void process(const float* leftIn, const float* rightIn, 
                  float* leftOut, float* rightOut, int frames);
     
     // Configuration
     void setSampleRate(int sampleRate) override;
     void reset() override;
+    int getTailSamples() const override;
+    bool allocateState() override;
+    void releaseState() override;
+    size_t getStateBytes() const override;
+    static const size_t STATE_BYTES;        // two delay lines
+    void snapParameters() override;
     
     // Parameter control
     void setParameter(int param, float value) override;
@@ -25,25 +35,51 @@ public:
     void setDelayAmount(float delayMs);
     void setWidth(float width);
     void setBalance(float balance);
+
+    // Delay amount with the delay-line taps it derives; see
+    // EQProcessor::Coeffs.
+    struct Coeffs {
+        float delayAmount;
+        int leftDelaySamples;
+        int rightDelaySamples;
+    };
+    static Coeffs designCoeffs(float delayMs, float width, int sampleRate);
+    void setCoeffs(const Coeffs& coeffs);
     
 private:
     // Delay line for Haas effect and Sony rear positioning
     static const int MAX_DELAY_SAMPLES = 2048; // Extended for 20ms+ delays
-    float m_delayBuffer[2][MAX_DELAY_SAMPLES];
-    int m_delayIndex[2];
+    using Line = DelayLine<MAX_DELAY_SAMPLES>;
+    std::unique_ptr<float[]> m_delayStorage;   // allocateState() without provided storage
+    Line m_delayLine[2];                       // in provided state or m_delayStorage
     
     // Parameters
     float m_delayAmount;  // Base delay amount (0-25ms)
     float m_width;        // Stereo width (0.0-1.0)
     float m_balance;      // Left/right balance (-1.0 to 1.0)
+    SmoothedParam m_widthRamp;
+    SmoothedParam m_balanceRamp;
     
-    // Sony-specific delay values
-    int m_leftDelaySamples;   // L+20ms
-    int m_rightDelaySamples;  // R+18ms
+    // Sony-specific delay values, crossfaded when width or rate moves them
+    DelayTap m_leftDelay;     // L+20ms
+    DelayTap m_rightDelay;    // R+18ms
+    int m_crossfeedSamples = 1;
     float m_delayCoeff;
+
+    // Block kernel: taps are read a chunk at a time into stack buffers
+    static const int CHUNK_FRAMES = 256;
+    struct Gains {
+        stereo::Vec direct;
+        stereo::Vec haas;
+        stereo::Vec crossfeed;
+        stereo::Vec scale;    // width factor and balance, per channel
+    };
+    Gains mixGains(float width, float balance) const;
+    static void mixFrame(float inL, float inR, float delayedL, float delayedR, float crossfedL, float crossfedR,
+                         const Gains& gains, float& outL, float& outR);
+    static void readTap(const Line& line, DelayTap::Block& tap, int frames, float* output);
     
     // Utility functions
-    void updateDelaySamples();
     void clearDelayBuffer();
 };
 
@@ -0,0 +1,144 @@
+#include "hrir_database.h"
+#include "session_registry.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+static const char kMagic[4] = { 'C', 'T', 'H', 'R' };
+
+const char* const HrirDatabase::DEFAULT_PATH = "/vendor/etc/cafetone_hrir.bin";
+
+namespace {
+
+std::mutex gPathLock;
+std::string gDefaultPath = HrirDatabase::DEFAULT_PATH;
+
+// Unit vector of a direction: x ahead, y to the right, z up.
+void directionVector(float azimuth, float elevation, float (&v)[3]) {
+    const float az = azimuth * (float)M_PI / 180.0f;
+    const float el = elevation * (float)M_PI / 180.0f;
+    v[0] = cosf(el) * cosf(az);
+    v[1] = cosf(el) * sinf(az);
+    v[2] = sinf(el);
+}
+
+} // namespace
+
+HrirDatabase::~HrirDatabase() {
+    if (m_mapping) {
+        munmap(m_mapping, m_size);
+    }
+}
+
+std::unique_ptr<HrirDatabase> HrirDatabase::open(const char* path) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(FileHeader)) {
+        close(fd);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return nullptr;
+
+    std::unique_ptr<HrirDatabase> set(new HrirDatabase());
+    set->m_mapping = mapping;
+    set->m_size = (size_t)st.st_size;
+
+    const auto* bytes = static_cast<const char*>(mapping);
+    const auto* header = reinterpret_cast<const FileHeader*>(bytes);
+    if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != VERSION ||
+        header->rateCount == 0 || header->measurementCount == 0 || header->length == 0 ||
+        header->length > (uint32_t)MAX_LENGTH) {
+        return nullptr;
+    }
+    size_t ratesOffset = sizeof(FileHeader);
+    size_t directionsOffset = ratesOffset + header->rateCount * sizeof(int32_t);
+    size_t tapsOffset = directionsOffset + (size_t)header->measurementCount * sizeof(Direction);
+    size_t expected = tapsOffset + (size_t)header->rateCount * header->measurementCount * 2 * header->length *
+                                   sizeof(float);
+    if (expected != set->m_size) return nullptr;
+
+    set->m_header = header;
+    set->m_rates = reinterpret_cast<const int32_t*>(bytes + ratesOffset);
+    set->m_directions = reinterpret_cast<const Direction*>(bytes + directionsOffset);
+    set->m_taps = reinterpret_cast<const float*>(bytes + tapsOffset);
+    for (int i = 0; i < set->measurementCount(); i++) {
+        const Direction& d = set->direction(i);
+        if (!(d.azimuth >= -360.0f && d.azimuth <= 360.0f && d.elevation >= -90.0f && d.elevation <= 90.0f)) {
+            return nullptr;
+        }
+    }
+    return set;
+}
+
+std::shared_ptr<const HrirDatabase> HrirDatabase::shared() {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> guard(gPathLock);
+        path = gDefaultPath;
+    }
+    return SessionRegistry::acquire<HrirDatabase>(SessionRegistry::TABLE_HRIR_DATABASE, 0, [&path]() {
+        return open(path.c_str()).release();
+    });
+}
+
+void HrirDatabase::setDefaultPath(const std::string& path) {
+    std::lock_guard<std::mutex> guard(gPathLock);
+    gDefaultPath = path;
+}
+
+int HrirDatabase::rateIndex(int sampleRate) const {
+    for (uint32_t r = 0; r < m_header->rateCount; r++) {
+        if (m_rates[r] == sampleRate) return (int)r;
+    }
+    return -1;
+}
+
+int HrirDatabase::nearest(float azimuth, float elevation) const {
+    float target[3];
+    directionVector(azimuth, elevation, target);
+    int best = 0;
+    float bestCos = -2.0f;
+    for (int i = 0; i < measurementCount(); i++) {
+        float v[3];
+        directionVector(m_directions[i].azimuth, m_directions[i].elevation, v);
+        const float c = v[0] * target[0] + v[1] * target[1] + v[2] * target[2];
+        if (c > bestCos) {
+            bestCos = c;
+            best = i;
+        }
+    }
+    return best;
+}
+
+bool HrirDatabase::write(const char* path, const std::vector<int>& rates, const std::vector<Direction>& directions,
+                         int length, const std::vector<float>& taps) {
+    if (rates.empty() || directions.empty() || length <= 0 || length > MAX_LENGTH ||
+        taps.size() != rates.size() * directions.size() * 2 * (size_t)length) {
+        return false;
+    }
+    FileHeader header{};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = VERSION;
+    header.rateCount = (uint32_t)rates.size();
+    header.measurementCount = (uint32_t)directions.size();
+    header.length = (uint32_t)length;
+
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (int rate : rates) {
+        int32_t value = rate;
+        ok = ok && fwrite(&value, sizeof(value), 1, fp) == 1;
+    }
+    ok = ok && fwrite(directions.data(), sizeof(Direction), directions.size(), fp) == directions.size();
+    ok = ok && fwrite(taps.data(), sizeof(float), taps.size(), fp) == taps.size();
+    return fclose(fp) == 0 && ok;
+}
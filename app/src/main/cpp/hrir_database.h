@@ -0,0 +1,89 @@
+#ifndef HRIR_DATABASE_H
+#define HRIR_DATABASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Read-only set of head-related impulse responses: one left/right pair per
+// measured direction, for a list of sample rates, memory-mapped from one
+// file. The binaural stage convolves with pairs derived from it (see
+// HrtfGrid and HrtfRenderer); nothing is decoded or resampled at load time,
+// so mapping a set costs page faults for the rates actually used and
+// nothing else.
+//
+// Directions follow the processor's convention: azimuth in degrees,
+// positive to the listener's right, -180..180; elevation -90..90, positive
+// up.
+//
+// File layout, native byte order (every Android ABI is little-endian):
+//   FileHeader
+//   int32_t    rates[rateCount]
+//   Direction  directions[measurementCount]
+//   float      taps[rateCount][measurementCount][2][length]    left, right
+// Files are produced by tools/cafetone_hrir.cpp, either from its spherical
+// head model or from a measured set (e.g. a SOFA file) dumped as text.
+class HrirDatabase {
+public:
+    static const uint32_t VERSION = 1;
+    static const int MAX_LENGTH = 4096;
+    static const char* const DEFAULT_PATH;
+
+    struct FileHeader {
+        char magic[4];              // "CTHR"
+        uint32_t version;
+        uint32_t rateCount;
+        uint32_t measurementCount;
+        uint32_t length;            // taps per ear
+        uint32_t reserved;
+    };
+
+    struct Direction {
+        float azimuth;
+        float elevation;
+    };
+
+    ~HrirDatabase();
+    HrirDatabase(const HrirDatabase&) = delete;
+    HrirDatabase& operator=(const HrirDatabase&) = delete;
+
+    // Maps and validates a set; nullptr if it is missing or malformed.
+    static std::unique_ptr<HrirDatabase> open(const char* path);
+
+    // The set at the default path, mapped once per process and shared by
+    // every instance through the SessionRegistry. nullptr if there is none;
+    // the next call looks again. Command thread only.
+    static std::shared_ptr<const HrirDatabase> shared();
+    // Replaces DEFAULT_PATH for later shared() calls that find no live set.
+    static void setDefaultPath(const std::string& path);
+
+    int length() const { return (int)m_header->length; }
+    int measurementCount() const { return (int)m_header->measurementCount; }
+    const Direction& direction(int measurement) const { return m_directions[measurement]; }
+    // Index of sampleRate in the set, or -1 if it was not built for it.
+    int rateIndex(int sampleRate) const;
+    // length() taps; ear 0 is left.
+    const float* taps(int rate, int measurement, int ear) const {
+        return m_taps + (((size_t)rate * m_header->measurementCount + measurement) * 2 + ear) * m_header->length;
+    }
+    // Measurement closest to a direction by great-circle distance.
+    int nearest(float azimuth, float elevation) const;
+
+    // Generator side: taps are rate-major as in the file.
+    static bool write(const char* path, const std::vector<int>& rates, const std::vector<Direction>& directions,
+                      int length, const std::vector<float>& taps);
+
+private:
+    HrirDatabase() = default;
+
+    void* m_mapping = nullptr;
+    size_t m_size = 0;
+    const FileHeader* m_header = nullptr;
+    const int32_t* m_rates = nullptr;
+    const Direction* m_directions = nullptr;
+    const float* m_taps = nullptr;
+};
+
+#endif // HRIR_DATABASE_H
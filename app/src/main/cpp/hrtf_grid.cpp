@@ -0,0 +1,272 @@
+#include "hrtf_grid.h"
+#include "fft.h"
+#include "fir_design.h"
+#include "hrtf_renderer.h"
+#include "session_registry.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const float kMaxItdMs = 1.0f;       // beyond any head; caps the filter length
+const float kMaxPhaseMs = 2.5f;     // minimum-phase response kept per ear
+
+// Unit vector of a direction: x ahead, y to the right, z up.
+void directionVector(float azimuth, float elevation, float (&v)[3]) {
+    const float az = azimuth * (float)M_PI / 180.0f;
+    const float el = elevation * (float)M_PI / 180.0f;
+    v[0] = cosf(el) * cosf(az);
+    v[1] = cosf(el) * sinf(az);
+    v[2] = sinf(el);
+}
+
+int nextPowerOfTwo(int n) {
+    int size = 1;
+    while (size < n) size <<= 1;
+    return size;
+}
+
+// Delay of the right ear behind the left in samples (negative: the left
+// lags), from the cross-correlation peak refined by a parabola.
+float interauralDelay(const float* left, const float* right, int length, int maxLag) {
+    auto correlation = [&](int lag) {
+        double sum = 0.0;
+        for (int n = std::max(0, -lag); n < length && n + lag < length; n++) {
+            sum += (double)left[n] * right[n + lag];
+        }
+        return sum;
+    };
+    int best = 0;
+    double bestValue = correlation(0);
+    for (int lag = -maxLag; lag <= maxLag; lag++) {
+        const double value = correlation(lag);
+        if (value > bestValue) {
+            bestValue = value;
+            best = lag;
+        }
+    }
+    if (best == -maxLag || best == maxLag) return (float)best;
+    const double before = correlation(best - 1);
+    const double after = correlation(best + 1);
+    const double curvature = before - 2.0 * bestValue + after;
+    const double offset = curvature < 0.0 ? 0.5 * (before - after) / curvature : 0.0;
+    return (float)(best + std::clamp(offset, -0.5, 0.5));
+}
+
+} // namespace
+
+std::shared_ptr<const HrtfGrid> HrtfGrid::acquire(const std::shared_ptr<const HrirDatabase>& hrirs, int sampleRate) {
+    if (!hrirs || hrirs->rateIndex(sampleRate) < 0) return nullptr;
+    std::shared_ptr<const HrtfGrid> grid =
+            SessionRegistry::acquire<HrtfGrid>(SessionRegistry::TABLE_HRTF_GRID, sampleRate, [&]() {
+                return build(hrirs, sampleRate).release();
+            });
+    // The live grid for this rate may come from another instance's set
+    if (grid && grid->source() == hrirs.get()) return grid;
+    return build(hrirs, sampleRate);
+}
+
+std::unique_ptr<HrtfGrid> HrtfGrid::build(const std::shared_ptr<const HrirDatabase>& hrirs, int sampleRate) {
+    const int rate = hrirs ? hrirs->rateIndex(sampleRate) : -1;
+    if (rate < 0) return nullptr;
+    std::unique_ptr<HrtfGrid> grid(new HrtfGrid());
+    grid->m_source = hrirs;
+    grid->m_sampleRate = sampleRate;
+    grid->m_length = std::min(nextPowerOfTwo((int)ceilf(sampleRate * kMaxPhaseMs / 1000.0f)), (int)MAX_LENGTH);
+    const int length = grid->m_length;
+
+    // Per measurement: the ears' delays and minimum-phase responses
+    const int measurements = hrirs->measurementCount();
+    const int irLength = hrirs->length();
+    const int maxLag = (int)ceilf(sampleRate * kMaxItdMs / 1000.0f);
+    const RealFft fft(2 * nextPowerOfTwo(std::max(irLength, length)));
+    std::vector<float> padded(fft.size(), 0.0f), re(fft.bins()), im(fft.bins()), magnitudeDb(fft.bins());
+    std::vector<float> minimumPhase((size_t)measurements * 2 * length);
+    std::vector<float> measuredDelays((size_t)measurements * 2);
+    std::vector<float> vectors((size_t)measurements * 3);
+    const float binsPerHz = (float)fft.size() / (float)sampleRate;
+    auto targetDb = [&](float frequency) {
+        const float x = std::min(frequency * binsPerHz, (float)(fft.bins() - 1));
+        const int bin = std::min((int)x, fft.bins() - 2);
+        return magnitudeDb[bin] + (x - (float)bin) * (magnitudeDb[bin + 1] - magnitudeDb[bin]);
+    };
+    for (int m = 0; m < measurements; m++) {
+        const float* left = hrirs->taps(rate, m, 0);
+        const float* right = hrirs->taps(rate, m, 1);
+        const float itd = interauralDelay(left, right, irLength, maxLag);
+        measuredDelays[2 * m] = std::max(-itd, 0.0f);
+        measuredDelays[2 * m + 1] = std::max(itd, 0.0f);
+        for (int ear = 0; ear < 2; ear++) {
+            std::copy(ear == 0 ? left : right, (ear == 0 ? left : right) + irLength, padded.begin());
+            fft.forward(padded.data(), re.data(), im.data());
+            for (int k = 0; k < fft.bins(); k++) {
+                magnitudeDb[k] = 20.0f * log10f(std::max(sqrtf(re[k] * re[k] + im[k] * im[k]), 1e-6f));
+            }
+            const std::vector<float> taps =
+                    FirDesign::design(targetDb, length, FirDesign::MINIMUM_PHASE, sampleRate);
+            std::copy(taps.begin(), taps.end(), minimumPhase.begin() + ((size_t)m * 2 + ear) * length);
+        }
+        const HrirDatabase::Direction& d = hrirs->direction(m);
+        float v[3];
+        directionVector(d.azimuth, d.elevation, v);
+        std::copy(v, v + 3, vectors.begin() + (size_t)m * 3);
+    }
+
+    // Per grid point: the three nearest measurements, weighted by the
+    // inverse square of their angles
+    grid->m_taps.assign((size_t)ELEVATIONS * AZIMUTHS * 2 * length, 0.0f);
+    grid->m_delays.assign((size_t)ELEVATIONS * AZIMUTHS * 2, 0.0f);
+    float maxDelay = 0.0f;
+    for (int ring = 0; ring < ELEVATIONS; ring++) {
+        for (int a = 0; a < AZIMUTHS; a++) {
+            float target[3];
+            directionVector((float)(a * AZIMUTH_STEP - 180), (float)(MIN_ELEVATION + ring * ELEVATION_STEP), target);
+            int nearest[3] = { -1, -1, -1 };
+            float cosines[3] = { -2.0f, -2.0f, -2.0f };
+            for (int m = 0; m < measurements; m++) {
+                const float* v = &vectors[(size_t)m * 3];
+                float c = v[0] * target[0] + v[1] * target[1] + v[2] * target[2];
+                int index = m;
+                for (int i = 0; i < 3; i++) {
+                    if (c > cosines[i]) {
+                        std::swap(c, cosines[i]);
+                        std::swap(index, nearest[i]);
+                    }
+                }
+            }
+            float weights[3] = {};
+            float total = 0.0f;
+            for (int i = 0; i < 3 && nearest[i] >= 0; i++) {
+                const float angle = acosf(std::clamp(cosines[i], -1.0f, 1.0f));
+                if (angle < 1e-4f) {
+                    // On a measurement: take it as it is
+                    std::fill(weights, weights + 3, 0.0f);
+                    weights[i] = total = 1.0f;
+                    break;
+                }
+                weights[i] = 1.0f / (angle * angle);
+                total += weights[i];
+            }
+            const size_t point = (size_t)ring * AZIMUTHS + a;
+            for (int i = 0; i < 3; i++) {
+                if (weights[i] == 0.0f) continue;
+                const float w = weights[i] / total;
+                for (int ear = 0; ear < 2; ear++) {
+                    const float* from = &minimumPhase[((size_t)nearest[i] * 2 + ear) * length];
+                    float* to = &grid->m_taps[(point * 2 + ear) * length];
+                    for (int n = 0; n < length; n++) to[n] += w * from[n];
+                    grid->m_delays[point * 2 + ear] += w * measuredDelays[(size_t)nearest[i] * 2 + ear];
+                }
+            }
+            maxDelay = std::max({ maxDelay, grid->m_delays[point * 2], grid->m_delays[point * 2 + 1] });
+        }
+    }
+    grid->m_filterLength = length + (int)ceilf(maxDelay) + FRACTIONAL_TAPS;
+
+    // Level reference: the speaker pair on the horizon
+    const int horizon = -MIN_ELEVATION / ELEVATION_STEP;
+    const int spread = (int)(HrtfRenderer::SPEAKER_SPREAD / AZIMUTH_STEP);
+    double energy = 0.0;
+    for (int a : { AZIMUTHS / 2 - spread, AZIMUTHS / 2 + spread }) {
+        for (int ear = 0; ear < 2; ear++) {
+            const float* taps = grid->taps(horizon, a, ear);
+            for (int n = 0; n < length; n++) energy += (double)taps[n] * taps[n];
+        }
+    }
+    const float gain = energy > 0.0 ? (float)(1.0 / sqrt(energy / 2.0)) : 1.0f;
+    for (float& tap : grid->m_taps) tap *= gain;
+    return grid;
+}
+
+void HrtfGrid::blend(float azimuth, float elevation, float* left, float* right) const {
+    azimuth = fmodf(azimuth + 180.0f, 360.0f);
+    if (azimuth < 0.0f) azimuth += 360.0f;
+    const float x = azimuth / AZIMUTH_STEP;
+    const int a0 = std::min((int)x, AZIMUTHS - 1);
+    const int a1 = (a0 + 1) % AZIMUTHS;
+    const float fa = std::min(x - (float)a0, 1.0f);
+    const float y = (std::clamp(elevation, (float)MIN_ELEVATION, 90.0f) - MIN_ELEVATION) / ELEVATION_STEP;
+    const int r0 = std::min((int)y, ELEVATIONS - 2);
+    const int r1 = r0 + 1;
+    const float fr = y - (float)r0;
+    const int corners[4][2] = { { r0, a0 }, { r0, a1 }, { r1, a0 }, { r1, a1 } };
+    const float weights[4] = { (1.0f - fa) * (1.0f - fr), fa * (1.0f - fr), (1.0f - fa) * fr, fa * fr };
+
+    for (int ear = 0; ear < 2; ear++) {
+        float* out = ear == 0 ? left : right;
+        std::fill(out, out + m_filterLength, 0.0f);
+        float delay = DELAY;
+        for (int c = 0; c < 4; c++) {
+            delay += weights[c] * m_delays[((size_t)corners[c][0] * AZIMUTHS + corners[c][1]) * 2 + ear];
+        }
+        // Hann-windowed sinc centred on the fraction, normalized for unit DC
+        const int whole = (int)delay;
+        const float fraction = delay - (float)whole;
+        float kernel[FRACTIONAL_TAPS];
+        float sum = 0.0f;
+        for (int j = 0; j < FRACTIONAL_TAPS; j++) {
+            const float t = (float)(j - FRACTIONAL_TAPS / 2 + 1) - fraction;
+            const float sinc = fabsf(t) < 1e-6f ? 1.0f : sinf((float)M_PI * t) / ((float)M_PI * t);
+            kernel[j] = sinc * (0.5f + 0.5f * cosf((float)M_PI * t / (FRACTIONAL_TAPS / 2)));
+            sum += kernel[j];
+        }
+        for (float& k : kernel) k /= sum;
+        const float* corner[4];
+        for (int c = 0; c < 4; c++) corner[c] = taps(corners[c][0], corners[c][1], ear);
+        float* shifted = out + whole - DELAY;
+        for (int n = 0; n < m_length; n++) {
+            const float tap = (weights[0] * corner[0][n] + weights[1] * corner[1][n] + weights[2] * corner[2][n] +
+                               weights[3] * corner[3][n]);
+            for (int j = 0; j < FRACTIONAL_TAPS; j++) shifted[n + j] += tap * kernel[j];
+        }
+    }
+}
+
+const HrtfPairCache::Pair& HrtfPairCache::lookup(const HrtfGrid& grid, float azimuth, float elevation,
+                                                 int partitionSize) {
+    const int az = (int)lroundf(azimuth / RESOLUTION);
+    const int el = (int)lroundf(elevation / RESOLUTION);
+    const int key = ((az % 360 + 360) % 360) * 1000 + el + 500;
+    m_clock++;
+    for (Entry& entry : m_entries) {
+        if (entry.key == key) {
+            entry.lastUse = m_clock;
+            m_hits++;
+            return entry.pair;
+        }
+    }
+    m_misses++;
+    Entry* slot;
+    if ((int)m_entries.size() < CAPACITY) {
+        m_entries.push_back(Entry());
+        slot = &m_entries.back();
+    } else {
+        slot = &*std::min_element(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) {
+            return a.lastUse < b.lastUse;
+        });
+    }
+    const int length = grid.filterLength();
+    m_scratch.resize(2 * (size_t)length);
+    grid.blend((float)(az * RESOLUTION), (float)(el * RESOLUTION), m_scratch.data(), m_scratch.data() + length);
+    slot->key = key;
+    slot->lastUse = m_clock;
+    for (int ear = 0; ear < 2; ear++) {
+        slot->pair.ears[ear] = std::make_shared<FirPartitions>(m_scratch.data() + ear * (size_t)length, length,
+                                                               partitionSize);
+    }
+    return slot->pair;
+}
+
+void HrtfPairCache::clear() {
+    m_entries.clear();
+}
+
+size_t HrtfPairCache::bytes() const {
+    size_t total = m_scratch.capacity() * sizeof(float);
+    for (const Entry& entry : m_entries) {
+        for (const std::shared_ptr<const FirPartitions>& ear : entry.pair.ears) {
+            total += (size_t)ear->partitionCount() * ear->bins() * 2 * sizeof(float);
+        }
+    }
+    return total;
+}
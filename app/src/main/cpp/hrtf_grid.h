@@ -0,0 +1,125 @@
+#ifndef HRTF_GRID_H
+#define HRTF_GRID_H
+
+#include "hrir_database.h"
+#include "partitioned_convolver.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// An HRIR set resampled onto a regular direction grid for one sample rate:
+// every AZIMUTH_STEP degrees of azimuth on rings ELEVATION_STEP degrees
+// apart, from MIN_ELEVATION up to overhead. Each point holds a
+// minimum-phase left/right pair and the two ears' delays that minimum phase
+// took out of it.
+//
+// Measured responses carry their onsets in their phase, so two of them
+// cannot simply be averaged: the blend of two pulses a few samples apart is
+// a comb. Minimum-phase pairs all start at zero, so any direction between
+// grid points is the bilinear blend of its four neighbours' taps, with the
+// blended delays put back through a short fractional-delay interpolator.
+// That blend is all a direction change costs; HrtfPairCache keeps the
+// recent ones.
+//
+// Building a grid does the expensive part once per set and rate, on the
+// command thread: per measurement, a magnitude spectrum, a minimum-phase
+// design per ear (FirDesign) and the interaural delay from the peak of the
+// ears' cross-correlation; per grid point, an inverse-distance blend of the
+// three nearest measurements. Levels are normalized like a pair of speakers
+// HrtfRenderer::SPEAKER_SPREAD degrees either side of straight ahead: their
+// uncorrelated signals reach each ear at their own level, on average over
+// the ears. Measured sets come at arbitrary levels; this makes them
+// comparable.
+//
+// At 44.1 and 48 kHz a grid is 1008 points of two 128-tap filters, about
+// 1 MB, built in about 70 ms on an x86 build host; 96 kHz doubles both.
+// Grids are shared through the SessionRegistry.
+class HrtfGrid {
+public:
+    static const int AZIMUTH_STEP = 5;              // degrees
+    static const int ELEVATION_STEP = 10;
+    static const int MIN_ELEVATION = -40;           // lower directions get this ring
+    static const int AZIMUTHS = 360 / AZIMUTH_STEP;
+    static const int ELEVATIONS = (90 - MIN_ELEVATION) / ELEVATION_STEP + 1;
+    static const int MAX_LENGTH = 256;              // minimum-phase taps per ear
+    static const int FRACTIONAL_TAPS = 8;           // windowed-sinc delay interpolator
+    static const int DELAY = FRACTIONAL_TAPS / 2 - 1;  // added to every blended pair
+
+    // The grid for hrirs at sampleRate, shared by every instance using the
+    // same set at that rate; nullptr if the set has no responses for it.
+    // Command thread.
+    static std::shared_ptr<const HrtfGrid> acquire(const std::shared_ptr<const HrirDatabase>& hrirs,
+                                                   int sampleRate);
+    // A private grid, built whether or not one is shared.
+    static std::unique_ptr<HrtfGrid> build(const std::shared_ptr<const HrirDatabase>& hrirs, int sampleRate);
+
+    const HrirDatabase* source() const { return m_source.get(); }
+    int sampleRate() const { return m_sampleRate; }
+    // Minimum-phase taps per ear and grid point.
+    int length() const { return m_length; }
+    // Taps per ear blend() produces: length() plus room for the delays.
+    int filterLength() const { return m_filterLength; }
+    // Heap memory of the points, taps and delays.
+    size_t bytes() const { return (m_taps.size() + m_delays.size()) * sizeof(float); }
+
+    // Left and right responses for a direction, filterLength() taps each,
+    // delayed by DELAY plus each ear's share of the interaural delay.
+    void blend(float azimuth, float elevation, float* left, float* right) const;
+
+private:
+    HrtfGrid() = default;
+
+    const float* taps(int ring, int azimuth, int ear) const {
+        return m_taps.data() + (((size_t)ring * AZIMUTHS + azimuth) * 2 + ear) * m_length;
+    }
+
+    std::shared_ptr<const HrirDatabase> m_source;   // also what the grid is shared by
+    int m_sampleRate = 0;
+    int m_length = 0;
+    int m_filterLength = 0;
+    std::vector<float> m_taps;      // [ring][azimuth][ear][m_length]
+    std::vector<float> m_delays;    // [ring][azimuth][ear], samples
+};
+
+// The pairs an instance rendered lately, as the convolvers' partition
+// spectra, least recently used first out. A hit costs a lookup; a miss a
+// grid blend and the partitions' transforms, so sweeping back and forth
+// over the same directions costs no blends. Directions are quantized to
+// RESOLUTION degrees. Command thread, one cache per instance;
+// designs keep the spectra they use alive after eviction.
+class HrtfPairCache {
+public:
+    static const int CAPACITY = 16;
+    static const int RESOLUTION = 1;                // degrees
+
+    struct Pair {
+        std::shared_ptr<const FirPartitions> ears[2];    // 0 is left
+    };
+
+    // The pair for a direction from grid, cut into partitionSize blocks.
+    const Pair& lookup(const HrtfGrid& grid, float azimuth, float elevation, int partitionSize);
+    // Call when the grid changes.
+    void clear();
+
+    int size() const { return (int)m_entries.size(); }
+    // Partition spectra of the cached pairs, plus the blend scratch.
+    size_t bytes() const;
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+
+private:
+    struct Entry {
+        int key;
+        uint64_t lastUse;
+        Pair pair;
+    };
+
+    std::vector<Entry> m_entries;
+    std::vector<float> m_scratch;   // blend output, both ears
+    uint64_t m_clock = 0;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+};
+
+#endif // HRTF_GRID_H
@@ -0,0 +1,126 @@
+#include "hrtf_renderer.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+const size_t HrtfRenderer::STATE_BYTES =
+        4 * PartitionedConvolver::stateFloats(PARTITION, MAX_TAPS / PARTITION) * sizeof(float);
+
+namespace {
+
+float wrapAzimuth(float azimuth) {
+    azimuth = fmodf(azimuth + 180.0f, 360.0f);
+    if (azimuth < 0.0f) azimuth += 360.0f;
+    return azimuth - 180.0f;
+}
+
+} // namespace
+
+HrtfRenderer::~HrtfRenderer() {
+    delete m_fading;
+    delete m_active;
+}
+
+std::unique_ptr<HrtfRenderer::Design> HrtfRenderer::design(const HrtfGrid& grid, HrtfPairCache& pairs,
+                                                           float azimuth, float elevation) {
+    auto result = std::make_unique<Design>();
+    for (int speaker = 0; speaker < 2; speaker++) {
+        const float offset = speaker == 0 ? -SPEAKER_SPREAD : SPEAKER_SPREAD;
+        const HrtfPairCache::Pair& pair = pairs.lookup(grid, wrapAzimuth(azimuth + offset), elevation, PARTITION);
+        result->filters[speaker][0] = pair.ears[0];
+        result->filters[speaker][1] = pair.ears[1];
+    }
+    result->delay = HrtfGrid::DELAY;
+    return result;
+}
+
+std::unique_ptr<HrtfRenderer::Design> HrtfRenderer::design(const float* const (&taps)[2][2], int length,
+                                                           float gain) {
+    auto result = std::make_unique<Design>();
+    length = std::min(length, (int)MAX_TAPS);
+    if (length <= 0) return result;
+    std::vector<float> scaled(length);
+    for (int speaker = 0; speaker < 2; speaker++) {
+        for (int ear = 0; ear < 2; ear++) {
+            for (int i = 0; i < length; i++) scaled[i] = taps[speaker][ear][i] * gain;
+            result->filters[speaker][ear] = std::make_shared<FirPartitions>(scaled.data(), length, PARTITION);
+        }
+    }
+    return result;
+}
+
+void HrtfRenderer::setStorage(float* storage) {
+    const size_t floats = STATE_BYTES / sizeof(float) / 4;
+    for (int i = 0; i < 4; i++) {
+        m_convolvers[i / 2][i % 2].setStorage(storage ? storage + i * floats : nullptr);
+    }
+    if (storage) configure();
+}
+
+void HrtfRenderer::configure() {
+    if (!m_active || !m_active->filters[0][0] || !m_convolvers[0][0].hasStorage()) return;
+    const int count = m_active->filters[0][0]->partitionCount();
+    for (PartitionedConvolver (&speaker)[2] : m_convolvers) {
+        for (PartitionedConvolver& convolver : speaker) convolver.configure(PARTITION, count);
+    }
+}
+
+void HrtfRenderer::clear() {
+    for (PartitionedConvolver (&speaker)[2] : m_convolvers) {
+        for (PartitionedConvolver& convolver : speaker) convolver.clear();
+    }
+    if (m_fading) {
+        // The crossfade is abandoned with the signal it was blending
+        m_mailbox.retire(m_fading);
+        m_fading = nullptr;
+    }
+}
+
+bool HrtfRenderer::update() {
+    if (m_fading && !m_convolvers[0][0].isCrossfading()) {
+        // All four compute their blocks together; make sure none holds on
+        for (PartitionedConvolver (&speaker)[2] : m_convolvers) {
+            for (PartitionedConvolver& convolver : speaker) convolver.crossfadeFrom(nullptr);
+        }
+        m_mailbox.retire(m_fading);
+        m_fading = nullptr;
+    }
+    if (m_fading) return false;
+    Design* next = m_mailbox.take();
+    if (!next) return false;
+
+    const bool wasActive = m_active && m_active->filters[0][0];
+    const bool nowActive = next->filters[0][0] != nullptr;
+    Design* previous = m_active;
+    m_active = next;
+    if (wasActive && nowActive &&
+        previous->filters[0][0]->partitionCount() == next->filters[0][0]->partitionCount() &&
+        m_convolvers[0][0].hasStorage()) {
+        for (int speaker = 0; speaker < 2; speaker++) {
+            for (int ear = 0; ear < 2; ear++) {
+                m_convolvers[speaker][ear].crossfadeFrom(previous->filters[speaker][ear].get());
+            }
+        }
+        m_fading = previous;
+    } else {
+        configure();
+        if (previous) m_mailbox.retire(previous);
+    }
+    return wasActive != nowActive;
+}
+
+void HrtfRenderer::process(const float* leftIn, const float* rightIn, float* leftOut, float* rightOut, int frames) {
+    const Design& design = *m_active;
+    for (int done = 0; done < frames; done += CHUNK_FRAMES) {
+        const int n = std::min(frames - done, (int)CHUNK_FRAMES);
+        // The crossed paths first: the direct ones may overwrite their input
+        m_convolvers[0][1].process(leftIn + done, m_cross[1], n, *design.filters[0][1]);
+        m_convolvers[1][0].process(rightIn + done, m_cross[0], n, *design.filters[1][0]);
+        m_convolvers[0][0].process(leftIn + done, leftOut + done, n, *design.filters[0][0]);
+        m_convolvers[1][1].process(rightIn + done, rightOut + done, n, *design.filters[1][1]);
+        for (int i = 0; i < n; i++) {
+            leftOut[done + i] += m_cross[0][i];
+            rightOut[done + i] += m_cross[1][i];
+        }
+    }
+}
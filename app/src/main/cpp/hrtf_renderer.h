@@ -0,0 +1,87 @@
+#ifndef HRTF_RENDERER_H
+#define HRTF_RENDERER_H
+
+#include "design_mailbox.h"
+#include "hrtf_grid.h"
+#include "partitioned_convolver.h"
+#include <memory>
+
+// The convolution engine behind BinauralProcessor's HRTF mode. The stereo
+// input plays as two virtual loudspeakers SPEAKER_SPREAD degrees either
+// side of the listening direction, and each speaker reaches each ear
+// through its own head-related impulse response: four partitioned
+// convolvers, ears summed.
+//
+// Cost per source (one speaker, both ears) is two convolvers: per
+// PARTITION frames, two forward and two inverse FFTs of 2 * PARTITION
+// points and 2 * ceil(taps / PARTITION) complex multiply-adds per bin.
+// The FFTs dominate, so the cost hardly depends on the response length:
+// on an x86 build host (cafetone-bench, stage binaural_hrtf) it is about
+// 40 ns per frame and source with 256-tap pairs at 48 kHz and 52 ns with
+// 512 taps, about 0.4% of one core for the stereo pair. A direction change
+// adds the previous filters' accumulate and inverse for one partition.
+//
+// Designs come from the command thread through a DesignMailbox, like the
+// FIR EQ's. A new direction crossfades in over one partition; a design
+// with another filter length restarts the convolvers. Responses for a
+// direction come from an HrtfGrid through an HrtfPairCache, so making a
+// design is a cache lookup or a grid blend, never a filter design.
+class HrtfRenderer {
+public:
+    static const int PARTITION = 64;            // latency in frames
+    static const int MAX_TAPS = 512;            // longer responses are cut
+    static constexpr float SPEAKER_SPREAD = 30.0f;
+    static const size_t STATE_BYTES;            // four convolvers at MAX_TAPS
+
+    struct Design {
+        // filters[speaker][ear], 0 is left; nullptr: engine off. Shared
+        // with the HrtfPairCache they came from.
+        std::shared_ptr<const FirPartitions> filters[2][2];
+        int delay = 0;          // frames ahead of the earlier ear's onset
+    };
+
+    // Command thread. The grid's pairs for the two speakers around
+    // (azimuth, elevation), through pairs.
+    static std::unique_ptr<Design> design(const HrtfGrid& grid, HrtfPairCache& pairs, float azimuth,
+                                          float elevation);
+    // From responses taps[speaker][ear] of length taps each, times gain.
+    static std::unique_ptr<Design> design(const float* const (&taps)[2][2], int length, float gain = 1.0f);
+
+    HrtfRenderer() = default;
+    ~HrtfRenderer();
+    HrtfRenderer(const HrtfRenderer&) = delete;
+    HrtfRenderer& operator=(const HrtfRenderer&) = delete;
+
+    // Command thread: queues a design (an empty one switches the engine
+    // off), replacing one the audio thread has not picked up yet.
+    void post(std::unique_ptr<Design> design) { m_mailbox.post(std::move(design)); }
+    // Command thread: frees designs the audio thread has let go of.
+    void collect() { m_mailbox.collect(); }
+
+    // Audio thread. STATE_BYTES of storage; nullptr unbinds.
+    void setStorage(float* storage);
+    // Installs a posted design. Returns true when the engine was switched on
+    // or off, so the caller can reset whatever it ran instead.
+    bool update();
+    bool isActive() const { return m_active && m_active->filters[0][0] && m_convolvers[0][0].hasStorage(); }
+    // The partition plus the responses' own bulk delay, so the dry path
+    // lines up with the earlier ear of a source straight ahead.
+    int latency() const { return isActive() ? PARTITION + m_active->delay : 0; }
+    int tailSamples() const { return isActive() ? PARTITION + m_active->filters[0][0]->length() : 0; }
+    void clear();
+    // leftOut/rightOut may alias leftIn/rightIn.
+    void process(const float* leftIn, const float* rightIn, float* leftOut, float* rightOut, int frames);
+
+private:
+    static const int CHUNK_FRAMES = 256;
+
+    void configure();
+
+    DesignMailbox<Design> m_mailbox;
+    Design* m_active = nullptr;       // audio thread
+    Design* m_fading = nullptr;       // audio thread, until the crossfade ends
+    PartitionedConvolver m_convolvers[2][2];
+    float m_cross[2][CHUNK_FRAMES];   // each ear's share of the opposite speaker
+};
+
+#endif // HRTF_RENDERER_H
@@ -0,0 +1,120 @@
+#include "partitioned_convolver.h"
+#include <algorithm>
+#include <cstring>
+
+FirPartitions::FirPartitions(const float* taps, int length, int partitionSize)
+    : m_partitionSize(partitionSize)
+    , m_count(std::max(1, (length + partitionSize - 1) / partitionSize))
+    , m_length(length)
+    , m_fft(RealFft::forSize(2 * partitionSize)) {
+    const int bins = partitionSize + 1;
+    m_re.resize((size_t)m_count * bins);
+    m_im.resize((size_t)m_count * bins);
+    const float scale = 1.0f / (float)(2 * partitionSize);
+    std::vector<float> block(2 * partitionSize);
+    for (int k = 0; k < m_count; k++) {
+        std::fill(block.begin(), block.end(), 0.0f);
+        const int offset = k * partitionSize;
+        const int count = std::min(partitionSize, length - offset);
+        for (int i = 0; i < count; i++) block[i] = taps[offset + i] * scale;
+        m_fft->forward(block.data(), m_re.data() + (size_t)k * bins, m_im.data() + (size_t)k * bins);
+    }
+}
+
+void PartitionedConvolver::configure(int partitionSize, int partitionCount) {
+    m_partitionSize = partitionSize;
+    m_partitionCount = partitionCount;
+    const size_t bins = (size_t)partitionSize + 1;
+    float* next = m_storage;
+    m_input = next;
+    next += 2 * partitionSize;
+    m_output = next;
+    next += partitionSize;
+    m_fade = next;
+    next += partitionSize;
+    m_delayRe = next;
+    next += bins * partitionCount;
+    m_delayIm = next;
+    next += bins * partitionCount;
+    m_accRe = next;
+    next += bins;
+    m_accIm = next;
+    clear();
+}
+
+void PartitionedConvolver::clear() {
+    if (m_storage && m_partitionSize > 0) {
+        memset(m_storage, 0, stateFloats(m_partitionSize, m_partitionCount) * sizeof(float));
+    }
+    m_position = 0;
+    m_newest = 0;
+    m_previous = nullptr;
+}
+
+void PartitionedConvolver::process(const float* input, float* output, int frames, const FirPartitions& filter) {
+    const int p = m_partitionSize;
+    int done = 0;
+    while (done < frames) {
+        // Fill the current block while playing out the last computed one;
+        // reading the output first keeps aliased in/out pointers correct.
+        const int n = std::min(frames - done, p - m_position);
+        float* pending = m_input + p + m_position;
+        const float* ready = m_output + m_position;
+        for (int i = 0; i < n; i++) {
+            const float sample = input[done + i];
+            output[done + i] = ready[i];
+            pending[i] = sample;
+        }
+        m_position += n;
+        done += n;
+        if (m_position == p) {
+            computeBlock(filter);
+            m_position = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::accumulate(const FirPartitions& filter, float* re, float* im) const {
+    const int bins = m_partitionSize + 1;
+    memset(re, 0, (size_t)bins * sizeof(float));
+    memset(im, 0, (size_t)bins * sizeof(float));
+    const int count = std::min(filter.partitionCount(), m_partitionCount);
+    // Partition k meets the input spectrum from k blocks ago
+    for (int k = 0; k < count; k++) {
+        int slot = m_newest - k;
+        if (slot < 0) slot += m_partitionCount;
+        const float* __restrict xRe = m_delayRe + (size_t)slot * bins;
+        const float* __restrict xIm = m_delayIm + (size_t)slot * bins;
+        const float* __restrict hRe = filter.re(k);
+        const float* __restrict hIm = filter.im(k);
+        for (int b = 0; b < bins; b++) {
+            re[b] += xRe[b] * hRe[b] - xIm[b] * hIm[b];
+            im[b] += xRe[b] * hIm[b] + xIm[b] * hRe[b];
+        }
+    }
+}
+
+void PartitionedConvolver::computeBlock(const FirPartitions& filter) {
+    const int p = m_partitionSize;
+    const size_t bins = (size_t)p + 1;
+    const RealFft& fft = filter.fft();
+
+    m_newest = m_newest + 1 == m_partitionCount ? 0 : m_newest + 1;
+    fft.forward(m_input, m_delayRe + m_newest * bins, m_delayIm + m_newest * bins);
+    memcpy(m_input, m_input + p, (size_t)p * sizeof(float));
+
+    // Overlap-save: the second half of the inverse is the linear convolution
+    accumulate(filter, m_accRe, m_accIm);
+    fft.inverseSecondHalf(m_accRe, m_accIm, m_output);
+
+    if (m_previous) {
+        accumulate(*m_previous, m_accRe, m_accIm);
+        fft.inverseSecondHalf(m_accRe, m_accIm, m_fade);
+        const float step = 1.0f / (float)p;
+        for (int i = 0; i < p; i++) {
+            const float g = (float)(i + 1) * step;
+            m_output[i] = m_fade[i] + (m_output[i] - m_fade[i]) * g;
+        }
+        m_previous = nullptr;
+    }
+}
@@ -0,0 +1,107 @@
+#ifndef PARTITIONED_CONVOLVER_H
+#define PARTITIONED_CONVOLVER_H
+
+#include "fft.h"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// An FIR filter cut into equal partitions of P taps, each held as the
+// spectrum of its 2P-point zero-padded FFT, ready for uniformly partitioned
+// overlap-save convolution. Built off the audio thread (it allocates and
+// runs one FFT per partition) and read-only afterwards, so the audio thread
+// can use it through a plain pointer.
+class FirPartitions {
+public:
+    FirPartitions(const float* taps, int length, int partitionSize);
+
+    int partitionSize() const { return m_partitionSize; }
+    int partitionCount() const { return m_count; }
+    int length() const { return m_length; }
+    int bins() const { return m_partitionSize + 1; }
+    // Spectrum of partition k, scaled by 1 / 2P for the unscaled inverse.
+    const float* re(int k) const { return m_re.data() + (size_t)k * bins(); }
+    const float* im(int k) const { return m_im.data() + (size_t)k * bins(); }
+    const RealFft& fft() const { return *m_fft; }
+
+private:
+    int m_partitionSize;
+    int m_count;
+    int m_length;
+    std::shared_ptr<const RealFft> m_fft;
+    std::vector<float> m_re;
+    std::vector<float> m_im;
+};
+
+// One channel of uniformly partitioned overlap-save convolution.
+//
+// Input is collected into blocks of P frames. Each completed block is
+// transformed once into a frequency-domain delay line of the last K input
+// spectra, multiplied with the K filter partitions, summed, and transformed
+// back, so a K-partition filter costs two FFTs of 2P points and K complex
+// multiply-adds per P frames. Output lags the input by exactly P frames
+// whatever the caller's block size: that is the latency/CPU trade the
+// partition size selects. Smaller partitions mean less latency and more
+// FFTs per frame; larger ones amortize better but do all their work in
+// every P-th call.
+//
+// The convolver owns no memory: setStorage() points it at stateFloats()
+// floats (an arena or a processor's own block), and configure() lays out a
+// geometry in them. A filter with the same geometry can replace the current
+// one at any time; crossfadeFrom() blends from the old filter's output to
+// the new one's over the next computed block, so swaps do not click.
+class PartitionedConvolver {
+public:
+    static constexpr size_t stateFloats(int partitionSize, int partitionCount) {
+        // input window, output block, crossfade block, delay line, accumulator
+        return (size_t)(2 * partitionSize + partitionSize + partitionSize) +
+               2 * (size_t)(partitionSize + 1) * (size_t)(partitionCount + 1);
+    }
+    // Enough for a filter of up to maxTaps at any power-of-two partition
+    // size between minPartition and maxPartition.
+    static constexpr size_t maxStateFloats(int maxTaps, int minPartition, int maxPartition) {
+        size_t floats = 0;
+        for (int p = minPartition; p <= maxPartition; p *= 2) {
+            size_t f = stateFloats(p, (maxTaps + p - 1) / p);
+            if (f > floats) floats = f;
+        }
+        return floats;
+    }
+
+    void setStorage(float* storage) { m_storage = storage; }
+    bool hasStorage() const { return m_storage != nullptr; }
+
+    // Lays out and clears the state for filters of this geometry.
+    void configure(int partitionSize, int partitionCount);
+    void clear();
+    int partitionSize() const { return m_partitionSize; }
+    int partitionCount() const { return m_partitionCount; }
+
+    // Blends from previous to the filter passed to process() over the next
+    // computed block. previous must stay valid until isCrossfading() is false.
+    void crossfadeFrom(const FirPartitions* previous) { m_previous = previous; }
+    bool isCrossfading() const { return m_previous != nullptr; }
+
+    // output may alias input. filter must match the configured geometry.
+    void process(const float* input, float* output, int frames, const FirPartitions& filter);
+
+private:
+    void computeBlock(const FirPartitions& filter);
+    void accumulate(const FirPartitions& filter, float* re, float* im) const;
+
+    float* m_storage = nullptr;
+    int m_partitionSize = 0;
+    int m_partitionCount = 0;
+    float* m_input = nullptr;        // 2P: previous block, block being filled
+    float* m_output = nullptr;       // P: last computed block, being played out
+    float* m_fade = nullptr;         // P: previous filter's block while crossfading
+    float* m_delayRe = nullptr;      // K spectra of P + 1 bins, ring
+    float* m_delayIm = nullptr;
+    float* m_accRe = nullptr;        // P + 1 bins
+    float* m_accIm = nullptr;
+    int m_position = 0;              // frames of the current block so far
+    int m_newest = 0;                // delay-line slot of the newest spectrum
+    const FirPartitions* m_previous = nullptr;
+};
+
+#endif // PARTITIONED_CONVOLVER_H
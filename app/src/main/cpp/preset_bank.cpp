@@ -0,0 +1,137 @@
+#include "preset_bank.h"
+#include "session_registry.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable<ChainCoeffs>::value, "ChainCoeffs is stored as raw bytes");
+
+static const char kMagic[4] = { 'C', 'T', 'P', 'B' };
+
+const char* const PresetBank::DEFAULT_PATH = "/vendor/etc/cafetone_presets.bin";
+
+namespace {
+
+std::mutex gPathLock;
+std::string gDefaultPath = PresetBank::DEFAULT_PATH;
+
+} // namespace
+
+ChainCoeffs ChainCoeffs::design(float intensity, float spatialWidth, float distance, float haasWidth,
+                                const DistanceTable& distanceTable) {
+    ChainCoeffs coeffs;
+    coeffs.intensity = intensity;
+    coeffs.spatialWidth = spatialWidth;
+    coeffs.distance = distance;
+    coeffs.eq = distanceTable.eq(distance);
+    coeffs.haas = HaasProcessor::designCoeffs(spatialWidth * 20.0f, haasWidth, distanceTable.sampleRate());
+    coeffs.binaural = BinauralProcessor::designCoeffs(distance, 1.0f + spatialWidth * 0.7f);
+    coeffs.distanceCompression = distance;
+    return coeffs;
+}
+
+PresetBank::~PresetBank() {
+    if (m_mapping) {
+        munmap(m_mapping, m_size);
+    }
+}
+
+std::unique_ptr<PresetBank> PresetBank::open(const char* path) {
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(FileHeader)) {
+        close(fd);
+        return nullptr;
+    }
+    void* mapping = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return nullptr;
+
+    std::unique_ptr<PresetBank> bank(new PresetBank());
+    bank->m_mapping = mapping;
+    bank->m_size = (size_t)st.st_size;
+
+    const auto* bytes = static_cast<const char*>(mapping);
+    const auto* header = reinterpret_cast<const FileHeader*>(bytes);
+    if (memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != VERSION ||
+        header->recordSize != sizeof(ChainCoeffs) || header->presetCount == 0 || header->rateCount == 0) {
+        return nullptr;
+    }
+    size_t ratesOffset = sizeof(FileHeader);
+    size_t namesOffset = ratesOffset + header->rateCount * sizeof(int32_t);
+    size_t recordsOffset = namesOffset + (size_t)header->presetCount * NAME_LENGTH;
+    size_t expected = recordsOffset + (size_t)header->presetCount * header->rateCount * sizeof(ChainCoeffs);
+    if (expected != bank->m_size) return nullptr;
+
+    bank->m_header = header;
+    bank->m_rates = reinterpret_cast<const int32_t*>(bytes + ratesOffset);
+    bank->m_names = bytes + namesOffset;
+    bank->m_records = reinterpret_cast<const ChainCoeffs*>(bytes + recordsOffset);
+    for (int i = 0; i < bank->presetCount(); i++) {
+        if (bank->name(i)[NAME_LENGTH - 1] != '\0') return nullptr;
+    }
+    return bank;
+}
+
+std::shared_ptr<const PresetBank> PresetBank::shared() {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> guard(gPathLock);
+        path = gDefaultPath;
+    }
+    return SessionRegistry::acquire<PresetBank>(SessionRegistry::TABLE_PRESET_BANK, 0, [&path]() {
+        return open(path.c_str()).release();
+    });
+}
+
+void PresetBank::setDefaultPath(const std::string& path) {
+    std::lock_guard<std::mutex> guard(gPathLock);
+    gDefaultPath = path;
+}
+
+int PresetBank::find(const char* name) const {
+    for (int i = 0; i < presetCount(); i++) {
+        if (strncmp(this->name(i), name, NAME_LENGTH) == 0) return i;
+    }
+    return -1;
+}
+
+const ChainCoeffs* PresetBank::record(int preset, int sampleRate) const {
+    if (preset < 0 || preset >= presetCount()) return nullptr;
+    for (uint32_t r = 0; r < m_header->rateCount; r++) {
+        if (m_rates[r] == sampleRate) return &m_records[(size_t)preset * m_header->rateCount + r];
+    }
+    return nullptr;
+}
+
+bool PresetBank::write(const char* path, const std::vector<std::string>& names, const std::vector<int>& rates,
+                       const std::vector<ChainCoeffs>& records) {
+    if (names.empty() || rates.empty() || records.size() != names.size() * rates.size()) return false;
+    FileHeader header{};
+    memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = VERSION;
+    header.recordSize = sizeof(ChainCoeffs);
+    header.presetCount = (uint32_t)names.size();
+    header.rateCount = (uint32_t)rates.size();
+
+    FILE* fp = fopen(path, "wb");
+    if (!fp) return false;
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+    for (int rate : rates) {
+        int32_t value = rate;
+        ok = ok && fwrite(&value, sizeof(value), 1, fp) == 1;
+    }
+    for (const std::string& name : names) {
+        char field[NAME_LENGTH] = {};
+        strncpy(field, name.c_str(), NAME_LENGTH - 1);
+        ok = ok && fwrite(field, sizeof(field), 1, fp) == 1;
+    }
+    ok = ok && fwrite(records.data(), sizeof(ChainCoeffs), records.size(), fp) == records.size();
+    return fclose(fp) == 0 && ok;
+}
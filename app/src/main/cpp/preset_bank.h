@@ -0,0 +1,98 @@
+#ifndef PRESET_BANK_H
+#define PRESET_BANK_H
+
+#include "eq_processor.h"
+#include "haas_processor.h"
+#include "binaural_processor.h"
+#include "distance_table.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Everything the chain derives from the three user parameters at one sample
+// rate. A ChainSnapshot carries one, and a preset file stores one per
+// preset and rate, written and mapped as is.
+struct ChainCoeffs {
+    float intensity;
+    float spatialWidth;
+    float distance;
+    EQProcessor::Coeffs eq;
+    HaasProcessor::Coeffs haas;
+    BinauralProcessor::Coeffs binaural;
+    float distanceCompression;      // DynamicProcessor only stores it
+
+    // haasWidth is the Haas processor's own width setting, not a user
+    // parameter. The EQ comes from the table, which also fixes the rate.
+    static ChainCoeffs design(float intensity, float spatialWidth, float distance, float haasWidth,
+                              const DistanceTable& distanceTable);
+};
+
+// Read-only bank of named presets, each holding its fully derived
+// ChainCoeffs for a list of sample rates, memory-mapped from one file.
+// Selecting a preset is then a copy into the next snapshot: no trig, no
+// pow, and one parameter command instead of one per user parameter.
+//
+// File layout, native byte order (every Android ABI is little-endian):
+//   FileHeader
+//   int32_t    rates[rateCount]
+//   char       names[presetCount][NAME_LENGTH]     NUL-terminated
+//   ChainCoeffs records[presetCount][rateCount]
+// Files are produced by tools/cafetone_presets.cpp. The record size is part
+// of the header, so a file from a build with a different ChainCoeffs layout
+// is refused rather than misread.
+class PresetBank {
+public:
+    static const int NAME_LENGTH = 32;
+    static const uint32_t VERSION = 1;
+    static const char* const DEFAULT_PATH;
+
+    struct FileHeader {
+        char magic[4];              // "CTPB"
+        uint32_t version;
+        uint32_t recordSize;        // sizeof(ChainCoeffs)
+        uint32_t presetCount;
+        uint32_t rateCount;
+        uint32_t reserved;
+    };
+
+    ~PresetBank();
+    PresetBank(const PresetBank&) = delete;
+    PresetBank& operator=(const PresetBank&) = delete;
+
+    // Maps and validates a bank; nullptr if it is missing or malformed.
+    static std::unique_ptr<PresetBank> open(const char* path);
+
+    // The bank at the default path, mapped once per process and shared by
+    // every instance through the SessionRegistry. nullptr if there is none;
+    // the next call looks again. Command thread only.
+    static std::shared_ptr<const PresetBank> shared();
+    // Replaces DEFAULT_PATH for later shared() calls that find no live bank.
+    static void setDefaultPath(const std::string& path);
+
+    int presetCount() const { return (int)m_header->presetCount; }
+    const char* name(int preset) const { return m_names + (size_t)preset * NAME_LENGTH; }
+    // Index of the preset called name, or -1.
+    int find(const char* name) const;
+    // nullptr if the bank was not built for sampleRate.
+    const ChainCoeffs* record(int preset, int sampleRate) const;
+    // Any rate's record; the user parameter values are the same in all.
+    const ChainCoeffs& anyRecord(int preset) const { return m_records[(size_t)preset * m_header->rateCount]; }
+
+    // Generator side: records are preset-major, rates.size() per preset.
+    static bool write(const char* path, const std::vector<std::string>& names, const std::vector<int>& rates,
+                      const std::vector<ChainCoeffs>& records);
+
+private:
+    PresetBank() = default;
+
+    void* m_mapping = nullptr;
+    size_t m_size = 0;
+    const FileHeader* m_header = nullptr;
+    const int32_t* m_rates = nullptr;
+    const char* m_names = nullptr;
+    const ChainCoeffs* m_records = nullptr;
+};
+
+#endif // PRESET_BANK_H
@@ -0,0 +1,97 @@
+#include "quality_governor.h"
+#include <algorithm>
+#include <climits>
+
+QualityGovernor::QualityGovernor()
+    : m_requestedTier(QUALITY_FULL)
+    , m_automatic(true)
+    , m_smoothedLoad(0.0f)
+    , m_sinceChangeNs(0)
+    , m_lowLoadNs(0)
+    , m_stepUpHoldMs(STEP_UP_HOLD_MS)
+    , m_lastChangeWasUp(false)
+    , m_activeTier(QUALITY_FULL)
+    , m_reportedRequest(QUALITY_FULL)
+    , m_reportedAutomatic(true)
+    , m_stepDowns(0)
+    , m_stepUps(0)
+    , m_loadPermille(0) {
+}
+
+bool QualityGovernor::configure(int requestedTier, bool automatic) {
+    m_requestedTier = std::clamp(requestedTier, (int)QUALITY_FULL, NUM_QUALITY_TIERS - 1);
+    m_automatic = automatic;
+    m_reportedRequest.store(m_requestedTier, std::memory_order_relaxed);
+    m_reportedAutomatic.store(automatic, std::memory_order_relaxed);
+
+    // The governor may hold a cheaper tier than requested, never a better one
+    int active = activeTier();
+    int tier = automatic ? std::max(active, m_requestedTier) : m_requestedTier;
+    if (tier == active) return false;
+    m_stepUpHoldMs = STEP_UP_HOLD_MS;
+    m_lastChangeWasUp = false;
+    return setActive(tier);
+}
+
+bool QualityGovernor::update(uint64_t elapsedNs, int frames, int sampleRate) {
+    if (sampleRate <= 0 || frames <= 0) return false;
+    uint64_t periodNs = (uint64_t)frames * 1000000000ull / (uint64_t)sampleRate;
+    if (periodNs == 0) return false;
+
+    // Exponential average with a time constant of LOAD_WINDOW_MS whatever
+    // the buffer size
+    float load = (float)elapsedNs / (float)periodNs;
+    float alpha = std::min(1.0f, (float)periodNs / (LOAD_WINDOW_MS * 1000000.0f));
+    m_smoothedLoad += (load - m_smoothedLoad) * alpha;
+    m_loadPermille.store((uint32_t)std::min(m_smoothedLoad * 1000.0f, (float)UINT32_MAX),
+                         std::memory_order_relaxed);
+    m_sinceChangeNs += periodNs;
+    if (!m_automatic) return false;
+
+    const int active = activeTier();
+    if (m_lastChangeWasUp && m_sinceChangeNs >= STEP_UP_PROBATION_MS * 1000000ull) {
+        // The better tier held up; the next climb waits the normal time again
+        m_lastChangeWasUp = false;
+        m_stepUpHoldMs = STEP_UP_HOLD_MS;
+    }
+
+    if ((m_smoothedLoad > STEP_DOWN_LOAD || load >= 1.0f) && active < NUM_QUALITY_TIERS - 1) {
+        m_lowLoadNs = 0;
+        if (m_sinceChangeNs < STEP_DOWN_HOLD_MS * 1000000ull) return false;
+        if (m_lastChangeWasUp) {
+            m_stepUpHoldMs = std::min(m_stepUpHoldMs * 2, (int)MAX_STEP_UP_HOLD_MS);
+        }
+        m_lastChangeWasUp = false;
+        bump(m_stepDowns, 1u);
+        return setActive(active + 1);
+    }
+
+    if (m_smoothedLoad < STEP_UP_LOAD && active > m_requestedTier) {
+        m_lowLoadNs += periodNs;
+        if (m_lowLoadNs < (uint64_t)m_stepUpHoldMs * 1000000ull) return false;
+        m_lastChangeWasUp = true;
+        bump(m_stepUps, 1u);
+        return setActive(active - 1);
+    }
+    m_lowLoadNs = 0;
+    return false;
+}
+
+bool QualityGovernor::setActive(int tier) {
+    if (tier == activeTier()) return false;
+    m_activeTier.store(tier, std::memory_order_relaxed);
+    m_sinceChangeNs = 0;
+    m_lowLoadNs = 0;
+    return true;
+}
+
+QualityReport QualityGovernor::report() const {
+    QualityReport report{};
+    report.activeTier = (float)m_activeTier.load(std::memory_order_relaxed);
+    report.requestedTier = (float)m_reportedRequest.load(std::memory_order_relaxed);
+    report.automatic = m_reportedAutomatic.load(std::memory_order_relaxed) ? 1.0f : 0.0f;
+    report.stepDowns = (float)m_stepDowns.load(std::memory_order_relaxed);
+    report.stepUps = (float)m_stepUps.load(std::memory_order_relaxed);
+    report.smoothedLoad = (float)m_loadPermille.load(std::memory_order_relaxed) / 1000.0f;
+    return report;
+}
@@ -0,0 +1,84 @@
+#ifndef QUALITY_GOVERNOR_H
+#define QUALITY_GOVERNOR_H
+
+#include <atomic>
+#include <cstdint>
+
+// Processing quality tiers, cheapest last.
+enum QualityTier {
+    QUALITY_FULL = 0,
+    QUALITY_REDUCED,       // half the early reflections (the weaker taps)
+    QUALITY_MINIMAL,       // no reverb stage at all
+    NUM_QUALITY_TIERS
+};
+
+struct QualityReport {
+    float activeTier;
+    float requestedTier;
+    float automatic;           // 1 if the governor may step below the request
+    float stepDowns;
+    float stepUps;
+    float smoothedLoad;        // callback cost / buffer period, ~250 ms average
+};
+
+// Picks the tier CafeMode_Process runs at from its own measured cost.
+//
+// Each callback that ran the chain reports its wall-clock cost; the ratio to
+// the buffer period is averaged over LOAD_WINDOW_MS. Above STEP_DOWN_LOAD,
+// or on any overrun, the governor drops one tier; it climbs back one tier
+// only after the load has stayed below STEP_UP_LOAD for a while. The gap
+// between the two thresholds covers the cost difference between adjacent
+// tiers, and a step up that is followed by a quick step down doubles the
+// wait before the next attempt, so a device that cannot sustain a tier
+// settles below it instead of oscillating. The caller crossfades into
+// whatever tier comes out.
+//
+// Threading: configure() and update() are audio-thread only; report() and
+// activeTier() may be read from any thread, as with DspStats.
+class QualityGovernor {
+public:
+    static constexpr float STEP_DOWN_LOAD = 0.7f;
+    static constexpr float STEP_UP_LOAD = 0.3f;
+    static const int LOAD_WINDOW_MS = 250;
+    static const int STEP_DOWN_HOLD_MS = 500;      // let the average see the new tier
+    static const int STEP_UP_HOLD_MS = 5000;       // sustained low load before climbing
+    static const int MAX_STEP_UP_HOLD_MS = 60000;
+    static const int STEP_UP_PROBATION_MS = 10000; // a step down within this undoes a step up
+
+    QualityGovernor();
+
+    // requestedTier is the best tier allowed. Without automatic the active
+    // tier simply follows it. Returns true if the active tier changed.
+    bool configure(int requestedTier, bool automatic);
+    // One callback that ran the chain. Returns true if the active tier changed.
+    bool update(uint64_t elapsedNs, int frames, int sampleRate);
+
+    int activeTier() const { return m_activeTier.load(std::memory_order_relaxed); }
+    QualityReport report() const;
+
+private:
+    bool setActive(int tier);
+
+    // Audio-thread private.
+    int m_requestedTier;
+    bool m_automatic;
+    float m_smoothedLoad;
+    uint64_t m_sinceChangeNs;     // buffer time processed at the active tier
+    uint64_t m_lowLoadNs;         // of which continuously below STEP_UP_LOAD
+    int m_stepUpHoldMs;
+    bool m_lastChangeWasUp;
+
+    template <typename T>
+    static void bump(std::atomic<T>& counter, T amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    std::atomic<int> m_activeTier;
+    std::atomic<int> m_reportedRequest;
+    std::atomic<bool> m_reportedAutomatic;
+    std::atomic<uint32_t> m_stepDowns;
+    std::atomic<uint32_t> m_stepUps;
+    std::atomic<uint32_t> m_loadPermille;
+};
+
+#endif // QUALITY_GOVERNOR_H
@@ -1,18 +1,26 @@
 #include "reverb_processor.h"
+#include <algorithm>
 #include <cstring>
+#include <new>
 #include <cmath>
 
+const size_t ReverbProcessor::STATE_BYTES = STATE_FLOATS * sizeof(float);
+
 ReverbProcessor::ReverbProcessor()
         : m_roomSize(0.7f)
         , m_decayTime(2.1f)
         , m_preDelay(42.0f)
         , m_wetLevel(0.45f)
         , m_dryLevel(0.55f)
+        , m_wetRamp(0.45f)
+        , m_dryRamp(0.55f)
         , m_highDamping(0.8f)
         , m_lowDamping(0.4f)
+        , m_weakTapsRamp(1.0f)
         , m_lateReverbGain(0.15f) {
 
     setupSonyCafeReflections();
+    updateLateDecay();
     clearBuffers();
 }
 
@@ -20,6 +28,12 @@ ReverbProcessor::~ReverbProcessor() {
 }
 
 void ReverbProcessor::process(const float* input, float* output, int frames) {
+    if (!m_state) {
+        if (output != input) memcpy(output, input, frames * sizeof(float));
+        return;
+    }
+
+    const bool delaysFading = beginDelayBlock(frames);
     for (int i = 0; i < frames; i++) {
         float drySignal = input[i] * m_dryLevel;
         float wetSignal = 0.0f;
@@ -30,6 +44,7 @@ void ReverbProcessor::process(const float* input, float* output, int frames) {
 
         wetSignal += processSonyLateReverb(input[i], 0);
         output[i] = drySignal + wetSignal * m_wetLevel;
+        if (delaysFading) advanceDelayFades();
     }
 }
 
@@ -42,16 +57,49 @@ void ReverbProcessor::process(const float* leftIn, const float* rightIn,
         }
         return;
     }
+    if (!m_state) {
+        if (leftOut != leftIn) memcpy(leftOut, leftIn, frames * sizeof(float));
+        if (rightOut != rightIn) memcpy(rightOut, rightIn, frames * sizeof(float));
+        return;
+    }
+
+    // Both steps are exactly zero unless a level is ramping
+    float wetLevel = m_wetRamp.value();
+    float dryLevel = m_dryRamp.value();
+    const float wetStep = m_wetRamp.advance(frames);
+    const float dryStep = m_dryRamp.advance(frames);
+
+    // Taps past mixedTaps are either fading (weighted separately) or only fed
+    float weakGain = m_weakTapsRamp.value();
+    const float weakStep = m_weakTapsRamp.advance(frames);
+    const bool weakFading = weakStep != 0.0f;
+    const int mixedTaps = !weakFading && weakGain == 1.0f ? NUM_REFLECTIONS : REDUCED_REFLECTIONS;
+    const bool delaysFading = beginDelayBlock(frames);
 
     for (int i = 0; i < frames; i++) {
-        float leftDry = leftIn[i] * m_dryLevel;
-        float rightDry = rightIn[i] * m_dryLevel;
+        float leftDry = leftIn[i] * dryLevel;
+        float rightDry = rightIn[i] * dryLevel;
         float leftWet = 0.0f;
         float rightWet = 0.0f;
 
-        for (auto & reflection : m_reflections) {
-            leftWet += processSonyReflection(leftIn[i], reflection, false);
-            rightWet += processSonyReflection(rightIn[i], reflection, true);
+        for (int r = 0; r < mixedTaps; r++) {
+            leftWet += processSonyReflection(leftIn[i], m_reflections[r], false);
+            rightWet += processSonyReflection(rightIn[i], m_reflections[r], true);
+        }
+        if (weakFading) {
+            float leftWeak = 0.0f;
+            float rightWeak = 0.0f;
+            for (int r = REDUCED_REFLECTIONS; r < NUM_REFLECTIONS; r++) {
+                leftWeak += processSonyReflection(leftIn[i], m_reflections[r], false);
+                rightWeak += processSonyReflection(rightIn[i], m_reflections[r], true);
+            }
+            leftWet += leftWeak * weakGain;
+            rightWet += rightWeak * weakGain;
+            weakGain += weakStep;
+        } else if (mixedTaps < NUM_REFLECTIONS) {
+            for (int r = REDUCED_REFLECTIONS; r < NUM_REFLECTIONS; r++) {
+                feedSonyReflection(leftIn[i], rightIn[i], m_reflections[r]);
+            }
         }
 
         leftWet += processSonyLateReverb(leftIn[i], 0);
@@ -60,40 +108,66 @@ void ReverbProcessor::process(const float* leftIn, const float* rightIn,
         applySonyDamping(leftWet, rightWet);
         applySonyEchoEffects(leftWet, rightWet, leftWet, rightWet);
 
-        float makeupGain = 1.0f + (m_wetLevel * 0.2f);
-        leftOut[i] = (leftDry + leftWet * m_wetLevel) * makeupGain;
-        rightOut[i] = (rightDry + rightWet * m_wetLevel) * makeupGain;
+        float makeupGain = 1.0f + (wetLevel * 0.2f);
+        leftOut[i] = (leftDry + leftWet * wetLevel) * makeupGain;
+        rightOut[i] = (rightDry + rightWet * wetLevel) * makeupGain;
+
+        wetLevel += wetStep;
+        dryLevel += dryStep;
+        if (delaysFading) advanceDelayFades();
+    }
+}
+
+// Takes this block's share of every delay crossfade; true if any is moving.
+bool ReverbProcessor::beginDelayBlock(int frames) {
+    bool fading = false;
+    for (auto & reflection : m_reflections) {
+        reflection.block = reflection.delay.beginBlock(frames);
+        fading = fading || reflection.block.step != 0.0f;
     }
+    m_preDelayBlock = m_preDelaySamples.beginBlock(frames);
+    return fading || m_preDelayBlock.step != 0.0f;
+}
+
+void ReverbProcessor::advanceDelayFades() {
+    for (auto & reflection : m_reflections) {
+        reflection.block.fade += reflection.block.step;
+    }
+    m_preDelayBlock.fade += m_preDelayBlock.step;
 }
 
 float ReverbProcessor::processSonyReflection(float input, Reflection& reflection, bool rightChannel) {
-    int delayOffset = rightChannel ? 2 : 0;
-    int readIndex = (reflection.delayIndex - reflection.delaySamples - delayOffset + MAX_REFLECTION_DELAY) % MAX_REFLECTION_DELAY;
-    float delayedSample = reflection.delayBuffer[readIndex];
+    DelayTap::Block block = reflection.block;
+    if (rightChannel) {
+        block.delay += 2;
+        block.previous += 2;
+    }
+    float delayedSample = reflection.line.tap(block);
 
-    float output = delayedSample * reflection.gain;
-    float dampingFactor = reflection.dampingCoeff * (rightChannel ? 0.95f : 1.0f);
+    float output = delayedSample * reflection.tap->gain;
+    float dampingFactor = reflection.tap->dampingCoeff * (rightChannel ? 0.95f : 1.0f);
     output = output * dampingFactor + input * (1.0f - dampingFactor) * 0.1f;
 
-    reflection.delayBuffer[reflection.delayIndex] = input;
-    reflection.delayIndex = (reflection.delayIndex + 1) % MAX_REFLECTION_DELAY;
+    reflection.line.write(input);
 
     return output;
 }
 
-float ReverbProcessor::processSonyLateReverb(float input, int channel) {
-    int lateIndex = m_lateReverbIndex[channel];
-    float lateSignal = m_lateReverbBuffer[channel][lateIndex];
+// Same delay-line writes as the left and right processSonyReflection()
+// calls, without reading or mixing anything.
+void ReverbProcessor::feedSonyReflection(float leftIn, float rightIn, Reflection& reflection) {
+    reflection.line.write(leftIn);
+    reflection.line.write(rightIn);
+}
 
-    float decayFactor = powf(0.001f, 1.0f / (m_decayTime * m_sampleRate));
-    lateSignal *= decayFactor;
+float ReverbProcessor::processSonyLateReverb(float input, int channel) {
+    DelayLine<LATE_REVERB_SIZE>& line = m_lateReverbLine[channel];
+    float lateSignal = line.tap(LATE_REVERB_SIZE);
 
-    int preDelayIndex = (lateIndex - m_preDelaySamples + LATE_REVERB_SIZE) % LATE_REVERB_SIZE;
     // GUARANTEED FIX: Use the preDelayedInput variable to fix the warning.
-    float preDelayedInput = m_lateReverbBuffer[channel][preDelayIndex];
+    float preDelayedInput = line.tap(m_preDelayBlock);
 
-    m_lateReverbBuffer[channel][lateIndex] = input * 0.2f + preDelayedInput * 0.1f + lateSignal * 0.95f;
-    m_lateReverbIndex[channel] = (lateIndex + 1) % LATE_REVERB_SIZE;
+    line.write(input * 0.2f + (preDelayedInput * 0.1f + lateSignal * 0.95f) * m_lateFeedback);
 
     return lateSignal * m_lateReverbGain;
 }
@@ -106,24 +180,10 @@ void ReverbProcessor::applySonyDamping(float& leftWet, float& rightWet) {
 }
 
 void ReverbProcessor::applySonyEchoEffects(float leftIn, float rightIn, float& leftOut, float& rightOut) {
-    int echoDelay1 = (int)(120.0f * m_sampleRate / 1000.0f);
-    int echoDelay2 = (int)(180.0f * m_sampleRate / 1000.0f);
-    int echoDelay3 = (int)(240.0f * m_sampleRate / 1000.0f);
-
-    float echo1 = 0.0f, echo2 = 0.0f, echo3 = 0.0f;
-
-    if (echoDelay1 < LATE_REVERB_SIZE) {
-        int echo1Index = (m_lateReverbIndex[0] - echoDelay1 + LATE_REVERB_SIZE) % LATE_REVERB_SIZE;
-        echo1 = m_lateReverbBuffer[0][echo1Index] * 0.3f;
-    }
-    if (echoDelay2 < LATE_REVERB_SIZE) {
-        int echo2Index = (m_lateReverbIndex[0] - echoDelay2 + LATE_REVERB_SIZE) % LATE_REVERB_SIZE;
-        echo2 = m_lateReverbBuffer[0][echo2Index] * 0.2f;
-    }
-    if (echoDelay3 < LATE_REVERB_SIZE) {
-        int echo3Index = (m_lateReverbIndex[0] - echoDelay3 + LATE_REVERB_SIZE) % LATE_REVERB_SIZE;
-        echo3 = m_lateReverbBuffer[0][echo3Index] * 0.1f;
-    }
+    const DelayLine<LATE_REVERB_SIZE>& line = m_lateReverbLine[0];
+    float echo1 = m_echoDelay[0] ? line.tap(m_echoDelay[0]) * 0.3f : 0.0f;
+    float echo2 = m_echoDelay[1] ? line.tap(m_echoDelay[1]) * 0.2f : 0.0f;
+    float echo3 = m_echoDelay[2] ? line.tap(m_echoDelay[2]) * 0.1f : 0.0f;
 
     leftOut = leftIn + echo1 + echo2 * 0.8f + echo3 * 0.6f;
     rightOut = rightIn + echo1 * 0.8f + echo2 + echo3 * 0.7f;
@@ -132,12 +192,40 @@ void ReverbProcessor::applySonyEchoEffects(float leftIn, float rightIn, float& l
 void ReverbProcessor::setSampleRate(int sampleRate) {
     AudioProcessor::setSampleRate(sampleRate);
     updateSonyReflectionDelays();
-    m_preDelaySamples = (int)(m_preDelay * m_sampleRate / 1000.0f);
-    m_preDelaySamples = clamp(m_preDelaySamples, 0, LATE_REVERB_SIZE - 1);
+    setPreDelay(m_preDelay);
+    updateLateDecay();
+    // Echoes that do not fit the late buffer are left out
+    static const float kEchoMs[3] = { 120.0f, 180.0f, 240.0f };
+    for (int i = 0; i < 3; i++) {
+        int delay = (int)(kEchoMs[i] * m_sampleRate / 1000.0f);
+        m_echoDelay[i] = delay < LATE_REVERB_SIZE ? delay : 0;
+    }
+    snapParameters();
 }
 
 void ReverbProcessor::reset() {
     clearBuffers();
+    snapParameters();
+}
+
+void ReverbProcessor::snapParameters() {
+    m_wetRamp.snap();
+    m_dryRamp.snap();
+    m_weakTapsRamp.snap();
+    for (auto & reflection : m_reflections) {
+        reflection.delay.snap();
+    }
+    m_preDelaySamples.snap();
+}
+
+void ReverbProcessor::setReducedReflections(bool reduced) {
+    m_weakTapsRamp.setTarget(reduced ? 0.0f : 1.0f, SmoothedParam::rampFrames(m_sampleRate));
+}
+
+int ReverbProcessor::getTailSamples() const {
+    // Reflections and the late buffer run in parallel; the late buffer also
+    // recirculates, which the caller's output-level check covers.
+    return LATE_REVERB_SIZE > MAX_REFLECTION_DELAY ? LATE_REVERB_SIZE : MAX_REFLECTION_DELAY;
 }
 
 void ReverbProcessor::setParameter(int param, float value) {
@@ -168,59 +256,109 @@ void ReverbProcessor::setRoomSize(float size) {
 
 void ReverbProcessor::setDecayTime(float decay) {
     m_decayTime = clamp(decay, 0.1f, 10.0f);
+    updateLateDecay();
+}
+
+// The late loop recirculates through two taps, the full line and the
+// pre-delay, so it loses 60 dB per decay time only if their summed gain
+// is held to the decay of one pass round the line. Anything above 1 grows
+// without bound.
+void ReverbProcessor::updateLateDecay() {
+    if (m_sampleRate <= 0) return;
+    const float passDecay = powf(0.001f, (float)LATE_REVERB_SIZE / (m_decayTime * (float)m_sampleRate));
+    m_lateFeedback = passDecay / (0.1f + 0.95f);
 }
 
 void ReverbProcessor::setWetLevel(float wet) {
     m_wetLevel = clamp(wet, 0.0f, 1.0f);
+    m_wetRamp.setTarget(m_wetLevel, SmoothedParam::rampFrames(m_sampleRate));
 }
 
 void ReverbProcessor::setDryLevel(float dry) {
     m_dryLevel = clamp(dry, 0.0f, 1.0f);
+    m_dryRamp.setTarget(m_dryLevel, SmoothedParam::rampFrames(m_sampleRate));
 }
 
 void ReverbProcessor::setPreDelay(float preDelay) {
     m_preDelay = clamp(preDelay, 0.0f, 100.0f);
     if (m_sampleRate > 0) {
-        m_preDelaySamples = (int)(m_preDelay * m_sampleRate / 1000.0f);
-        m_preDelaySamples = clamp(m_preDelaySamples, 0, LATE_REVERB_SIZE - 1);
+        int samples = (int)(m_preDelay * m_sampleRate / 1000.0f);
+        m_preDelaySamples.setTarget(std::clamp(samples, 0, LATE_REVERB_SIZE - 1), SmoothedParam::rampFrames(m_sampleRate));
     }
 }
 
-void ReverbProcessor::setupSonyCafeReflections() {
-    m_reflections[0] = {150, 0.65f, 0.75f, 0.8f, {0}, 0};
-    m_reflections[1] = {220, 0.58f, 0.70f, 0.75f, {0}, 0};
-    m_reflections[2] = {280, 0.52f, 0.65f, 0.72f, {0}, 0};
-    m_reflections[3] = {340, 0.45f, 0.60f, 0.68f, {0}, 0};
-    m_reflections[4] = {420, 0.38f, 0.55f, 0.65f, {0}, 0};
-    m_reflections[5] = {490, 0.32f, 0.48f, 0.60f, {0}, 0};
-    m_reflections[6] = {560, 0.25f, 0.40f, 0.55f, {0}, 0};
-    m_reflections[7] = {630, 0.18f, 0.32f, 0.50f, {0}, 0};
-    m_reflections[8] = {720, 0.12f, 0.25f, 0.45f, {0}, 0};
-    m_reflections[9] = {810, 0.08f, 0.18f, 0.40f, {0}, 0};
-    m_reflections[10] = {900, 0.05f, 0.12f, 0.35f, {0}, 0};
-    m_reflections[11] = {990, 0.03f, 0.08f, 0.30f, {0}, 0};
+const ReverbProcessor::ReflectionTap ReverbProcessor::kReflectionTaps[NUM_REFLECTIONS] = {
+    {150, 0.65f, 0.75f, 0.8f},
+    {220, 0.58f, 0.70f, 0.75f},
+    {280, 0.52f, 0.65f, 0.72f},
+    {340, 0.45f, 0.60f, 0.68f},
+    {420, 0.38f, 0.55f, 0.65f},
+    {490, 0.32f, 0.48f, 0.60f},
+    {560, 0.25f, 0.40f, 0.55f},
+    {630, 0.18f, 0.32f, 0.50f},
+    {720, 0.12f, 0.25f, 0.45f},
+    {810, 0.08f, 0.18f, 0.40f},
+    {900, 0.05f, 0.12f, 0.35f},
+    {990, 0.03f, 0.08f, 0.30f},
+};
 
-    for (auto & reflection : m_reflections) {
-        memset(reflection.delayBuffer, 0, sizeof(reflection.delayBuffer));
-        reflection.delayIndex = 0;
+void ReverbProcessor::setupSonyCafeReflections() {
+    for (int i = 0; i < NUM_REFLECTIONS; i++) {
+        Reflection& reflection = m_reflections[i];
+        reflection.tap = &kReflectionTaps[i];
+        reflection.delay = DelayTap(reflection.tap->baseDelaySamples);
+        reflection.line.setStorage(nullptr);
     }
 }
 
 void ReverbProcessor::updateSonyReflectionDelays() {
+    // Always scaled from the base tuning, so repeated calls do not compound
     float roomScale = 0.3f + m_roomSize * 1.4f;
-    for (auto & m_reflection : m_reflections) {
-        int baseDelay = m_reflection.delaySamples;
-        m_reflection.delaySamples = (int)(baseDelay * roomScale);
-        m_reflection.delaySamples = clamp(m_reflection.delaySamples, 1, MAX_REFLECTION_DELAY - 1);
+    const int rampFrames = SmoothedParam::rampFrames(m_sampleRate);
+    for (auto & reflection : m_reflections) {
+        int delaySamples = (int)(reflection.tap->baseDelaySamples * roomScale);
+        reflection.delay.setTarget(std::clamp(delaySamples, 1, MAX_REFLECTION_DELAY - 1), rampFrames);
+    }
+}
+
+bool ReverbProcessor::allocateState() {
+    if (m_state) return true;
+    if (m_providedState) {
+        m_state = m_providedState;
+    } else {
+        m_stateStorage.reset(new(std::nothrow) float[STATE_FLOATS]);
+        if (!m_stateStorage) return false;
+        m_state = m_stateStorage.get();
     }
+    float* next = m_state;
+    for (auto & reflection : m_reflections) {
+        reflection.line.setStorage(next);
+        next += MAX_REFLECTION_DELAY;
+    }
+    m_lateReverbLine[0].setStorage(next);
+    m_lateReverbLine[1].setStorage(next + LATE_REVERB_SIZE);
+    clearBuffers();
+    return true;
+}
+
+void ReverbProcessor::releaseState() {
+    for (auto & reflection : m_reflections) {
+        reflection.line.setStorage(nullptr);
+    }
+    m_lateReverbLine[0].setStorage(nullptr);
+    m_lateReverbLine[1].setStorage(nullptr);
+    m_state = nullptr;
+    m_stateStorage.reset();
+}
+
+size_t ReverbProcessor::getStateBytes() const {
+    return m_state ? STATE_BYTES : 0;
 }
 
 void ReverbProcessor::clearBuffers() {
-    memset(m_lateReverbBuffer, 0, sizeof(m_lateReverbBuffer));
-    m_lateReverbIndex[0] = 0;
-    m_lateReverbIndex[1] = 0;
     for (auto & reflection : m_reflections) {
-        memset(reflection.delayBuffer, 0, sizeof(reflection.delayBuffer));
-        reflection.delayIndex = 0;
+        reflection.line.clear();
     }
+    m_lateReverbLine[0].clear();
+    m_lateReverbLine[1].clear();
 }
\ No newline at end of file
@@ -2,6 +2,8 @@
 #define REVERB_PROCESSOR_H
 
 #include "audio_processor.h"
+#include "delay_line.h"
+#include <memory>
 
 class ReverbProcessor : public AudioProcessor {
 public:
@@ -10,12 +12,19 @@ public:
     
     // Core processing
     void process(const float* input, float* output, int frames) override;
+    // leftOut/rightOut may alias leftIn/rightIn for in-place processing
     void process(const float* leftIn, const float* rightIn,
                  float* leftOut, float* rightOut, int frames);
     
     // Configuration
     void setSampleRate(int sampleRate) override;
     void reset() override;
+    int getTailSamples() const override;
+    bool allocateState() override;
+    void releaseState() override;
+    size_t getStateBytes() const override;
+    static const size_t STATE_BYTES;        // reflection and late delay lines
+    void snapParameters() override;
     
     // Parameter control
     void setParameter(int param, float value) override;
@@ -27,6 +36,12 @@ public:
     void setWetLevel(float wet);            // 45% wet
     void setDryLevel(float dry);            // 55% dry
     void setPreDelay(float preDelay);       // 42ms
+
+    // Reduced-cost mode for quality tiers: only the REDUCED_REFLECTIONS
+    // strongest taps are mixed. The others fade out over the usual ramp and
+    // then only keep their delay lines filled, so they can fade back in
+    // without replaying stale input.
+    void setReducedReflections(bool reduced);
     
 private:
     // Sony Café Mode reverb parameters
@@ -35,6 +50,8 @@ private:
     float m_preDelay;        // Pre-delay in ms - default 42ms
     float m_wetLevel;        // Wet signal level - default 45%
     float m_dryLevel;        // Dry signal level - default 55%
+    SmoothedParam m_wetRamp;
+    SmoothedParam m_dryRamp;
     float m_highDamping;     // High-frequency damping - -8dB at 5kHz
     float m_lowDamping;      // Low-frequency damping - -4dB at 150Hz
     
@@ -42,26 +59,47 @@ private:
     static const int NUM_REFLECTIONS = 12; // Increased for complex café environment
     static const int MAX_REFLECTION_DELAY = 4096;
     
-    struct Reflection {
-        int delaySamples;
+    // Fixed tap tuning, shared read-only by every instance
+    struct ReflectionTap {
+        int baseDelaySamples;   // before room-size scaling
         float gain;
         float dampingCoeff;     // Frequency-dependent damping
         float absorptionCoeff;  // Material absorption
-        float delayBuffer[MAX_REFLECTION_DELAY];
-        int delayIndex;
+    };
+    static const ReflectionTap kReflectionTaps[NUM_REFLECTIONS];
+    static const int REDUCED_REFLECTIONS = 6;   // taps are ordered by gain
+    SmoothedParam m_weakTapsRamp;               // 1 = all taps mixed
+
+    // Per-instance state for one tap. The line holds left and right
+    // interleaved, so its delay counts both channels' samples.
+    struct Reflection {
+        const ReflectionTap* tap;
+        DelayTap delay;                             // crossfaded on room-size changes
+        DelayTap::Block block;                      // this block's share of the fade
+        DelayLine<MAX_REFLECTION_DELAY> line;       // in m_state
     };
     
     Reflection m_reflections[NUM_REFLECTIONS];
     
     // Late reverb (Sony-enhanced)
     static const int LATE_REVERB_SIZE = 8192; // Larger for longer decay
-    float m_lateReverbBuffer[2][LATE_REVERB_SIZE];
-    int m_lateReverbIndex[2];
+    DelayLine<LATE_REVERB_SIZE> m_lateReverbLine[2];   // in m_state
+
+    // Reflection delay lines followed by the late buffer, one block
+    static const int STATE_FLOATS = NUM_REFLECTIONS * MAX_REFLECTION_DELAY + 2 * LATE_REVERB_SIZE;
+    std::unique_ptr<float[]> m_stateStorage;   // allocateState() without provided storage
+    float* m_state = nullptr;                  // provided or m_stateStorage, once allocated
     float m_lateReverbGain;
-    int m_preDelaySamples;
+    float m_lateFeedback = 0.0f;               // scales both late-loop taps, see updateLateDecay()
+    DelayTap m_preDelaySamples;
+    DelayTap::Block m_preDelayBlock;
+    int m_echoDelay[3]{};                      // samples, 0 where past the late buffer
     
     // Sony-specific processing methods
+    bool beginDelayBlock(int frames);
+    void advanceDelayFades();
     float processSonyReflection(float input, Reflection& reflection, bool rightChannel = false);
+    void feedSonyReflection(float leftIn, float rightIn, Reflection& reflection);
     float processSonyLateReverb(float input, int channel);
     void applySonyDamping(float& leftWet, float& rightWet);
     void applySonyEchoEffects(float leftIn, float rightIn, float& leftOut, float& rightOut);
@@ -69,6 +107,7 @@ private:
     // Utility functions
     void setupSonyCafeReflections();
     void updateSonyReflectionDelays();
+    void updateLateDecay();
     void clearBuffers();
 };
 
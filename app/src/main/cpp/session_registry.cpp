@@ -0,0 +1,47 @@
+#include "session_registry.h"
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace {
+
+// Weak references only: the registry never keeps a table alive by itself.
+struct Registry {
+    std::mutex lock;
+    std::map<std::pair<int, int>, std::weak_ptr<const void>> tables;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+} // namespace
+
+std::shared_ptr<const void> SessionRegistry::acquireErased(TableKind kind, int key,
+                                                           const std::function<std::shared_ptr<const void>()>& build) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    std::weak_ptr<const void>& slot = reg.tables[{ (int)kind, key }];
+    std::shared_ptr<const void> table = slot.lock();
+    if (!table) {
+        table = build();
+        slot = table;
+    }
+    return table;
+}
+
+int SessionRegistry::liveTableCount() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    int count = 0;
+    for (auto it = reg.tables.begin(); it != reg.tables.end();) {
+        if (it->second.expired()) {
+            it = reg.tables.erase(it);
+        } else {
+            count++;
+            ++it;
+        }
+    }
+    return count;
+}
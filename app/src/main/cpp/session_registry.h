@@ -0,0 +1,52 @@
+#ifndef SESSION_REGISTRY_H
+#define SESSION_REGISTRY_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+// Process-wide cache of the read-only tables the processors derive at run
+// time, typically from the sample rate. Fixed tunings that need no
+// computation are plain static const data and shared by the loader already.
+//
+// The effect is attached to every stream type, so one process can host many
+// instances running at the same rate. Each of them used to rebuild and keep
+// its own copy of identical tables; now the first instance builds a table,
+// the rest share it through a shared_ptr<const T>, and the table is freed
+// when the last instance holding it lets go. Per-instance memory is left
+// with the mutable DSP state only.
+//
+// Threading: acquire() takes a mutex and may allocate, so call it from
+// setSampleRate() or construction, never from process(). The audio thread
+// only dereferences pointers it already holds.
+class SessionRegistry {
+public:
+    enum TableKind {
+        TABLE_CAFE_EQ_CURVE,        // EQProcessor::CafeCurve, per rate
+        TABLE_PRESET_BANK,          // PresetBank, key 0
+        TABLE_DISTANCE_COEFFS,      // DistanceTable, per rate
+        TABLE_FFT,                  // RealFft, key = transform size
+        TABLE_HRIR_DATABASE,        // HrirDatabase, key 0
+        TABLE_HRTF_GRID,            // HrtfGrid, per rate
+        NUM_TABLE_KINDS
+    };
+
+    // Returns the live table for (kind, key), building it with build() if no
+    // instance holds one. key is the sample rate for per-rate tables, 0
+    // otherwise.
+    template <typename T>
+    static std::shared_ptr<const T> acquire(TableKind kind, int key, const std::function<T*()>& build) {
+        return std::static_pointer_cast<const T>(acquireErased(kind, key, [&build]() {
+            return std::shared_ptr<const void>(build());
+        }));
+    }
+
+    // Tables currently held by at least one instance.
+    static int liveTableCount();
+
+private:
+    static std::shared_ptr<const void> acquireErased(TableKind kind, int key,
+                                                     const std::function<std::shared_ptr<const void>()>& build);
+};
+
+#endif // SESSION_REGISTRY_H
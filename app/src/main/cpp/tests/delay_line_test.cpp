@@ -0,0 +1,117 @@
+// Frequency response of DelayLine's fractional tap: the impulse response
+// of tapAllpass() at a range of delays, evaluated as a DFT at a few
+// frequencies for its magnitude and group delay.
+
+#include "delay_line.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int kLine = 128;
+const int kResponse = 512;   // |coeff| <= 1/3, so the tail is long gone
+
+int gFailures = 0;
+
+void expect(const char* what, bool ok, float actual) {
+    if (!ok) {
+        fprintf(stderr, "FAIL %s: got %g\n", what, actual);
+        gFailures++;
+    }
+}
+
+// tapAllpass(delay) driven by a unit impulse, read before each write as
+// the processors do.
+std::vector<float> impulseResponse(float delay) {
+    std::vector<float> storage(kLine, 0.0f);
+    DelayLine<kLine> line;
+    line.setStorage(storage.data());
+    line.clear();
+    DelayLine<kLine>::AllpassState state;
+    std::vector<float> response(kResponse);
+    for (int n = 0; n < kResponse; n++) {
+        response[n] = line.tapAllpass(delay, state);
+        line.write(n == 0 ? 1.0f : 0.0f);
+    }
+    return response;
+}
+
+std::complex<double> transfer(const std::vector<float>& response, double omega) {
+    std::complex<double> sum = 0.0;
+    for (size_t n = 0; n < response.size(); n++) sum += (double)response[n] * std::polar(1.0, -omega * (double)n);
+    return sum;
+}
+
+// -d(phase)/d(omega), by a central difference.
+double groupDelay(const std::vector<float>& response, double omega) {
+    const double h = 1e-4;
+    const double phase = std::arg(transfer(response, omega + h) / transfer(response, omega - h));
+    return -phase / (2.0 * h);
+}
+
+// Flat magnitude at every frequency, up to just below Nyquist.
+void testMagnitude() {
+    for (float delay : { 1.5f, 1.7f, 2.0f, 2.3f, 10.5f, 126.9f, 127.0f }) {
+        const std::vector<float> response = impulseResponse(delay);
+        for (double fraction : { 0.01, 0.25, 0.5, 0.75, 0.99 }) {
+            const double magnitude = std::abs(transfer(response, M_PI * fraction));
+            char what[96];
+            snprintf(what, sizeof(what), "delay %.2f is flat at %.2f x Nyquist", delay, fraction);
+            expect(what, fabs(magnitude - 1.0) < 1e-4, (float)magnitude);
+        }
+    }
+}
+
+// The requested delay at low frequencies, including the [1.5, 2) range
+// where the integer part cannot move down.
+void testGroupDelay() {
+    for (float delay : { 1.5f, 1.7f, 2.0f, 2.3f, 2.5f, 10.5f, 66.15f, 126.9f, 127.0f }) {
+        const std::vector<float> response = impulseResponse(delay);
+        const double measured = groupDelay(response, M_PI * 0.01);
+        char what[96];
+        snprintf(what, sizeof(what), "group delay of delay %.2f", delay);
+        expect(what, fabs(measured - delay) < 2e-3, (float)measured);
+    }
+}
+
+// The pole stays well inside the unit circle: just above a whole delay,
+// where an unshifted coefficient approaches 1, the response has died away
+// 32 samples after the tap.
+void testRingsOut() {
+    for (float delay : { 1.5f, 2.01f, 2.05f, 40.02f, 126.95f }) {
+        const std::vector<float> response = impulseResponse(delay);
+        float tail = 0.0f;
+        for (int n = (int)delay + 32; n < kResponse; n++) tail = std::max(tail, fabsf(response[n]));
+        char what[96];
+        snprintf(what, sizeof(what), "delay %.2f rings out within 32 samples", delay);
+        expect(what, tail < 1e-6f, tail);
+    }
+}
+
+// A whole-sample delay that lands on the coefficient-zero end of the
+// range is the plain tap, with no allpass ringing.
+void testWholeDelayIsExact() {
+    const std::vector<float> response = impulseResponse(40.0f);
+    for (int n = 0; n < kResponse; n++) {
+        const float expected = n == 40 ? 1.0f : 0.0f;
+        if (response[n] != expected) {
+            expect("delay 40 is a single tap", false, response[n]);
+            return;
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    testMagnitude();
+    testGroupDelay();
+    testRingsOut();
+    testWholeDelayIsExact();
+    if (gFailures == 0) printf("delay_line_test: all passed\n");
+    return gFailures == 0 ? 0 : 1;
+}
@@ -0,0 +1,1179 @@
+// cafetone-bench: per-stage micro-benchmarks for the Sony Café Mode DSP chain.
+//
+// Every AudioProcessor subclass is timed in isolation, and the full chain is
+// timed through the effect interface (create_effect / process), swept over
+// block sizes, sample rates and parameter settings. Results are emitted as
+// CSV or JSON with one stable key per row so two builds can be diffed, and
+// --baseline compares against a previous CSV run and fails on regressions.
+
+#include "audio_effect.h"
+#include "eq_processor.h"
+#include "haas_processor.h"
+#include "binaural_processor.h"
+#include "reverb_processor.h"
+#include "dynamic_processor.h"
+#include "format_converter.h"
+#include "dsp_arena.h"
+#include "preset_bank.h"
+#include "delay_line.h"
+#include "hrtf_renderer.h"
+
+#define LOG_TAG "cafetone-bench"
+#include "dsp_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+extern "C" audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+namespace {
+
+// Must match the PARAM_* enum in cafetone_dsp.cpp / CafeModeDSP.kt.
+enum { PARAM_INTENSITY, PARAM_SPATIAL_WIDTH, PARAM_DISTANCE, PARAM_BLOCK_SIZE, PARAM_IDLE_RECLAIM_MS,
+       PARAM_PREFAULT, PARAM_PRESET };
+
+struct Setting {
+    const char* name;
+    float intensity;
+    float spatialWidth;
+    float distance;
+};
+
+const Setting kSettings[] = {
+        { "near",    0.4f, 0.2f, 0.1f },
+        { "default", 0.7f, 0.6f, 0.8f },
+        { "far",     1.0f, 1.0f, 1.0f },
+};
+
+const int kSampleRates[] = { 44100, 48000, 96000 };
+const int kBlockSizes[] = { 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+
+struct Options {
+    std::string format = "csv";
+    std::string stageFilter;
+    std::string baselinePath;
+    double tolerancePct = 10.0;
+    double seconds = 0.25;   // audio rendered per repetition
+    int repetitions = 5;
+    bool eqResponse = false;
+};
+
+struct Result {
+    std::string stage;
+    int sampleRate;
+    int block;
+    std::string setting;
+    double nsPerFrame;
+    double realtimeX;
+    double workingSetBytes = 0.0;      // pipeline suite only
+    double spillBytesPerFrame = 0.0;   // modelled intermediate traffic beyond L1
+    double l1dMissesPerFrame = -1.0;   // measured when perf counters are available
+
+    std::string key() const {
+        return stage + "/" + std::to_string(sampleRate) + "/" + std::to_string(block) + "/" + setting;
+    }
+};
+
+// Deterministic pink-ish noise so runs are comparable across builds.
+void fillSignal(std::vector<float>& left, std::vector<float>& right) {
+    uint32_t seed = 0x12345678u;
+    float lp = 0.0f;
+    for (size_t i = 0; i < left.size(); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        float white = (float)(seed >> 8) / 8388608.0f - 1.0f;
+        lp = lp * 0.95f + white * 0.05f;
+        left[i] = 0.5f * lp + 0.1f * white;
+        right[i] = 0.5f * lp - 0.1f * white;
+    }
+}
+
+// Mirrors the mapping CafeMode_Command applies for each user parameter.
+// Ramps are snapped so timing starts from the settled state, as the effect
+// does before its first block.
+void applySetting(const Setting& s, EQProcessor* eq, HaasProcessor* haas, BinauralProcessor* binaural,
+                  DynamicProcessor* dynamics) {
+    if (haas) {
+        haas->setDelayAmount(s.spatialWidth * 20.0f);
+        haas->snapParameters();
+    }
+    if (binaural) {
+        binaural->setSpatialWidth(1.0f + s.spatialWidth * 0.7f);
+        binaural->setDistance(s.distance);
+        binaural->snapParameters();
+    }
+    if (eq) {
+        eq->setHighPassFilter(DistanceTable::highPassFreq(s.distance));
+        eq->setLowPassFilter(DistanceTable::lowPassFreq(s.distance));
+        eq->snapParameters();
+    }
+    if (dynamics) {
+        dynamics->setDistanceCompression(s.distance);
+        dynamics->snapParameters();
+    }
+}
+
+// Runs `body(offset, frames)` over `total` frames in `block`-sized calls and
+// returns the best ns/frame over the configured repetitions.
+double timeBlocks(const Options& opts, size_t total, int block, const std::function<void(size_t, int)>& body) {
+    double best = 0.0;
+    for (int rep = 0; rep <= opts.repetitions; rep++) {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t pos = 0; pos + block <= total; pos += block) body(pos, block);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        double perFrame = ns / (double)(total / block * block);
+        if (rep == 0) continue;   // warm-up pass: caches, page faults, denormal settling
+        if (rep == 1 || perFrame < best) best = perFrame;
+    }
+    return best;
+}
+
+void benchStages(const Options& opts, std::vector<Result>& results) {
+    for (int sampleRate : kSampleRates) {
+        size_t total = std::max<size_t>((size_t)(opts.seconds * sampleRate), 4096);
+        std::vector<float> inL(total), inR(total), outL(total), outR(total);
+        fillSignal(inL, inR);
+
+        for (const Setting& setting : kSettings) {
+            for (int block : kBlockSizes) {
+                auto record = [&](const char* stage, double ns) {
+                    results.push_back({ stage, sampleRate, block, setting.name, ns,
+                                        ns > 0.0 ? 1e9 / (ns * sampleRate) : 0.0 });
+                };
+                auto wanted = [&](const char* stage) {
+                    return opts.stageFilter.empty() || opts.stageFilter == stage;
+                };
+
+                if (wanted("eq")) {
+                    EQProcessor eq;
+                    eq.setSampleRate(sampleRate);
+                    applySetting(setting, &eq, nullptr, nullptr, nullptr);
+                    record("eq", timeBlocks(opts, total, block, [&](size_t pos, int n) {
+                        eq.process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, n);
+                    }));
+                }
+                if (wanted("haas")) {
+                    auto haas = std::make_unique<HaasProcessor>();
+                    haas->setSampleRate(sampleRate);
+                    haas->allocateState();
+                    applySetting(setting, nullptr, haas.get(), nullptr, nullptr);
+                    record("haas", timeBlocks(opts, total, block, [&](size_t pos, int n) {
+                        haas->process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, n);
+                    }));
+                }
+                if (wanted("binaural")) {
+                    auto binaural = std::make_unique<BinauralProcessor>();
+                    binaural->setSampleRate(sampleRate);
+                    applySetting(setting, nullptr, nullptr, binaural.get(), nullptr);
+                    record("binaural", timeBlocks(opts, total, block, [&](size_t pos, int n) {
+                        binaural->process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, n);
+                    }));
+                }
+                if (wanted("reverb")) {
+                    auto reverb = std::make_unique<ReverbProcessor>();
+                    reverb->setSampleRate(sampleRate);
+                    reverb->allocateState();
+                    record("reverb", timeBlocks(opts, total, block, [&](size_t pos, int n) {
+                        reverb->process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, n);
+                    }));
+                }
+                if (wanted("dynamics")) {
+                    auto dynamics = std::make_unique<DynamicProcessor>();
+                    dynamics->setSampleRate(sampleRate);
+                    applySetting(setting, nullptr, nullptr, nullptr, dynamics.get());
+                    record("dynamics", timeBlocks(opts, total, block, [&](size_t pos, int n) {
+                        dynamics->process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, n);
+                    }));
+                }
+            }
+        }
+    }
+}
+
+int32_t setParam(effect_interface_t** itfe, int32_t paramId, float value) {
+    uint8_t cmd[sizeof(int32_t) + sizeof(float)];
+    memcpy(cmd, &paramId, sizeof(paramId));
+    memcpy(cmd + sizeof(paramId), &value, sizeof(value));
+    int32_t reply = 0;
+    uint32_t replySize = sizeof(reply);
+    return (*itfe)->command(itfe, EFFECT_CMD_SET_PARAM, sizeof(cmd), cmd, &replySize, &reply);
+}
+
+float getParam(effect_interface_t** itfe, int32_t paramId) {
+    uint8_t reply[sizeof(int32_t) + sizeof(float)] = {};
+    uint32_t replySize = sizeof(reply);
+    float value = 0.0f;
+    if ((*itfe)->command(itfe, EFFECT_CMD_GET_PARAM, sizeof(paramId), &paramId, &replySize, reply) == 0) {
+        memcpy(&value, reply + sizeof(int32_t), sizeof(value));
+    }
+    return value;
+}
+
+int32_t setConfig(effect_interface_t** itfe, int sampleRate, int format, uint32_t inputChannelMask) {
+    effect_config_t config{};
+    for (buffer_config_t* cfg : { &config.inputCfg, &config.outputCfg }) {
+        cfg->samplingRate = (uint32_t)sampleRate;
+        cfg->channels = AUDIO_CHANNEL_OUT_STEREO;
+        cfg->format = (uint8_t)format;
+        cfg->mask = EFFECT_CONFIG_ALL;
+    }
+    config.inputCfg.channels = inputChannelMask;
+    config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+    int32_t reply = 0;
+    uint32_t replySize = sizeof(reply);
+    int32_t status = (*itfe)->command(itfe, EFFECT_CMD_SET_CONFIG, sizeof(config), &config, &replySize, &reply);
+    return status != 0 ? status : reply;
+}
+
+// The full chain goes through the effect interface, including the PCM
+// conversion and the dry/wet mix, exactly as the audio framework drives it.
+// The rate and I/O format are negotiated with EFFECT_CMD_SET_CONFIG.
+//   chain:          s16 I/O, host buffer size swept, effect's default internal block
+//   chain_f32:      same with float I/O, as on a float mixer path
+//   chain_51/71:    same with s16 5.1 / 7.1 input folded to stereo by the effect
+//   chain_silence:  s16 digital silence, i.e. the cost once the chain has gone idle
+//   chain_automate: s16 with intensity, width and distance changed every callback,
+//                   so every smoothed parameter is always ramping (worst case)
+//   chain_subblock: s16 I/O, deep-buffer host period (4096), internal block swept
+void benchChain(const Options& opts, const char* stage, std::vector<Result>& results) {
+    if (!opts.stageFilter.empty() && opts.stageFilter != stage) return;
+    const bool sweepInternal = strcmp(stage, "chain_subblock") == 0;
+    const bool automate = strcmp(stage, "chain_automate") == 0;
+    const int format = strcmp(stage, "chain_f32") == 0 ? AUDIO_FORMAT_PCM_FLOAT : AUDIO_FORMAT_PCM_16_BIT;
+    uint32_t channelMask = AUDIO_CHANNEL_OUT_STEREO;
+    int channels = 2;
+    if (strcmp(stage, "chain_51") == 0) {
+        channelMask = AUDIO_CHANNEL_OUT_5POINT1;
+        channels = 6;
+    } else if (strcmp(stage, "chain_71") == 0) {
+        channelMask = AUDIO_CHANNEL_OUT_7POINT1;
+        channels = 8;
+    }
+    const size_t inFrameBytes = (size_t)pcmBytesPerSample(format) * channels;
+    const size_t outFrameBytes = (size_t)pcmBytesPerSample(format) * 2;
+    const int deepBuffer = 4096;
+
+    static const effect_uuid_t kUuid =
+            { 0x87654321, 0x4321, 0x8765, 0x4321, { 0xfe, 0xdc, 0xba, 0x09, 0x87, 0x65 } };
+
+    for (int sampleRate : kSampleRates) {
+        size_t total = std::max<size_t>((size_t)(opts.seconds * sampleRate), 4096);
+        // Multichannel input reuses the stereo test signal on every channel
+        // pair: channels / 2 interleaved pairs per frame.
+        const size_t pairs = total * channels / 2;
+        std::vector<float> left(pairs), right(pairs);
+        if (strcmp(stage, "chain_silence") != 0) fillSignal(left, right);
+        std::vector<uint8_t> input(total * inFrameBytes), output(total * outFrameBytes);
+        interleaveStereo(left.data(), right.data(), input.data(), format, (int)pairs, false);
+
+        for (const Setting& setting : kSettings) {
+            for (int block : kBlockSizes) {
+                effect_interface_t* handle = nullptr;
+                if (AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&kUuid, 0, 0, &handle) != 0) continue;
+                effect_interface_t** itfe = &handle;
+                if (setConfig(itfe, sampleRate, format, channelMask) != 0) {
+                    AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(itfe);
+                    continue;
+                }
+                setParam(itfe, PARAM_INTENSITY, setting.intensity);
+                setParam(itfe, PARAM_SPATIAL_WIDTH, setting.spatialWidth);
+                setParam(itfe, PARAM_DISTANCE, setting.distance);
+                if (sweepInternal) {
+                    // Skip sizes above the effect's sub-block capacity (it clamps).
+                    setParam(itfe, PARAM_BLOCK_SIZE, (float)block);
+                    if ((int)getParam(itfe, PARAM_BLOCK_SIZE) != block) {
+                        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(itfe);
+                        continue;
+                    }
+                }
+                int32_t reply = 0;
+                uint32_t replySize = sizeof(reply);
+                (*itfe)->command(itfe, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
+
+                int callback = 0;
+                double ns = timeBlocks(opts, total, sweepInternal ? deepBuffer : block, [&](size_t pos, int n) {
+                    if (automate) {
+                        const float scale = (callback++ & 1) ? 0.5f : 1.0f;
+                        setParam(itfe, PARAM_INTENSITY, setting.intensity * scale);
+                        setParam(itfe, PARAM_SPATIAL_WIDTH, setting.spatialWidth * scale);
+                        setParam(itfe, PARAM_DISTANCE, setting.distance * scale);
+                    }
+                    audio_buffer_t in{}, out{};
+                    in.frameCount = n;
+                    in.raw = input.data() + pos * inFrameBytes;
+                    out.frameCount = n;
+                    out.raw = output.data() + pos * outFrameBytes;
+                    (*itfe)->process(itfe, &in, &out);
+                });
+                results.push_back({ stage, sampleRate, block, setting.name, ns,
+                                    ns > 0.0 ? 1e9 / (ns * sampleRate) : 0.0 });
+                AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(itfe);
+            }
+        }
+    }
+}
+
+// --- Fused pipeline vs. stage-at-a-time ---
+//
+// pipeline_staged reproduces the original CafeMode_Process loop: every stage
+// runs over the whole host buffer into its own float[2][N] buffer. The fused
+// variant runs all stages tile by tile in place, as the effect does now.
+// Both use the same processors and parameters, so the difference is purely
+// the memory behaviour of the intermediate buffers.
+
+const int kAssumedL1Bytes = 32 * 1024;
+
+// Per frame: the deinterleave writes 8 B, each of the five stages reads and
+// writes 8 B, and the mix reads dry + wet (16 B).
+const double kIntermediateBytesPerFrame = 8.0 + 5 * 16.0 + 16.0;
+
+class L1MissCounter {
+public:
+    L1MissCounter() {
+#if defined(__linux__)
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        m_fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~L1MissCounter() {
+#if defined(__linux__)
+        if (m_fd >= 0) close(m_fd);
+#endif
+    }
+    bool available() const { return m_fd >= 0; }
+    void start() {
+#if defined(__linux__)
+        if (m_fd < 0) return;
+        ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+    uint64_t stop() {
+        uint64_t count = 0;
+#if defined(__linux__)
+        if (m_fd < 0) return 0;
+        ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(m_fd, &count, sizeof(count)) != (ssize_t)sizeof(count)) count = 0;
+#endif
+        return count;
+    }
+
+private:
+    int m_fd = -1;
+};
+
+struct Chain {
+    EQProcessor eq;
+    std::unique_ptr<HaasProcessor> haas = std::make_unique<HaasProcessor>();
+    std::unique_ptr<BinauralProcessor> binaural = std::make_unique<BinauralProcessor>();
+    std::unique_ptr<ReverbProcessor> reverb = std::make_unique<ReverbProcessor>();
+    std::unique_ptr<DynamicProcessor> dynamics = std::make_unique<DynamicProcessor>();
+
+    Chain(int sampleRate, const Setting& setting) {
+        eq.setSampleRate(sampleRate);
+        haas->setSampleRate(sampleRate);
+        binaural->setSampleRate(sampleRate);
+        reverb->setSampleRate(sampleRate);
+        dynamics->setSampleRate(sampleRate);
+        haas->allocateState();
+        reverb->allocateState();
+        applySetting(setting, &eq, haas.get(), binaural.get(), dynamics.get());
+    }
+};
+
+void mixAndPack(const float* dryL, const float* dryR, const float* wetL, const float* wetR,
+                int16_t* out, int frames, float intensity) {
+    for (int i = 0; i < frames; i++) {
+        float l = dryL[i] * (1.0f - intensity) + wetL[i] * intensity;
+        float r = dryR[i] * (1.0f - intensity) + wetR[i] * intensity;
+        out[i * 2] = (int16_t)(std::clamp(l, -1.0f, 1.0f) * 32767.0f);
+        out[i * 2 + 1] = (int16_t)(std::clamp(r, -1.0f, 1.0f) * 32767.0f);
+    }
+}
+
+void deinterleave(const int16_t* in, float* left, float* right, int frames) {
+    for (int i = 0; i < frames; i++) {
+        left[i] = in[i * 2] / 32768.0f;
+        right[i] = in[i * 2 + 1] / 32768.0f;
+    }
+}
+
+void benchPipeline(const Options& opts, std::vector<Result>& results) {
+    if (!opts.stageFilter.empty() && opts.stageFilter != "pipeline") return;
+
+    const int sampleRate = 48000;
+    const int hostFrames = 4096;   // deep-buffer period
+    const int kTiles[] = { 32, 64, 128, 256 };
+
+    size_t total = std::max<size_t>((size_t)(opts.seconds * sampleRate), hostFrames);
+    total = total / hostFrames * hostFrames;
+    std::vector<float> left(total), right(total);
+    fillSignal(left, right);
+    std::vector<int16_t> input(total * 2), output(total * 2);
+    for (size_t i = 0; i < total; i++) {
+        input[i * 2] = (int16_t)(std::clamp(left[i], -1.0f, 1.0f) * 32767.0f);
+        input[i * 2 + 1] = (int16_t)(std::clamp(right[i], -1.0f, 1.0f) * 32767.0f);
+    }
+
+    L1MissCounter counter;
+    auto measure = [&](const std::function<void(size_t, int)>& body, double& misses) {
+        counter.start();
+        for (size_t pos = 0; pos < total; pos += hostFrames) body(pos, hostFrames);
+        uint64_t count = counter.stop();
+        misses = counter.available() ? (double)count / total : -1.0;
+        return timeBlocks(opts, total, hostFrames, body);
+    };
+
+    for (const Setting& setting : kSettings) {
+        {
+            Chain chain(sampleRate, setting);
+            std::vector<float> bufs(6 * 2 * hostFrames);
+            auto buf = [&](int stage, int ch) { return bufs.data() + (stage * 2 + ch) * hostFrames; };
+            double misses;
+            double ns = measure([&](size_t pos, int n) {
+                deinterleave(input.data() + pos * 2, buf(0, 0), buf(0, 1), n);
+                chain.eq.process(buf(0, 0), buf(0, 1), buf(1, 0), buf(1, 1), n);
+                chain.haas->process(buf(1, 0), buf(1, 1), buf(2, 0), buf(2, 1), n);
+                chain.binaural->process(buf(2, 0), buf(2, 1), buf(3, 0), buf(3, 1), n);
+                chain.reverb->process(buf(3, 0), buf(3, 1), buf(4, 0), buf(4, 1), n);
+                chain.dynamics->process(buf(4, 0), buf(4, 1), buf(5, 0), buf(5, 1), n);
+                mixAndPack(buf(0, 0), buf(0, 1), buf(5, 0), buf(5, 1), output.data() + pos * 2, n,
+                           setting.intensity);
+            }, misses);
+            Result r{ "pipeline_staged", sampleRate, hostFrames, setting.name, ns,
+                      ns > 0.0 ? 1e9 / (ns * sampleRate) : 0.0 };
+            r.workingSetBytes = (double)bufs.size() * sizeof(float);
+            r.spillBytesPerFrame = r.workingSetBytes > kAssumedL1Bytes ? kIntermediateBytesPerFrame : 0.0;
+            r.l1dMissesPerFrame = misses;
+            results.push_back(r);
+        }
+
+        for (int tile : kTiles) {
+            Chain chain(sampleRate, setting);
+            std::vector<float> dry(2 * tile), wet(2 * tile);
+            double misses;
+            double ns = measure([&](size_t pos, int n) {
+                for (int offset = 0; offset < n; offset += tile) {
+                    int frames = std::min(tile, n - offset);
+                    float* dryL = dry.data();
+                    float* dryR = dry.data() + tile;
+                    float* wetL = wet.data();
+                    float* wetR = wet.data() + tile;
+                    deinterleave(input.data() + (pos + offset) * 2, dryL, dryR, frames);
+                    chain.eq.process(dryL, dryR, wetL, wetR, frames);
+                    chain.haas->process(wetL, wetR, wetL, wetR, frames);
+                    chain.binaural->process(wetL, wetR, wetL, wetR, frames);
+                    chain.reverb->process(wetL, wetR, wetL, wetR, frames);
+                    chain.dynamics->process(wetL, wetR, wetL, wetR, frames);
+                    mixAndPack(dryL, dryR, wetL, wetR, output.data() + (pos + offset) * 2, frames,
+                               setting.intensity);
+                }
+            }, misses);
+            Result r{ "pipeline_fused", sampleRate, tile, setting.name, ns,
+                      ns > 0.0 ? 1e9 / (ns * sampleRate) : 0.0 };
+            r.workingSetBytes = (double)(dry.size() + wet.size()) * sizeof(float);
+            r.spillBytesPerFrame = r.workingSetBytes > kAssumedL1Bytes ? kIntermediateBytesPerFrame : 0.0;
+            r.l1dMissesPerFrame = misses;
+            results.push_back(r);
+        }
+    }
+}
+
+// --- Instance lifecycle ---
+//
+// Memory and latency over an instance's life, through the effect interface
+// with kLifecycleInstances live at once. In these rows ns_per_frame holds
+// ns per operation and working_set_bytes the resident memory each instance
+// adds (process RSS delta / instances).
+//   create:   EffectCreate + SET_CONFIG; the instance has never played
+//   activate: first non-silent 256-frame callback, binding the delay lines
+//   reclaim:  after the tails and the idle period (100 ms here) have passed
+//             and the next command has dropped (and, by mode, repopulated)
+//             the delay-line pages
+//   reactivate: first non-silent callback after that reclaim
+// once per arena prefault mode: default (populate on enable), _cold (none)
+// and _locked (mlock at creation; falls back to populate without the limit).
+
+const int kLifecycleInstances = 32;
+
+size_t residentBytes() {
+#if defined(__linux__)
+    FILE* fp = fopen("/proc/self/statm", "r");
+    if (!fp) return 0;
+    unsigned long size = 0, resident = 0;
+    int fields = fscanf(fp, "%lu %lu", &size, &resident);
+    fclose(fp);
+    return fields == 2 ? (size_t)resident * (size_t)sysconf(_SC_PAGESIZE) : 0;
+#else
+    return 0;
+#endif
+}
+
+void benchLifecycle(const Options& opts, std::vector<Result>& results) {
+    if (!opts.stageFilter.empty() && opts.stageFilter != "lifecycle") return;
+    static const effect_uuid_t kUuid =
+            { 0x87654321, 0x4321, 0x8765, 0x4321, { 0xfe, 0xdc, 0xba, 0x09, 0x87, 0x65 } };
+    const int sampleRate = 48000;
+    const int block = 256;
+
+    std::vector<float> left(block), right(block);
+    fillSignal(left, right);
+    std::vector<int16_t> signal(2 * block), silence(2 * block, 0), output(2 * block);
+    interleaveStereo(left.data(), right.data(), signal.data(), AUDIO_FORMAT_PCM_16_BIT, block, false);
+    auto process = [&](effect_interface_t** itfe, std::vector<int16_t>& input) {
+        audio_buffer_t in{}, out{};
+        in.frameCount = block;
+        in.s16 = input.data();
+        out.frameCount = block;
+        out.s16 = output.data();
+        (*itfe)->process(itfe, &in, &out);
+    };
+    auto elapsedNs = [](std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    };
+    auto perInstance = [](size_t before, size_t after) {
+        return after > before ? (double)(after - before) / kLifecycleInstances : 0.0;
+    };
+
+    static const struct { int mode; const char* suffix; } kModes[] = {
+        { DspArena::PREFAULT_POPULATE, "" },
+        { DspArena::PREFAULT_NONE, "_cold" },
+        { DspArena::PREFAULT_LOCK, "_locked" },
+    };
+    for (const auto& prefault : kModes) {
+        std::vector<effect_interface_t*> handles(kLifecycleInstances, nullptr);
+        const size_t rssStart = residentBytes();
+        auto start = std::chrono::steady_clock::now();
+        for (effect_interface_t*& handle : handles) {
+            if (AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&kUuid, 0, 0, &handle) != 0) return;
+            setConfig(&handle, sampleRate, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO);
+            setParam(&handle, PARAM_PREFAULT, (float)prefault.mode);
+        }
+        const double createNs = elapsedNs(start) / kLifecycleInstances;
+        const size_t rssCreated = residentBytes();
+
+        double activateNs = 0.0;
+        for (effect_interface_t*& handle : handles) {
+            setParam(&handle, PARAM_IDLE_RECLAIM_MS, 100.0f);
+            int32_t reply = 0;
+            uint32_t replySize = sizeof(reply);
+            (*handle).command(&handle, EFFECT_CMD_ENABLE, 0, nullptr, &replySize, &reply);
+            start = std::chrono::steady_clock::now();
+            process(&handle, signal);
+            activateNs += elapsedNs(start);
+        }
+        activateNs /= kLifecycleInstances;
+        const size_t rssActive = residentBytes();
+
+        // The reverb's 2.1 s decay from full scale down to the silence
+        // threshold (100 dB, 3.5 s), the chain's tail after that (~16k
+        // frames) and the 100 ms idle period.
+        const int silentCallbacks = (4 * sampleRate + 16384 + sampleRate / 10) / block + 1;
+        for (effect_interface_t*& handle : handles) {
+            for (int i = 0; i < silentCallbacks; i++) process(&handle, silence);
+            // The reclaim is acted on by the next command, like a status poll
+            getParam(&handle, PARAM_PREFAULT);
+        }
+        const size_t rssReclaimed = residentBytes();
+
+        double reactivateNs = 0.0;
+        for (effect_interface_t*& handle : handles) {
+            start = std::chrono::steady_clock::now();
+            process(&handle, signal);
+            reactivateNs += elapsedNs(start);
+        }
+        reactivateNs /= kLifecycleInstances;
+        const size_t rssReactivated = residentBytes();
+
+        for (effect_interface_t*& handle : handles) AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(&handle);
+
+        const std::string suffix = prefault.suffix;
+        Result create{ "lifecycle", sampleRate, block, "create" + suffix, createNs, 0.0 };
+        create.workingSetBytes = perInstance(rssStart, rssCreated);
+        Result activate{ "lifecycle", sampleRate, block, "activate" + suffix, activateNs, 0.0 };
+        activate.workingSetBytes = perInstance(rssStart, rssActive);
+        Result reclaim{ "lifecycle", sampleRate, block, "reclaim" + suffix, 0.0, 0.0 };
+        reclaim.workingSetBytes = perInstance(rssStart, rssReclaimed);
+        Result reactivate{ "lifecycle", sampleRate, block, "reactivate" + suffix, reactivateNs, 0.0 };
+        reactivate.workingSetBytes = perInstance(rssStart, rssReactivated);
+        results.push_back(create);
+        results.push_back(activate);
+        results.push_back(reclaim);
+        results.push_back(reactivate);
+    }
+}
+
+// --- Preset switching ---
+//
+// Command-thread cost of changing the whole café character on one 48 kHz
+// instance, ns per switch in ns_per_frame:
+//   set_params: intensity, width and distance as three SET_PARAMs, each
+//               designing a full snapshot
+//   preset:     one PARAM_PRESET from a bank written to a temp file
+const int kPresetSwitches = 20000;
+
+void benchPresets(const Options& opts, std::vector<Result>& results) {
+    if (!opts.stageFilter.empty() && opts.stageFilter != "presets") return;
+    static const effect_uuid_t kUuid =
+            { 0x87654321, 0x4321, 0x8765, 0x4321, { 0xfe, 0xdc, 0xba, 0x09, 0x87, 0x65 } };
+    const int sampleRate = 48000;
+    const float kValues[2][3] = { { 0.7f, 0.6f, 0.8f }, { 0.85f, 0.7f, 1.0f } };
+
+    char path[] = "/tmp/cafetone-bench-presets-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return;
+    close(fd);
+    std::vector<ChainCoeffs> records;
+    const float haasWidth = HaasProcessor().getParameter(1);
+    std::shared_ptr<const DistanceTable> table = DistanceTable::forRate(sampleRate);
+    for (const auto& v : kValues) records.push_back(ChainCoeffs::design(v[0], v[1], v[2], haasWidth, *table));
+    bool written = PresetBank::write(path, { "a", "b" }, { sampleRate }, records);
+    PresetBank::setDefaultPath(path);
+
+    effect_interface_t* handle = nullptr;
+    if (!written || AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&kUuid, 0, 0, &handle) != 0) {
+        unlink(path);
+        return;
+    }
+    setConfig(&handle, sampleRate, AUDIO_FORMAT_PCM_16_BIT, AUDIO_CHANNEL_OUT_STEREO);
+    setParam(&handle, PARAM_PRESET, 0.0f);   // maps the bank outside the timed loop
+
+    auto timeSwitches = [&](const std::function<void(int)>& body) {
+        double best = 0.0;
+        for (int rep = 0; rep < opts.repetitions; rep++) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < kPresetSwitches; i++) body(i & 1);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            if (rep == 0 || ns < best) best = ns;
+        }
+        return best / kPresetSwitches;
+    };
+    double setParamsNs = timeSwitches([&](int which) {
+        setParam(&handle, PARAM_INTENSITY, kValues[which][0]);
+        setParam(&handle, PARAM_SPATIAL_WIDTH, kValues[which][1]);
+        setParam(&handle, PARAM_DISTANCE, kValues[which][2]);
+    });
+    double presetNs = timeSwitches([&](int which) { setParam(&handle, PARAM_PRESET, (float)which); });
+    // A slider drag: distance only, a new value every call
+    double distanceNs = timeSwitches([&handle, step = 0](int) mutable {
+        setParam(&handle, PARAM_DISTANCE, (float)(step++ % 1000) / 999.0f);
+    });
+
+    AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(&handle);
+    PresetBank::setDefaultPath(PresetBank::DEFAULT_PATH);
+    unlink(path);
+
+    results.push_back({ "presets", sampleRate, 0, "set_params", setParamsNs, 0.0 });
+    results.push_back({ "presets", sampleRate, 0, "preset", presetNs, 0.0 });
+    results.push_back({ "presets", sampleRate, 0, "distance_sweep", distanceNs, 0.0 });
+}
+
+// --- FIR EQ engine ---
+//
+// EQProcessor in its FIR modes at the chain's default 64-frame tile, one row
+// per partition size (the block column) and phase (the setting column) at
+// the default distance. The partition size trades latency against FFTs per
+// frame. eq_fir_design rows hold the command-thread cost of one design in
+// ns_per_frame, ns per design.
+const int kFirPartitions[] = { 32, 64, 128, 256, 512 };
+
+void benchFirEq(const Options& opts, std::vector<Result>& results) {
+    if (!opts.stageFilter.empty() && opts.stageFilter != "eq_fir") return;
+    const int tile = 64;
+    const Setting& setting = kSettings[1];
+    const HeadphoneCurve flat;
+    static const struct { EQProcessor::Mode mode; const char* name; } kModes[] = {
+        { EQProcessor::MODE_LINEAR_PHASE, "linear" },
+        { EQProcessor::MODE_MINIMUM_PHASE, "minimum" },
+    };
+    for (int sampleRate : kSampleRates) {
+        size_t total = std::max<size_t>((size_t)(opts.seconds * sampleRate), 4096);
+        std::vector<float> inL(total), inR(total), outL(total), outR(total);
+        fillSignal(inL, inR);
+        const EQProcessor::Coeffs coeffs = DistanceTable::forRate(sampleRate)->eq(setting.distance);
+
+        for (const auto& mode : kModes) {
+            for (int partition : kFirPartitions) {
+                EQProcessor eq;
+                eq.setSampleRate(sampleRate);
+                eq.allocateState();
+                auto start = std::chrono::steady_clock::now();
+                eq.designFir(mode.mode, coeffs, flat, partition);
+                double designNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                double ns = timeBlocks(opts, total, tile, [&](size_t pos, int n) {
+                    eq.process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, n);
+                });
+                results.push_back({ "eq_fir", sampleRate, partition, mode.name, ns,
+                                    ns > 0.0 ? 1e9 / (ns * sampleRate) : 0.0 });
+                results.push_back({ "eq_fir_design", sampleRate, partition, mode.name, designNs, 0.0 });
+            }
+        }
+    }
+}
+
+// --- Haas kernel vs. per-sample loop ---
+//
+// haas_kernel/.../block is HaasProcessor's chunked SIMD kernel;
+// .../per_sample is the loop it replaced, kept here as the reference: the
+// same taps and gains evaluated one sample at a time, with the crossfeed
+// delay, phase inversion, width factor and balance branch recomputed per
+// sample. Both run the default setting, and the outputs are compared so a
+// kernel change that alters the sound shows up here as well.
+
+class ReferenceHaas {
+public:
+    explicit ReferenceHaas(int sampleRate) : m_sampleRate(sampleRate), m_storage(2 * kLine, 0.0f) {
+        m_lines[0].setStorage(m_storage.data());
+        m_lines[1].setStorage(m_storage.data() + kLine);
+    }
+
+    void setCoeffs(const HaasProcessor::Coeffs& coeffs, float width) {
+        m_leftDelaySamples = coeffs.leftDelaySamples;
+        m_rightDelaySamples = coeffs.rightDelaySamples;
+        m_width = width;
+    }
+
+    void process(const float* leftIn, const float* rightIn, float* leftOut, float* rightOut, int frames) {
+        const float width = m_width;
+        const float balance = 0.0f;
+        for (int i = 0; i < frames; i++) {
+            float leftSignal = leftIn[i];
+            float rightSignal = rightIn[i];
+            float delayedLeft = m_lines[0].tap(m_leftDelaySamples);
+            float delayedRight = m_lines[1].tap(m_rightDelaySamples);
+            float phaseInvertAmount = 0.3f;
+            float invertedLeft = leftSignal * (1.0f - phaseInvertAmount) - leftSignal * phaseInvertAmount;
+            float invertedRight = rightSignal * (1.0f - phaseInvertAmount) - rightSignal * phaseInvertAmount;
+            float elevationGain = 0.85f;
+            invertedLeft *= elevationGain;
+            invertedRight *= elevationGain;
+            float crossfeedAmount = 0.22f;
+            int crossfeedDelaySamples = (int)(10.0f * m_sampleRate / 1000.0f);
+            float crossfeedLeft = m_lines[1].tap(crossfeedDelaySamples) * crossfeedAmount;
+            float crossfeedRight = m_lines[0].tap(crossfeedDelaySamples) * crossfeedAmount;
+            leftOut[i] = invertedLeft + delayedRight * 0.5f * width + crossfeedLeft;
+            rightOut[i] = invertedRight + delayedLeft * 0.5f * width + crossfeedRight;
+            float widthFactor = 1.0f + (width - 0.5f) * 0.4f;
+            leftOut[i] *= widthFactor;
+            rightOut[i] *= widthFactor;
+            if (balance > 0.0f) {
+                leftOut[i] *= (1.0f - balance * 0.3f);
+                rightOut[i] *= (1.0f + balance * 0.3f);
+            } else {
+                leftOut[i] *= (1.0f + balance * 0.3f);
+                rightOut[i] *= (1.0f - balance * 0.3f);
+            }
+            m_lines[0].write(leftSignal);
+            m_lines[1].write(rightSignal);
+        }
+    }
+
+private:
+    static const int kLine = 2048;
+    int m_sampleRate;
+    std::vector<float> m_storage;
+    DelayLine<kLine> m_lines[2];
+    int m_leftDelaySamples = 1;
+    int m_rightDelaySamples = 1;
+    float m_width = 0.0f;
+};
+
+void benchHaasKernel(const Options& opts, std::vector<Result>& results) {
+    if (!opts.stageFilter.empty() && opts.stageFilter != "haas_kernel") return;
+    const Setting& setting = kSettings[1];
+    for (int sampleRate : kSampleRates) {
+        size_t total = std::max<size_t>((size_t)(opts.seconds * sampleRate), 4096);
+        std::vector<float> inL(total), inR(total), outL(total), outR(total), refL(total), refR(total);
+        fillSignal(inL, inR);
+
+        for (int block : kBlockSizes) {
+            auto haas = std::make_unique<HaasProcessor>();
+            haas->setSampleRate(sampleRate);
+            haas->allocateState();
+            applySetting(setting, nullptr, haas.get(), nullptr, nullptr);
+            ReferenceHaas reference(sampleRate);
+            const float width = haas->getParameter(1);
+            reference.setCoeffs(HaasProcessor::designCoeffs(haas->getParameter(0), width, sampleRate), width);
+
+            // One untimed pass each over the same input, from cleared lines
+            float maxError = 0.0f;
+            for (size_t pos = 0; pos + block <= total; pos += block) {
+                haas->process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, block);
+                reference.process(inL.data() + pos, inR.data() + pos, refL.data() + pos, refR.data() + pos, block);
+            }
+            for (size_t i = 0; i < total / block * block; i++) {
+                maxError = std::max({ maxError, fabsf(outL[i] - refL[i]), fabsf(outR[i] - refR[i]) });
+            }
+            if (maxError > 1e-5f) {
+                fprintf(stderr, "haas_kernel/%d/%d: kernel differs from the reference by %g\n", sampleRate, block,
+                        maxError);
+            }
+
+            double ns = timeBlocks(opts, total, block, [&](size_t pos, int n) {
+                haas->process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, n);
+            });
+            results.push_back({ "haas_kernel", sampleRate, block, "block", ns,
+                                ns > 0.0 ? 1e9 / (ns * sampleRate) : 0.0 });
+            ns = timeBlocks(opts, total, block, [&](size_t pos, int n) {
+                reference.process(inL.data() + pos, inR.data() + pos, refL.data() + pos, refR.data() + pos, n);
+            });
+            results.push_back({ "haas_kernel", sampleRate, block, "per_sample", ns,
+                                ns > 0.0 ? 1e9 / (ns * sampleRate) : 0.0 });
+        }
+    }
+}
+
+// --- HRTF convolution ---
+//
+// binaural_hrtf/<rate>/<taps>/... times the HRTF engine with synthetic
+// responses of each length (the cost does not depend on their contents):
+// "renderer" is HrtfRenderer alone for the stereo pair, "per_source" half
+// of it (one virtual speaker into both ears), "stage" the whole binaural
+// stage in HRTF mode and "stage_gain" the same stage on its gain
+// approximation, all at the chain's default 64-frame tile.
+
+const int kHrirLengths[] = { 128, 256, 512 };
+
+void benchHrtf(const Options& opts, std::vector<Result>& results) {
+    if (!opts.stageFilter.empty() && opts.stageFilter != "binaural_hrtf") return;
+    const int tile = 64;
+    const Setting& setting = kSettings[1];
+    for (int sampleRate : kSampleRates) {
+        size_t total = std::max<size_t>((size_t)(opts.seconds * sampleRate), 4096);
+        std::vector<float> inL(total), inR(total), outL(total), outR(total);
+        fillSignal(inL, inR);
+
+        for (int length : kHrirLengths) {
+            std::vector<float> taps(4 * (size_t)length);
+            uint32_t seed = 0x2468aceu;
+            for (size_t i = 0; i < taps.size(); i++) {
+                seed = seed * 1664525u + 1013904223u;
+                const float decay = expf(-6.0f * (float)(i % length) / (float)length);
+                taps[i] = ((float)(seed >> 8) / 8388608.0f - 1.0f) * decay;
+            }
+            const float* const pairs[2][2] = { { &taps[0], &taps[length] },
+                                               { &taps[2 * (size_t)length], &taps[3 * (size_t)length] } };
+
+            HrtfRenderer renderer;
+            std::vector<float> storage(HrtfRenderer::STATE_BYTES / sizeof(float));
+            renderer.post(HrtfRenderer::design(pairs, length));
+            renderer.setStorage(storage.data());
+            renderer.update();
+            double ns = timeBlocks(opts, total, tile, [&](size_t pos, int n) {
+                renderer.process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, n);
+            });
+            results.push_back({ "binaural_hrtf", sampleRate, length, "renderer", ns,
+                                ns > 0.0 ? 1e9 / (ns * sampleRate) : 0.0 });
+            results.push_back({ "binaural_hrtf", sampleRate, length, "per_source", ns / 2.0,
+                                ns > 0.0 ? 2e9 / (ns * sampleRate) : 0.0 });
+
+            for (bool hrtf : { true, false }) {
+                auto binaural = std::make_unique<BinauralProcessor>();
+                binaural->setSampleRate(sampleRate);
+                binaural->allocateState();
+                applySetting(setting, nullptr, nullptr, binaural.get(), nullptr);
+                if (hrtf) binaural->postHrtf(HrtfRenderer::design(pairs, length));
+                double stageNs = timeBlocks(opts, total, tile, [&](size_t pos, int n) {
+                    binaural->process(inL.data() + pos, inR.data() + pos, outL.data() + pos, outR.data() + pos, n);
+                });
+                results.push_back({ "binaural_hrtf", sampleRate, length, hrtf ? "stage" : "stage_gain", stageNs,
+                                    stageNs > 0.0 ? 1e9 / (stageNs * sampleRate) : 0.0 });
+            }
+        }
+    }
+}
+
+// --- HRTF direction grid ---
+//
+// Command-thread cost of HRTF directions, from a synthetic set on the model
+// layout (15 degrees of azimuth, rings 20 degrees apart) written to a temp
+// file. ns_per_frame holds ns per operation and working_set_bytes the
+// memory behind it; block is the grid's minimum-phase length:
+//   build:  HrtfGrid::build, ns per grid point; the grid's bytes
+//   blend:  an HrtfPairCache miss (grid blend and partition transforms);
+//           the cache's bytes once full
+//   lookup: a hit on the same cache
+const int kGridDirections = 2000;
+
+void benchHrtfGrid(const Options& opts, std::vector<Result>& results) {
+    if (!opts.stageFilter.empty() && opts.stageFilter != "hrtf_grid") return;
+    const int length = 256;
+    std::vector<HrirDatabase::Direction> directions;
+    for (int elevation = -40; elevation <= 60; elevation += 20) {
+        for (int azimuth = -180; azimuth < 180; azimuth += 15) {
+            directions.push_back({ (float)azimuth, (float)elevation });
+        }
+    }
+    directions.push_back({ 0.0f, 90.0f });
+    std::vector<int> rates(std::begin(kSampleRates), std::end(kSampleRates));
+    std::vector<float> taps;
+    uint32_t seed = 0x13579bdu;
+    for (int sampleRate : rates) {
+        for (const HrirDatabase::Direction& d : directions) {
+            // Decaying noise behind a spherical-head interaural delay
+            const float itd = 0.00066f * sampleRate * sinf(d.azimuth * (float)M_PI / 180.0f) *
+                              cosf(d.elevation * (float)M_PI / 180.0f);
+            for (int ear = 0; ear < 2; ear++) {
+                const int onset = 8 + (int)(ear == 0 ? std::max(itd, 0.0f) : std::max(-itd, 0.0f));
+                for (int i = 0; i < length; i++) {
+                    seed = seed * 1664525u + 1013904223u;
+                    const float noise = (float)(seed >> 8) / 8388608.0f - 1.0f;
+                    taps.push_back(i < onset ? 0.0f : noise * expf(-12.0f * (float)(i - onset) / (float)length));
+                }
+            }
+        }
+    }
+    char path[] = "/tmp/cafetone-bench-hrir-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) return;
+    close(fd);
+    const bool written = HrirDatabase::write(path, rates, directions, length, taps);
+    std::shared_ptr<const HrirDatabase> hrirs = written ? HrirDatabase::open(path) : nullptr;
+    unlink(path);
+    if (!hrirs) return;
+
+    for (int sampleRate : kSampleRates) {
+        double buildNs = 0.0;
+        std::shared_ptr<const HrtfGrid> grid;
+        for (int rep = 0; rep < opts.repetitions; rep++) {
+            auto start = std::chrono::steady_clock::now();
+            grid = HrtfGrid::build(hrirs, sampleRate);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            if (rep == 0 || ns < buildNs) buildNs = ns;
+        }
+        const int points = HrtfGrid::AZIMUTHS * HrtfGrid::ELEVATIONS;
+        results.push_back({ "hrtf_grid", sampleRate, grid->length(), "build", buildNs / points, 0.0,
+                            (double)grid->bytes() });
+
+        // Every direction a new one: each lookup misses
+        HrtfPairCache pairs;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kGridDirections; i++) {
+            pairs.lookup(*grid, (float)(i % 360) - 180.0f, (float)(i % 7) * 10.0f - 20.0f, HrtfRenderer::PARTITION);
+        }
+        const double blendNs =
+                std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                kGridDirections;
+        results.push_back({ "hrtf_grid", sampleRate, grid->length(), "blend", blendNs, 0.0, (double)pairs.bytes() });
+
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kGridDirections; i++) {
+            pairs.lookup(*grid, (float)(i & 1) * 60.0f - 30.0f, 0.0f, HrtfRenderer::PARTITION);
+        }
+        const double lookupNs =
+                std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                kGridDirections;
+        results.push_back({ "hrtf_grid", sampleRate, grid->length(), "lookup", lookupNs, 0.0,
+                            (double)pairs.bytes() });
+    }
+}
+
+void printResults(const Options& opts, const std::vector<Result>& results) {
+    if (opts.format == "json") {
+        printf("[\n");
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result& r = results[i];
+            printf("  {\"key\": \"%s\", \"stage\": \"%s\", \"sample_rate\": %d, \"block\": %d, "
+                   "\"setting\": \"%s\", \"ns_per_frame\": %.3f, \"realtime_x\": %.1f, "
+                   "\"working_set_bytes\": %.0f, \"spill_bytes_per_frame\": %.1f, "
+                   "\"l1d_misses_per_frame\": %.3f}%s\n",
+                   r.key().c_str(), r.stage.c_str(), r.sampleRate, r.block, r.setting.c_str(),
+                   r.nsPerFrame, r.realtimeX, r.workingSetBytes, r.spillBytesPerFrame, r.l1dMissesPerFrame,
+                   i + 1 < results.size() ? "," : "");
+        }
+        printf("]\n");
+        return;
+    }
+    printf("key,stage,sample_rate,block,setting,ns_per_frame,realtime_x,"
+           "working_set_bytes,spill_bytes_per_frame,l1d_misses_per_frame\n");
+    for (const Result& r : results) {
+        printf("%s,%s,%d,%d,%s,%.3f,%.1f,%.0f,%.1f,%.3f\n", r.key().c_str(), r.stage.c_str(), r.sampleRate,
+               r.block, r.setting.c_str(), r.nsPerFrame, r.realtimeX, r.workingSetBytes,
+               r.spillBytesPerFrame, r.l1dMissesPerFrame);
+    }
+}
+
+// Compares against a CSV produced by a previous run; returns the number of
+// rows that got slower by more than the tolerance.
+int compareBaseline(const Options& opts, const std::vector<Result>& results) {
+    FILE* fp = fopen(opts.baselinePath.c_str(), "r");
+    if (!fp) {
+        fprintf(stderr, "cannot open baseline %s\n", opts.baselinePath.c_str());
+        return -1;
+    }
+    std::map<std::string, double> baseline;
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        std::vector<std::string> fields;
+        char* save = nullptr;
+        for (char* tok = strtok_r(line, ",\n", &save); tok; tok = strtok_r(nullptr, ",\n", &save)) {
+            fields.emplace_back(tok);
+        }
+        if (fields.size() >= 6 && fields[0] != "key") baseline[fields[0]] = atof(fields[5].c_str());
+    }
+    fclose(fp);
+
+    int regressions = 0;
+    for (const Result& r : results) {
+        auto it = baseline.find(r.key());
+        if (it == baseline.end() || it->second <= 0.0) continue;
+        double deltaPct = (r.nsPerFrame - it->second) / it->second * 100.0;
+        if (deltaPct > opts.tolerancePct) {
+            fprintf(stderr, "REGRESSION %s: %.3f -> %.3f ns/frame (%+.1f%%)\n",
+                    r.key().c_str(), it->second, r.nsPerFrame, deltaPct);
+            regressions++;
+        }
+    }
+    fprintf(stderr, "%d regression(s) above %.1f%% against %s\n", regressions, opts.tolerancePct,
+            opts.baselinePath.c_str());
+    return regressions;
+}
+
+// --- EQ magnitude response ---
+//
+// Drives a sine through a settled EQProcessor at each test frequency and
+// compares the measured gain with the designed cascade response, for the
+// cascade and both FIR modes (default partition size). Run with
+// --eq-response; prints CSV and skips the timing suites.
+
+const float kResponseFrequencies[] = { 20, 30, 40, 60, 80, 120, 200, 350, 500, 800, 1000, 1500, 2000,
+                                       3000, 5000, 7000, 9000, 12000, 16000, 20000 };
+
+void printEqResponse() {
+    static const struct { EQProcessor::Mode mode; const char* name; } kModes[] = {
+        { EQProcessor::MODE_CASCADE, "cascade" },
+        { EQProcessor::MODE_LINEAR_PHASE, "fir_linear" },
+        { EQProcessor::MODE_MINIMUM_PHASE, "fir_minimum" },
+    };
+    printf("sample_rate,setting,mode,frequency_hz,designed_db,measured_db\n");
+    for (int sampleRate : kSampleRates) {
+        for (const Setting& setting : kSettings) {
+          for (const auto& mode : kModes) {
+            for (float frequency : kResponseFrequencies) {
+                if (frequency >= sampleRate * 0.45f) continue;
+                EQProcessor eq;
+                eq.setSampleRate(sampleRate);
+                applySetting(setting, &eq, nullptr, nullptr, nullptr);
+                if (mode.mode != EQProcessor::MODE_CASCADE) {
+                    eq.allocateState();
+                    eq.designFir(mode.mode, EQProcessor::designCoeffs(DistanceTable::highPassFreq(setting.distance),
+                                                                      DistanceTable::lowPassFreq(setting.distance),
+                                                                      sampleRate),
+                                 HeadphoneCurve(), FirEq::DEFAULT_PARTITION);
+                }
+
+                // One second to settle the 20 Hz sections, then RMS over
+                // another second (a whole number of cycles at every rate).
+                const int frames = sampleRate;
+                std::vector<float> input(frames), output(frames);
+                double inPower = 0.0, outPower = 0.0;
+                for (int pass = 0; pass < 2; pass++) {
+                    for (int i = 0; i < frames; i++) {
+                        input[i] = sinf(2.0f * (float)M_PI * frequency * (float)((double)(pass * frames + i) / sampleRate));
+                    }
+                    eq.process(input.data(), output.data(), frames);
+                    if (pass == 0) continue;
+                    for (int i = 0; i < frames; i++) {
+                        inPower += (double)input[i] * input[i];
+                        outPower += (double)output[i] * output[i];
+                    }
+                }
+                printf("%d,%s,%s,%.0f,%.2f,%.2f\n", sampleRate, setting.name, mode.name, frequency,
+                       eq.magnitudeDb(frequency), 10.0 * log10(outPower / inPower));
+            }
+          }
+        }
+    }
+}
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --format csv|json        output format (default csv)\n"
+            "  --stage <name>           only run eq|haas|binaural|reverb|dynamics|\n"
+            "                           chain|chain_f32|chain_51|chain_71|chain_silence|\n"
+            "                           chain_automate|chain_subblock|pipeline|lifecycle|presets|eq_fir|\n"
+            "                           haas_kernel|binaural_hrtf|hrtf_grid\n"
+            "  --seconds <s>            audio rendered per repetition (default 0.25)\n"
+            "  --repetitions <n>        timed repetitions, best is reported (default 5)\n"
+            "  --baseline <file.csv>    compare with a previous CSV run\n"
+            "  --tolerance <pct>        allowed slowdown before a row counts as a regression (default 10)\n"
+            "  --eq-response            print the EQ's designed vs. measured magnitude response and exit\n",
+            argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opts;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--format" && hasValue) opts.format = argv[++i];
+        else if (arg == "--stage" && hasValue) opts.stageFilter = argv[++i];
+        else if (arg == "--seconds" && hasValue) opts.seconds = atof(argv[++i]);
+        else if (arg == "--repetitions" && hasValue) opts.repetitions = atoi(argv[++i]);
+        else if (arg == "--baseline" && hasValue) opts.baselinePath = argv[++i];
+        else if (arg == "--tolerance" && hasValue) opts.tolerancePct = atof(argv[++i]);
+        else if (arg == "--eq-response") opts.eqResponse = true;
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if ((opts.format != "csv" && opts.format != "json") || opts.seconds <= 0.0 || opts.repetitions <= 0) {
+        usage(argv[0]);
+        return 2;
+    }
+    gCafeToneHostLogLevel = 2;
+    if (opts.eqResponse) {
+        printEqResponse();
+        return 0;
+    }
+
+    std::vector<Result> results;
+    benchStages(opts, results);
+    benchChain(opts, "chain", results);
+    benchChain(opts, "chain_f32", results);
+    benchChain(opts, "chain_51", results);
+    benchChain(opts, "chain_71", results);
+    benchChain(opts, "chain_silence", results);
+    benchChain(opts, "chain_automate", results);
+    benchChain(opts, "chain_subblock", results);
+    benchPipeline(opts, results);
+    benchLifecycle(opts, results);
+    benchPresets(opts, results);
+    benchFirEq(opts, results);
+    benchHaasKernel(opts, results);
+    benchHrtf(opts, results);
+    benchHrtfGrid(opts, results);
+    printResults(opts, results);
+
+    if (!opts.baselinePath.empty()) {
+        int regressions = compareBaseline(opts, results);
+        return regressions == 0 ? 0 : 1;
+    }
+    return 0;
+}
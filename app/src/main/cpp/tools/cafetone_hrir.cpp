@@ -0,0 +1,207 @@
+// cafetone-hrir: builds the binary HRIR set the effect maps for its HRTF
+// mode (see hrir_database.h).
+//
+// Two sources:
+//  - the default spherical head model: a rigid sphere of 8.75 cm radius
+//    with the ears at +-90 degrees, Woodworth's ray-tracing delay and the
+//    Brown-Duda one-pole head shadow per ear, plus a pinna notch that rises
+//    from 6.4 kHz below the horizon to about 12 kHz overhead as the
+//    elevation cue. Generic, but smooth and free of measurement noise;
+//  - a measured set, e.g. a SOFA file, dumped to text with any netCDF/HDF5
+//    reader. The dump is whitespace-separated numbers:
+//        sampleRate length count
+//    then count measurements of
+//        azimuth elevation
+//        length left-ear taps
+//        length right-ear taps
+//    with azimuth in the effect's convention (degrees, positive to the
+//    right; SOFA's is positive to the left, so negate it).
+// Rates the set does not cover leave the effect on its gain approximation.
+
+#include "hrir_database.h"
+
+#define LOG_TAG "cafetone-hrir"
+#include "dsp_log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+const double kHeadRadius = 0.0875;     // m
+const double kSpeedOfSound = 343.0;    // m/s
+const double kOnsetMs = 0.25;          // room for the zero-phase notch to ring before the onset
+const int kGridSize = 2048;            // frequency-sampling grid
+
+// Model directions: every 15 degrees of azimuth on rings 20 degrees apart,
+// and one straight overhead.
+const int kAzimuthStep = 15;
+const int kElevations[] = { -40, -20, 0, 20, 40, 60 };
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options] <output.bin>\n"
+            "  -r, --rates <list>     model sample rates, comma separated (default 44100,48000,96000)\n"
+            "  -n, --length <taps>    model taps per ear (default 256)\n"
+            "  -i, --import <dump>    convert a measured set dumped as text instead of the model\n",
+            argv0);
+}
+
+// Unit vector: x ahead, y to the right, z up.
+void directionVector(double azimuth, double elevation, double (&v)[3]) {
+    const double az = azimuth * M_PI / 180.0;
+    const double el = elevation * M_PI / 180.0;
+    v[0] = cos(el) * cos(az);
+    v[1] = cos(el) * sin(az);
+    v[2] = sin(el);
+}
+
+// One ear's response to a far source, length taps at sampleRate.
+void modelResponse(double azimuth, double elevation, int ear, int sampleRate, int length, float* taps) {
+    double v[3];
+    directionVector(azimuth, elevation, v);
+    // Angle between the source and the ear's axis
+    const double axis = ear == 0 ? -v[1] : v[1];
+    const double theta = acos(std::max(-1.0, std::min(1.0, axis)));
+    const double a = kHeadRadius / kSpeedOfSound;
+    const double delay = (theta < M_PI / 2 ? -a * cos(theta) : a * (theta - M_PI / 2)) + a + kOnsetMs / 1000.0;
+    // Head shadow: +6 dB towards the ear down to -20 dB at 150 degrees
+    // off it, above about 2 * c / r
+    const double thetaDeg = theta * 180.0 / M_PI;
+    const double alpha = 1.05 + 0.95 * cos(std::min(thetaDeg / 150.0, 1.0) * M_PI);
+    const double w0 = kSpeedOfSound / kHeadRadius;
+    const double notch = 8000.0 + 40.0 * elevation;
+
+    std::vector<double> re(kGridSize / 2 + 1), im(kGridSize / 2 + 1);
+    for (int k = 0; k <= kGridSize / 2; k++) {
+        const double f = (double)k * sampleRate / kGridSize;
+        const double w = 2.0 * M_PI * f;
+        // (1 + j alpha w / 2w0) / (1 + j w / 2w0)
+        const double nr = 1.0, ni = alpha * w / (2.0 * w0);
+        const double dr = 1.0, di = w / (2.0 * w0);
+        const double den = dr * dr + di * di;
+        double hr = (nr * dr + ni * di) / den;
+        double hi = (ni * dr - nr * di) / den;
+        if (f > 0.0) {
+            const double octaves = log2(f / notch);
+            const double gain = pow(10.0, -10.0 * exp(-octaves * octaves / (2.0 * 0.15 * 0.15)) / 20.0);
+            hr *= gain;
+            hi *= gain;
+        }
+        const double phase = -w * delay;
+        re[k] = hr * cos(phase) - hi * sin(phase);
+        im[k] = hr * sin(phase) + hi * cos(phase);
+    }
+    // Inverse transform of the one-sided spectrum, first length taps, the
+    // last quarter faded out
+    const int fadeStart = length - length / 4;
+    for (int n = 0; n < length; n++) {
+        double sum = re[0] + re[kGridSize / 2] * ((n & 1) ? -1.0 : 1.0);
+        for (int k = 1; k < kGridSize / 2; k++) {
+            const double angle = 2.0 * M_PI * (double)k * n / kGridSize;
+            sum += 2.0 * (re[k] * cos(angle) - im[k] * sin(angle));
+        }
+        double window = 1.0;
+        if (n >= fadeStart) window = 0.5 + 0.5 * cos(M_PI * (n - fadeStart) / (double)(length - fadeStart));
+        taps[n] = (float)(sum / kGridSize * window);
+    }
+}
+
+void buildModel(const std::vector<int>& rates, int length, std::vector<HrirDatabase::Direction>& directions,
+                std::vector<float>& taps) {
+    for (int elevation : kElevations) {
+        for (int azimuth = -180; azimuth < 180; azimuth += kAzimuthStep) {
+            directions.push_back({ (float)azimuth, (float)elevation });
+        }
+    }
+    directions.push_back({ 0.0f, 90.0f });
+    taps.resize(rates.size() * directions.size() * 2 * (size_t)length);
+    float* out = taps.data();
+    for (int rate : rates) {
+        for (const HrirDatabase::Direction& d : directions) {
+            for (int ear = 0; ear < 2; ear++) {
+                modelResponse(d.azimuth, d.elevation, ear, rate, length, out);
+                out += length;
+            }
+        }
+    }
+}
+
+bool importDump(const char* path, std::vector<int>& rates, int& length,
+                std::vector<HrirDatabase::Direction>& directions, std::vector<float>& taps) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) return false;
+    int rate = 0, count = 0;
+    bool ok = fscanf(fp, "%d %d %d", &rate, &length, &count) == 3 && rate > 0 && length > 0 &&
+              length <= HrirDatabase::MAX_LENGTH && count > 0;
+    for (int m = 0; ok && m < count; m++) {
+        HrirDatabase::Direction d;
+        ok = fscanf(fp, "%f %f", &d.azimuth, &d.elevation) == 2;
+        directions.push_back(d);
+        for (int i = 0; ok && i < 2 * length; i++) {
+            float tap;
+            ok = fscanf(fp, "%f", &tap) == 1;
+            taps.push_back(tap);
+        }
+    }
+    fclose(fp);
+    rates.assign(1, rate);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string outputPath;
+    std::string importPath;
+    std::vector<int> rates = { 44100, 48000, 96000 };
+    int length = 256;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if ((arg == "-r" || arg == "--rates") && hasValue) {
+            rates.clear();
+            for (const char* p = argv[++i]; *p;) {
+                char* end;
+                rates.push_back((int)strtol(p, &end, 10));
+                if (end == p || rates.back() <= 0) { usage(argv[0]); return 2; }
+                p = *end == ',' ? end + 1 : end;
+            }
+        }
+        else if ((arg == "-n" || arg == "--length") && hasValue) { length = atoi(argv[++i]); }
+        else if ((arg == "-i" || arg == "--import") && hasValue) { importPath = argv[++i]; }
+        else if (arg == "-h" || arg == "--help") { usage(argv[0]); return 2; }
+        else if (!arg.empty() && arg[0] == '-') { fprintf(stderr, "unknown option: %s\n", arg.c_str()); return 2; }
+        else if (outputPath.empty()) { outputPath = arg; }
+        else { usage(argv[0]); return 2; }
+    }
+    if (outputPath.empty() || rates.empty() || length <= 0 || length > HrirDatabase::MAX_LENGTH) {
+        usage(argv[0]);
+        return 2;
+    }
+    gCafeToneHostLogLevel = 2;
+
+    std::vector<HrirDatabase::Direction> directions;
+    std::vector<float> taps;
+    if (!importPath.empty()) {
+        if (!importDump(importPath.c_str(), rates, length, directions, taps)) {
+            fprintf(stderr, "%s: not a readable HRIR dump\n", importPath.c_str());
+            return 1;
+        }
+    } else {
+        buildModel(rates, length, directions, taps);
+    }
+    if (!HrirDatabase::write(outputPath.c_str(), rates, directions, length, taps)) {
+        fprintf(stderr, "%s: write failed\n", outputPath.c_str());
+        return 1;
+    }
+    printf("directions=%zu rates=%zu length=%d bytes=%zu file=%s\n", directions.size(), rates.size(), length,
+           sizeof(HrirDatabase::FileHeader) + rates.size() * sizeof(int32_t) +
+                   directions.size() * sizeof(HrirDatabase::Direction) + taps.size() * sizeof(float),
+           outputPath.c_str());
+    return 0;
+}
@@ -0,0 +1,97 @@
+// cafetone-presets: builds the binary preset bank the effect maps for
+// PARAM_PRESET (see preset_bank.h).
+//
+// Every record is produced by ChainCoeffs::design(), the same code the
+// effect runs when parameters are set one by one, so selecting a preset is
+// bit-for-bit the same as setting its three values by hand; it only skips
+// the design work. Rebuild the bank whenever a designCoeffs() changes, or
+// the effect will refuse it if ChainCoeffs itself changed.
+
+#include "preset_bank.h"
+#include "haas_processor.h"
+
+#define LOG_TAG "cafetone-presets"
+#include "dsp_log.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct PresetDefinition {
+    const char* name;
+    float intensity;
+    float spatialWidth;
+    float distance;
+};
+
+// Index order is the PARAM_PRESET value; append only.
+const PresetDefinition kPresets[] = {
+    { "cafe",           0.70f, 0.60f, 0.80f },   // the effect's defaults
+    { "corner_table",   0.55f, 0.45f, 0.50f },
+    { "window_seat",    0.60f, 0.80f, 0.65f },
+    { "back_room",      0.85f, 0.70f, 1.00f },
+    { "espresso_bar",   0.40f, 0.35f, 0.25f },
+    { "terrace",        0.50f, 1.00f, 0.90f },
+};
+
+// Every rate an Android mixer runs at; others fall back to designing.
+const int kSampleRates[] = { 8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000, 88200, 96000, 176400, 192000 };
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options] <output.bin>\n"
+            "  -l, --list   print the presets and exit\n",
+            argv0);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string outputPath;
+    bool list = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-l" || arg == "--list") { list = true; }
+        else if (arg == "-h" || arg == "--help") { usage(argv[0]); return 2; }
+        else if (!arg.empty() && arg[0] == '-') { fprintf(stderr, "unknown option: %s\n", arg.c_str()); return 2; }
+        else if (outputPath.empty()) { outputPath = arg; }
+        else { usage(argv[0]); return 2; }
+    }
+    if (list) {
+        int index = 0;
+        for (const PresetDefinition& p : kPresets) {
+            printf("%d %-16s intensity=%.2f width=%.2f distance=%.2f\n", index++, p.name, p.intensity,
+                   p.spatialWidth, p.distance);
+        }
+        return 0;
+    }
+    if (outputPath.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    gCafeToneHostLogLevel = 2;
+
+    // The chain designs Haas taps with the processor's own width setting.
+    const float haasWidth = HaasProcessor().getParameter(1);
+
+    std::vector<std::string> names;
+    std::vector<int> rates(std::begin(kSampleRates), std::end(kSampleRates));
+    std::vector<ChainCoeffs> records;
+    for (const PresetDefinition& p : kPresets) {
+        names.emplace_back(p.name);
+        for (int rate : rates) {
+            std::shared_ptr<const DistanceTable> table = DistanceTable::forRate(rate);
+            records.push_back(ChainCoeffs::design(p.intensity, p.spatialWidth, p.distance, haasWidth, *table));
+        }
+    }
+    if (!PresetBank::write(outputPath.c_str(), names, rates, records)) {
+        fprintf(stderr, "%s: write failed\n", outputPath.c_str());
+        return 1;
+    }
+    printf("presets=%zu rates=%zu record_bytes=%zu file=%s\n", names.size(), rates.size(), sizeof(ChainCoeffs),
+           outputPath.c_str());
+    return 0;
+}
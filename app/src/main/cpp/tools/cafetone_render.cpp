@@ -0,0 +1,442 @@
+// cafetone-render: offline renderer for the Sony Café Mode DSP chain.
+//
+// Pushes a WAV file through the effect exactly the way the audio framework
+// does: the library descriptor's create_effect, EFFECT_CMD_* commands over
+// the effect interface, then process() in host-sized buffers.
+
+#include "audio_effect.h"
+#include "dsp_stats.h"
+#include "format_converter.h"
+#include "preset_bank.h"
+#include "hrir_database.h"
+#include "quality_governor.h"
+#include "wav_file.h"
+
+#define LOG_TAG "cafetone-render"
+#include "dsp_log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" audio_effect_library_t AUDIO_EFFECT_LIBRARY_INFO_SYM;
+
+namespace {
+
+// Must match the PARAM_* enums in cafetone_dsp.cpp / CafeModeDSP.kt.
+enum { PARAM_INTENSITY, PARAM_SPATIAL_WIDTH, PARAM_DISTANCE, PARAM_BLOCK_SIZE, PARAM_PRESET = 6, PARAM_STAGE_MASK,
+       PARAM_QUALITY_TIER, PARAM_QUALITY_AUTO, PARAM_EQ_MODE, PARAM_EQ_PARTITION, PARAM_HRTF_MODE = 14,
+       PARAM_HRTF_AZIMUTH, PARAM_HRTF_ELEVATION };
+enum { PARAM_STAGE_STATS_BASE = 0x100, PARAM_CALLBACK_STATS = 0x180, PARAM_QUALITY_STATUS = 0x182 };
+
+struct Options {
+    std::string inputPath;
+    std::string outputPath;
+    float intensity = 0.7f;
+    float spatialWidth = 0.6f;
+    float distance = 0.8f;
+    int bufferFrames = 960;     // 20 ms at 48 kHz, a typical mixer period
+    int repeat = 1;
+    int internalBlock = 0;      // 0 = effect default
+    std::string presetBankPath; // empty = PresetBank::DEFAULT_PATH
+    std::string presetName;     // name or index; overrides -i/-w/-d
+    int preset = -1;
+    int stageMask = -1;         // -1 = effect default (all stages)
+    int qualityTier = -1;       // -1 = effect default (full, governed by load)
+    int eqMode = -1;            // -1 = effect default (cascade)
+    int eqPartition = 0;        // 0 = effect default
+    bool hrtf = false;
+    float hrtfAzimuth = 0.0f;
+    float hrtfElevation = -20.0f;
+    std::string hrirPath;       // empty = HrirDatabase::DEFAULT_PATH
+    int format = AUDIO_FORMAT_PCM_16_BIT;   // I/O format negotiated via SET_CONFIG
+    int outputFormat = -1;                  // -1 = same as format
+    bool inPlace = false;                   // process() with one buffer for input and output
+    bool bypass = false;
+    bool verbose = false;
+    bool stats = false;
+};
+
+void usage(const char* argv0) {
+    fprintf(stderr,
+            "usage: %s [options] <input.wav> <output.wav>\n"
+            "  -i, --intensity <0..1>   master dry/wet intensity (default 0.7)\n"
+            "  -w, --width <0..1>       spatial width (default 0.6)\n"
+            "  -d, --distance <0..1>    distance simulation (default 0.8)\n"
+            "  -b, --buffer <frames>    host buffer size per process() call (default 960)\n"
+            "  -B, --internal-block <n> effect's internal sub-block size in frames\n"
+            "  -r, --repeat <n>         render n times and report the fastest pass\n"
+            "  -f, --format <fmt>       effect I/O format: s16, s24 (packed), s32, f32 (default s16)\n"
+            "  -o, --output-format <fmt> effect output format if it differs from the input's\n"
+            "      --in-place           hand process() the same buffer for input and output\n"
+            "  -s, --stages <mask>      stage mask: bit 0 EQ, 1 Haas, 2 binaural, 3 reverb, 4 dynamics\n"
+            "  -q, --quality <tier>     pin a quality tier: 0 full, 1 reduced, 2 minimal\n"
+            "  -e, --eq-mode <mode>     EQ engine: 0 cascade, 1 linear-phase FIR, 2 minimum-phase FIR\n"
+            "      --eq-partition <n>   FIR partition size in frames, 32..512\n"
+            "      --hrtf               render the binaural stage by HRTF convolution\n"
+            "      --azimuth <deg>      HRTF direction, positive to the right (default 0)\n"
+            "      --elevation <deg>    HRTF direction, positive up (default -20)\n"
+            "      --hrirs <file>       HRIR set from cafetone-hrir (default %s)\n"
+            "  -p, --preset <name|n>    select a preset from the bank instead of -i/-w/-d\n"
+            "      --presets <file>     preset bank from cafetone-presets (default %s)\n"
+            "      --bypass             leave the effect disabled (passthrough)\n"
+            "      --stats              print the effect's per-stage budget counters\n"
+            "  -v, --verbose            show the effect's own log output\n",
+            argv0, HrirDatabase::DEFAULT_PATH, PresetBank::DEFAULT_PATH);
+}
+
+struct FormatName {
+    const char* name;
+    int format;
+    wav::Encoding encoding;
+};
+
+const FormatName kFormats[] = {
+    { "s16", AUDIO_FORMAT_PCM_16_BIT, wav::Encoding::PCM16 },
+    { "s24", AUDIO_FORMAT_PCM_24_BIT_PACKED, wav::Encoding::PCM24 },
+    { "s32", AUDIO_FORMAT_PCM_32_BIT, wav::Encoding::PCM32 },
+    { "f32", AUDIO_FORMAT_PCM_FLOAT, wav::Encoding::Float32 },
+};
+
+const FormatName* findFormat(const std::string& name) {
+    for (const auto& f : kFormats) {
+        if (name == f.name) return &f;
+    }
+    return nullptr;
+}
+
+const FormatName* findFormat(int format) {
+    for (const auto& f : kFormats) {
+        if (format == f.format) return &f;
+    }
+    return nullptr;
+}
+
+bool parseArgs(int argc, char** argv, Options& opts) {
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto next = [&](float& out) {
+            if (i + 1 >= argc) return false;
+            out = strtof(argv[++i], nullptr);
+            return true;
+        };
+        auto nextInt = [&](int& out) {
+            if (i + 1 >= argc) return false;
+            out = atoi(argv[++i]);
+            return true;
+        };
+        if (arg == "-i" || arg == "--intensity") { if (!next(opts.intensity)) return false; }
+        else if (arg == "-w" || arg == "--width") { if (!next(opts.spatialWidth)) return false; }
+        else if (arg == "-d" || arg == "--distance") { if (!next(opts.distance)) return false; }
+        else if (arg == "-b" || arg == "--buffer") { if (!nextInt(opts.bufferFrames)) return false; }
+        else if (arg == "-B" || arg == "--internal-block") { if (!nextInt(opts.internalBlock)) return false; }
+        else if (arg == "-r" || arg == "--repeat") { if (!nextInt(opts.repeat)) return false; }
+        else if (arg == "-s" || arg == "--stages") {
+            if (i + 1 >= argc) return false;
+            opts.stageMask = (int)strtol(argv[++i], nullptr, 0);
+        }
+        else if (arg == "-q" || arg == "--quality") { if (!nextInt(opts.qualityTier)) return false; }
+        else if (arg == "-e" || arg == "--eq-mode") { if (!nextInt(opts.eqMode)) return false; }
+        else if (arg == "--eq-partition") { if (!nextInt(opts.eqPartition)) return false; }
+        else if (arg == "--hrtf") { opts.hrtf = true; }
+        else if (arg == "--azimuth") { if (!next(opts.hrtfAzimuth)) return false; }
+        else if (arg == "--elevation") { if (!next(opts.hrtfElevation)) return false; }
+        else if (arg == "--hrirs") {
+            if (i + 1 >= argc) return false;
+            opts.hrirPath = argv[++i];
+        }
+        else if (arg == "-f" || arg == "--format") {
+            const FormatName* f = i + 1 < argc ? findFormat(argv[++i]) : nullptr;
+            if (!f) return false;
+            opts.format = f->format;
+        }
+        else if (arg == "-o" || arg == "--output-format") {
+            const FormatName* f = i + 1 < argc ? findFormat(argv[++i]) : nullptr;
+            if (!f) return false;
+            opts.outputFormat = f->format;
+        }
+        else if (arg == "--in-place") { opts.inPlace = true; }
+        else if (arg == "-p" || arg == "--preset") {
+            if (i + 1 >= argc) return false;
+            opts.presetName = argv[++i];
+        }
+        else if (arg == "--presets") {
+            if (i + 1 >= argc) return false;
+            opts.presetBankPath = argv[++i];
+        }
+        else if (arg == "--bypass") { opts.bypass = true; }
+        else if (arg == "--stats") { opts.stats = true; }
+        else if (arg == "-v" || arg == "--verbose") { opts.verbose = true; }
+        else if (arg == "-h" || arg == "--help") { return false; }
+        else if (!arg.empty() && arg[0] == '-') { fprintf(stderr, "unknown option: %s\n", arg.c_str()); return false; }
+        else positional.push_back(arg);
+    }
+    if (positional.size() != 2 || opts.bufferFrames <= 0 || opts.repeat <= 0) return false;
+    if (opts.outputFormat < 0) opts.outputFormat = opts.format;
+    opts.inputPath = positional[0];
+    opts.outputPath = positional[1];
+    return true;
+}
+
+int32_t sendCommand(effect_interface_t** itfe, uint32_t cmd, uint32_t size = 0, void* data = nullptr) {
+    int32_t reply = 0;
+    uint32_t replySize = sizeof(reply);
+    int32_t status = (*itfe)->command(itfe, cmd, size, data, &replySize, &reply);
+    return status != 0 ? status : reply;
+}
+
+int32_t setParam(effect_interface_t** itfe, int32_t paramId, float value) {
+    uint8_t cmd[sizeof(int32_t) + sizeof(float)];
+    memcpy(cmd, &paramId, sizeof(paramId));
+    memcpy(cmd + sizeof(paramId), &value, sizeof(value));
+    return sendCommand(itfe, EFFECT_CMD_SET_PARAM, sizeof(cmd), cmd);
+}
+
+// WAV channel order (WAVE_FORMAT_EXTENSIBLE default masks) matches the
+// ascending audio_channel_mask_t bit order the effect expects.
+uint32_t channelMaskFor(int channels) {
+    switch (channels) {
+        case 1:
+        case 2: return AUDIO_CHANNEL_OUT_STEREO;    // mono is duplicated to stereo
+        case 6: return AUDIO_CHANNEL_OUT_5POINT1;
+        case 8: return AUDIO_CHANNEL_OUT_7POINT1;
+        default: return 0;
+    }
+}
+
+int32_t setConfig(effect_interface_t** itfe, int sampleRate, int inputFormat, int outputFormat,
+                  uint32_t inputChannelMask) {
+    effect_config_t config{};
+    for (buffer_config_t* cfg : { &config.inputCfg, &config.outputCfg }) {
+        cfg->samplingRate = (uint32_t)sampleRate;
+        cfg->channels = AUDIO_CHANNEL_OUT_STEREO;
+        cfg->mask = EFFECT_CONFIG_ALL;
+    }
+    config.inputCfg.format = (uint8_t)inputFormat;
+    config.outputCfg.format = (uint8_t)outputFormat;
+    config.inputCfg.channels = inputChannelMask;
+    config.inputCfg.accessMode = EFFECT_BUFFER_ACCESS_READ;
+    config.outputCfg.accessMode = EFFECT_BUFFER_ACCESS_WRITE;
+    return sendCommand(itfe, EFFECT_CMD_SET_CONFIG, sizeof(config), &config);
+}
+
+template <typename Report>
+bool getReport(effect_interface_t** itfe, int32_t paramId, Report& report) {
+    uint8_t reply[sizeof(int32_t) + sizeof(Report)] = {};
+    uint32_t replySize = sizeof(reply);
+    int32_t status = (*itfe)->command(itfe, EFFECT_CMD_GET_PARAM, sizeof(paramId), &paramId, &replySize, reply);
+    int32_t paramStatus;
+    memcpy(&paramStatus, reply, sizeof(paramStatus));
+    if (status != 0 || paramStatus != 0) return false;
+    memcpy(&report, reply + sizeof(int32_t), sizeof(report));
+    return true;
+}
+
+// Same counters the app reads through EFFECT_CMD_GET_PARAM / JNI.
+void printStats(effect_interface_t** itfe) {
+    printf("%-15s %10s %10s %10s %10s %10s\n", "stage", "calls", "min_ns", "mean_ns", "p99_ns", "max_ns");
+    for (int stage = 0; stage < NUM_DSP_STAGES; stage++) {
+        DspStageReport r{};
+        if (!getReport(itfe, PARAM_STAGE_STATS_BASE + stage, r)) continue;
+        printf("%-15s %10.0f %10.2f %10.2f %10.2f %10.2f\n", dspStageName(stage), r.calls,
+               r.minNsPerFrame, r.meanNsPerFrame, r.p99NsPerFrame, r.maxNsPerFrame);
+    }
+    DspCallbackReport cb{};
+    if (getReport(itfe, PARAM_CALLBACK_STATS, cb)) {
+        printf("callbacks=%.0f mean_interval_us=%.1f mean_jitter_us=%.1f max_jitter_us=%.1f "
+               "overruns=%.0f max_load=%.3f idle_ratio=%.3f\n",
+               cb.callbacks, cb.meanIntervalUs, cb.meanJitterUs, cb.maxJitterUs, cb.overruns, cb.maxLoad,
+               cb.idleRatio);
+    }
+    QualityReport q{};
+    if (getReport(itfe, PARAM_QUALITY_STATUS, q)) {
+        printf("quality_tier=%.0f requested=%.0f auto=%.0f step_downs=%.0f step_ups=%.0f load=%.3f\n",
+               q.activeTier, q.requestedTier, q.automatic, q.stepDowns, q.stepUps, q.smoothedLoad);
+    }
+}
+
+// Renders the whole file once and returns the time spent inside process().
+double renderPass(const Options& opts, int sampleRate, int inputChannels, const std::vector<uint8_t>& input,
+                  std::vector<uint8_t>& output, bool& ok) {
+    static const effect_uuid_t kUuid =
+            { 0x87654321, 0x4321, 0x8765, 0x4321, { 0xfe, 0xdc, 0xba, 0x09, 0x87, 0x65 } };
+
+    ok = false;
+    effect_interface_t* handle = nullptr;
+    if (AUDIO_EFFECT_LIBRARY_INFO_SYM.create_effect(&kUuid, 0, 0, &handle) != 0 || !handle) {
+        fprintf(stderr, "create_effect failed\n");
+        return 0.0;
+    }
+    effect_interface_t** itfe = &handle;
+
+    if (setConfig(itfe, sampleRate, opts.format, opts.outputFormat, channelMaskFor(inputChannels)) != 0) {
+        fprintf(stderr, "EFFECT_CMD_SET_CONFIG rejected %d Hz, %d channels\n", sampleRate, inputChannels);
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(itfe);
+        return 0.0;
+    }
+    if (setParam(itfe, PARAM_INTENSITY, opts.intensity) != 0 ||
+        setParam(itfe, PARAM_SPATIAL_WIDTH, opts.spatialWidth) != 0 ||
+        setParam(itfe, PARAM_DISTANCE, opts.distance) != 0 ||
+        (opts.internalBlock > 0 && setParam(itfe, PARAM_BLOCK_SIZE, (float)opts.internalBlock) != 0) ||
+        (opts.preset >= 0 && setParam(itfe, PARAM_PRESET, (float)opts.preset) != 0) ||
+        (opts.stageMask >= 0 && setParam(itfe, PARAM_STAGE_MASK, (float)opts.stageMask) != 0) ||
+        (opts.qualityTier >= 0 && (setParam(itfe, PARAM_QUALITY_TIER, (float)opts.qualityTier) != 0 ||
+                                   setParam(itfe, PARAM_QUALITY_AUTO, 0.0f) != 0)) ||
+        (opts.eqPartition > 0 && setParam(itfe, PARAM_EQ_PARTITION, (float)opts.eqPartition) != 0) ||
+        (opts.eqMode >= 0 && setParam(itfe, PARAM_EQ_MODE, (float)opts.eqMode) != 0) ||
+        (opts.hrtf && (setParam(itfe, PARAM_HRTF_AZIMUTH, opts.hrtfAzimuth) != 0 ||
+                       setParam(itfe, PARAM_HRTF_ELEVATION, opts.hrtfElevation) != 0 ||
+                       setParam(itfe, PARAM_HRTF_MODE, 1.0f) != 0))) {
+        fprintf(stderr, "EFFECT_CMD_SET_PARAM failed\n");
+        AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(itfe);
+        return 0.0;
+    }
+    if (!opts.bypass) sendCommand(itfe, EFFECT_CMD_ENABLE);
+
+    const size_t inFrameBytes = (size_t)pcmBytesPerSample(opts.format) * inputChannels;
+    const size_t outFrameBytes = (size_t)pcmBytesPerSample(opts.outputFormat) * 2;
+    size_t totalFrames = input.size() / inFrameBytes;
+    output.assign(totalFrames * outFrameBytes, 0);
+    // In place, the host's buffer is sized for the wider of the two frames
+    std::vector<uint8_t> shared(opts.inPlace ? (size_t)opts.bufferFrames * std::max(inFrameBytes, outFrameBytes) : 0);
+    double seconds = 0.0;
+
+    for (size_t pos = 0; pos < totalFrames; pos += opts.bufferFrames) {
+        size_t frames = std::min(totalFrames - pos, (size_t)opts.bufferFrames);
+        audio_buffer_t in{}, out{};
+        in.frameCount = frames;
+        in.raw = const_cast<uint8_t*>(input.data()) + pos * inFrameBytes;
+        out.frameCount = frames;
+        out.raw = output.data() + pos * outFrameBytes;
+        if (opts.inPlace) {
+            memcpy(shared.data(), in.raw, frames * inFrameBytes);
+            in.raw = out.raw = shared.data();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        int32_t status = (*itfe)->process(itfe, &in, &out);
+        seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (status != 0) {
+            fprintf(stderr, "process() failed with %d at frame %zu\n", status, pos);
+            AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(itfe);
+            return seconds;
+        }
+        if (opts.inPlace) memcpy(output.data() + pos * outFrameBytes, shared.data(), frames * outFrameBytes);
+    }
+
+    if (opts.stats) printStats(itfe);
+    AUDIO_EFFECT_LIBRARY_INFO_SYM.release_effect(itfe);
+    ok = true;
+    return seconds;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parseArgs(argc, argv, opts)) {
+        usage(argv[0]);
+        return 2;
+    }
+    gCafeToneHostLogLevel = opts.verbose ? 0 : 2;
+
+    // Held for the whole run so every pass's instance shares one mapping.
+    std::shared_ptr<const PresetBank> bank;
+    if (!opts.presetName.empty()) {
+        if (!opts.presetBankPath.empty()) PresetBank::setDefaultPath(opts.presetBankPath);
+        bank = PresetBank::shared();
+        if (!bank) {
+            fprintf(stderr, "%s: not a preset bank\n",
+                    opts.presetBankPath.empty() ? PresetBank::DEFAULT_PATH : opts.presetBankPath.c_str());
+            return 1;
+        }
+        char* end = nullptr;
+        long index = strtol(opts.presetName.c_str(), &end, 10);
+        opts.preset = *end == '\0' ? (int)index : bank->find(opts.presetName.c_str());
+        if (opts.preset < 0 || opts.preset >= bank->presetCount()) {
+            fprintf(stderr, "unknown preset: %s\n", opts.presetName.c_str());
+            return 1;
+        }
+    }
+
+    std::shared_ptr<const HrirDatabase> hrirs;
+    if (opts.hrtf) {
+        if (!opts.hrirPath.empty()) HrirDatabase::setDefaultPath(opts.hrirPath);
+        hrirs = HrirDatabase::shared();
+        if (!hrirs) {
+            fprintf(stderr, "%s: not an HRIR set\n",
+                    opts.hrirPath.empty() ? HrirDatabase::DEFAULT_PATH : opts.hrirPath.c_str());
+            return 1;
+        }
+    }
+
+    wav::File file;
+    std::string error;
+    if (!wav::read(opts.inputPath, file, error)) {
+        fprintf(stderr, "%s: %s\n", opts.inputPath.c_str(), error.c_str());
+        return 1;
+    }
+    if (channelMaskFor(file.channels) == 0) {
+        fprintf(stderr, "%s: %d channels not supported (mono, stereo, 5.1 or 7.1 only)\n",
+                opts.inputPath.c_str(), file.channels);
+        return 1;
+    }
+
+    // The effect consumes interleaved PCM in the configured format, like the
+    // mixer's output; the file's rate and layout are negotiated with
+    // SET_CONFIG. Mono is duplicated to stereo first.
+    size_t frames = file.frames();
+    const int inputChannels = file.channels == 1 ? 2 : file.channels;
+    std::vector<float> interleaved;
+    if (file.channels == 1) {
+        interleaved.resize(frames * 2);
+        for (size_t i = 0; i < frames; i++) interleaved[i * 2] = interleaved[i * 2 + 1] = file.samples[i];
+    } else {
+        interleaved = file.samples;
+    }
+    // Every supported layout has an even channel count, so the interleaved
+    // stream can be encoded as (frames * channels / 2) stereo pairs.
+    const size_t pairs = frames * inputChannels / 2;
+    std::vector<float> left(std::max(pairs, frames)), right(std::max(pairs, frames));
+    for (size_t i = 0; i < pairs; i++) {
+        left[i] = interleaved[i * 2];
+        right[i] = interleaved[i * 2 + 1];
+    }
+    std::vector<uint8_t> input(frames * inputChannels * pcmBytesPerSample(opts.format));
+    interleaveStereo(left.data(), right.data(), input.data(), opts.format, (int)pairs, false);
+
+    std::vector<uint8_t> output;
+    double best = 0.0;
+    for (int pass = 0; pass < opts.repeat; pass++) {
+        bool ok;
+        double seconds = renderPass(opts, file.sampleRate, inputChannels, input, output, ok);
+        if (!ok) return 1;
+        if (pass == 0 || seconds < best) best = seconds;
+    }
+
+    wav::File result;
+    result.sampleRate = file.sampleRate;
+    result.channels = 2;
+    result.encoding = findFormat(opts.outputFormat)->encoding;
+    deinterleaveStereo(output.data(), opts.outputFormat, left.data(), right.data(), (int)frames);
+    result.samples.resize(frames * 2);
+    for (size_t i = 0; i < frames; i++) {
+        result.samples[i * 2] = left[i];
+        result.samples[i * 2 + 1] = right[i];
+    }
+    if (!wav::write(opts.outputPath, result, error)) {
+        fprintf(stderr, "%s: %s\n", opts.outputPath.c_str(), error.c_str());
+        return 1;
+    }
+
+    double audioSeconds = (double)frames / file.sampleRate;
+    printf("frames=%zu sample_rate=%d buffer=%d process_s=%.6f ns_per_frame=%.2f realtime_x=%.1f\n",
+           frames, file.sampleRate, opts.bufferFrames, best,
+           frames > 0 ? best * 1e9 / frames : 0.0,
+           best > 0.0 ? audioSeconds / best : 0.0);
+    return 0;
+}
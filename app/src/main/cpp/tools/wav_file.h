@@ -0,0 +1,152 @@
+#ifndef CAFETONE_TOOLS_WAV_FILE_H
+#define CAFETONE_TOOLS_WAV_FILE_H
+
+// Minimal RIFF/WAVE reader and writer for the host tools. Samples are kept
+// as interleaved float in [-1, 1) regardless of the on-disk encoding.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace wav {
+
+enum class Encoding { PCM16, PCM24, PCM32, Float32 };
+
+struct File {
+    int sampleRate = 48000;
+    int channels = 2;
+    Encoding encoding = Encoding::PCM16;
+    std::vector<float> samples;   // interleaved
+
+    size_t frames() const { return channels > 0 ? samples.size() / channels : 0; }
+};
+
+inline uint32_t readLE(const uint8_t* p, int bytes) {
+    uint32_t v = 0;
+    for (int i = 0; i < bytes; i++) v |= (uint32_t)p[i] << (8 * i);
+    return v;
+}
+
+inline void writeLE(std::vector<uint8_t>& out, uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+inline int bytesPerSample(Encoding e) {
+    switch (e) {
+        case Encoding::PCM16: return 2;
+        case Encoding::PCM24: return 3;
+        default: return 4;
+    }
+}
+
+inline bool read(const std::string& path, File& file, std::string& error) {
+    FILE* fp = fopen(path.c_str(), "rb");
+    if (!fp) { error = "cannot open " + path; return false; }
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), fp)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(fp);
+
+    if (data.size() < 12 || memcmp(data.data(), "RIFF", 4) != 0 || memcmp(data.data() + 8, "WAVE", 4) != 0) {
+        error = "not a RIFF/WAVE file";
+        return false;
+    }
+
+    int format = 0, bits = 0;
+    bool haveFmt = false;
+    size_t pos = 12;
+    while (pos + 8 <= data.size()) {
+        const uint8_t* hdr = data.data() + pos;
+        uint32_t size = readLE(hdr + 4, 4);
+        const uint8_t* body = hdr + 8;
+        size_t avail = std::min<size_t>(size, data.size() - pos - 8);
+
+        if (memcmp(hdr, "fmt ", 4) == 0 && avail >= 16) {
+            format = (int)readLE(body, 2);
+            file.channels = (int)readLE(body + 2, 2);
+            file.sampleRate = (int)readLE(body + 4, 4);
+            bits = (int)readLE(body + 14, 2);
+            if (format == 0xFFFE && avail >= 26) format = (int)readLE(body + 24, 2); // WAVE_FORMAT_EXTENSIBLE
+            haveFmt = true;
+        } else if (memcmp(hdr, "data", 4) == 0) {
+            if (!haveFmt) { error = "data chunk before fmt chunk"; return false; }
+            if (format == 1 && bits == 16) file.encoding = Encoding::PCM16;
+            else if (format == 1 && bits == 24) file.encoding = Encoding::PCM24;
+            else if (format == 1 && bits == 32) file.encoding = Encoding::PCM32;
+            else if (format == 3 && bits == 32) file.encoding = Encoding::Float32;
+            else { error = "unsupported sample format"; return false; }
+            if (file.channels <= 0) { error = "invalid channel count"; return false; }
+
+            int bps = bytesPerSample(file.encoding);
+            size_t count = avail / bps;
+            file.samples.resize(count);
+            for (size_t i = 0; i < count; i++) {
+                const uint8_t* s = body + i * bps;
+                switch (file.encoding) {
+                    case Encoding::PCM16: file.samples[i] = (int16_t)readLE(s, 2) / 32768.0f; break;
+                    case Encoding::PCM24: file.samples[i] = ((int32_t)(readLE(s, 3) << 8) >> 8) / 8388608.0f; break;
+                    case Encoding::PCM32: file.samples[i] = (int32_t)readLE(s, 4) / 2147483648.0f; break;
+                    case Encoding::Float32: {
+                        uint32_t u = readLE(s, 4);
+                        memcpy(&file.samples[i], &u, 4);
+                        break;
+                    }
+                }
+            }
+            return true;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    error = "no data chunk";
+    return false;
+}
+
+inline bool write(const std::string& path, const File& file, std::string& error) {
+    int bps = bytesPerSample(file.encoding);
+    uint32_t dataBytes = (uint32_t)(file.samples.size() * bps);
+    std::vector<uint8_t> out;
+    out.reserve(44 + dataBytes);
+
+    out.insert(out.end(), {'R', 'I', 'F', 'F'});
+    writeLE(out, 36 + dataBytes, 4);
+    out.insert(out.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+    writeLE(out, 16, 4);
+    writeLE(out, file.encoding == Encoding::Float32 ? 3 : 1, 2);
+    writeLE(out, file.channels, 2);
+    writeLE(out, file.sampleRate, 4);
+    writeLE(out, file.sampleRate * file.channels * bps, 4);
+    writeLE(out, file.channels * bps, 2);
+    writeLE(out, bps * 8, 2);
+    out.insert(out.end(), {'d', 'a', 't', 'a'});
+    writeLE(out, dataBytes, 4);
+
+    for (float v : file.samples) {
+        float c = v < -1.0f ? -1.0f : (v > 1.0f ? 1.0f : v);
+        switch (file.encoding) {
+            case Encoding::PCM16: writeLE(out, (uint32_t)(int32_t)(c * 32767.0f), 2); break;
+            case Encoding::PCM24: writeLE(out, (uint32_t)(int32_t)(c * 8388607.0f), 3); break;
+            case Encoding::PCM32: writeLE(out, (uint32_t)(int32_t)((double)c * 2147483647.0), 4); break;
+            case Encoding::Float32: {
+                uint32_t u;
+                memcpy(&u, &v, 4);
+                writeLE(out, u, 4);
+                break;
+            }
+        }
+    }
+
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (!fp) { error = "cannot create " + path; return false; }
+    bool ok = fwrite(out.data(), 1, out.size(), fp) == out.size();
+    fclose(fp);
+    if (!ok) error = "short write to " + path;
+    return ok;
+}
+
+} // namespace wav
+
+#endif // CAFETONE_TOOLS_WAV_FILE_H
@@ -0,0 +1,53 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+// Wait-free single-producer / single-consumer handoff of a value type.
+//
+// Three slots rotate between the writer (back), the reader (front) and a
+// shared middle slot. publish() swaps the freshly written back slot into the
+// middle; fetch() swaps the middle into the front if something new has been
+// published since the last fetch. Neither side ever blocks or sees a slot
+// the other side is writing, and intermediate values the reader never
+// fetched are simply overwritten, so the reader always gets the latest
+// complete value.
+//
+// Used to hand parameter snapshots from the control thread to the audio
+// thread: the control side designs everything into writable() and
+// publishes, the audio callback fetches once at its start.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() : m_middle(1), m_back(2), m_front(0) {}
+
+    // Writer side. writable() holds stale data from an earlier round; assign
+    // the whole value before publishing.
+    T& writable() { return m_slots[m_back]; }
+
+    void publish() {
+        int previous = m_middle.exchange(m_back | FRESH, std::memory_order_acq_rel);
+        m_back = previous & INDEX_MASK;
+    }
+
+    // Reader side. Returns true if current() changed.
+    bool fetch() {
+        if (!(m_middle.load(std::memory_order_relaxed) & FRESH)) return false;
+        int previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX_MASK;
+        return true;
+    }
+
+    const T& current() const { return m_slots[m_front]; }
+
+private:
+    static const int INDEX_MASK = 3;
+    static const int FRESH = 4;
+
+    T m_slots[3]{};
+    std::atomic<int> m_middle;   // slot index | FRESH once published
+    int m_back;                  // owned by the writer
+    int m_front;                 // owned by the reader
+};
+
+#endif // TRIPLE_BUFFER_H
@@ -32,10 +32,89 @@ class CafeModeDSP {
         const val PARAM_INTENSITY = 0      // Master intensity (0.0-1.0)
         const val PARAM_SPATIAL_WIDTH = 1  // Spatial width - up to 170% expansion
         const val PARAM_DISTANCE = 2       // Distance simulation (0.0-1.0)
+        const val PARAM_PRESET = 6         // Preset index in the loaded bank, -1 for none
+        const val PARAM_STAGE_MASK = 7     // Enabled processing stages (STAGE_* bits)
+        const val PARAM_QUALITY_TIER = 8   // Best quality tier allowed (QUALITY_*)
+        const val PARAM_QUALITY_AUTO = 9   // 1 lets the engine step down under CPU load
+        const val PARAM_EQ_MODE = 10       // EQ engine (EQ_MODE_*)
+        const val PARAM_EQ_PARTITION = 11  // FIR partition size in frames: latency against CPU
+        const val PARAM_EQ_LATENCY = 12    // Read only: FIR EQ latency in frames
+        const val PARAM_HRTF_MODE = 14     // 1 renders the binaural stage through measured HRIRs
+        const val PARAM_HRTF_AZIMUTH = 15  // Degrees, positive to the right (-180..180)
+        const val PARAM_HRTF_ELEVATION = 16 // Degrees, positive up (-90..90)
+        const val PARAM_HRTF_GRID_BYTES = 17  // Read only: HRTF direction grid, shared across sessions
+        const val PARAM_HRTF_CACHE_BYTES = 18 // Read only: cached HRTF filter pairs
+
+        // Stage mask bits, in chain order (mirrors DspStage in dsp_stats.h)
+        const val STAGE_EQ = 1 shl 0
+        const val STAGE_HAAS = 1 shl 1
+        const val STAGE_BINAURAL = 1 shl 2
+        const val STAGE_REVERB = 1 shl 3
+        const val STAGE_DYNAMICS = 1 shl 4
+        const val STAGES_ALL = STAGE_EQ or STAGE_HAAS or STAGE_BINAURAL or STAGE_REVERB or STAGE_DYNAMICS
+        // Positioning and width without the reverb, the costliest stage
+        const val STAGES_SPATIAL_ONLY = STAGE_HAAS or STAGE_BINAURAL
+
+        // Quality tiers, cheapest last (mirrors QualityTier in quality_governor.h)
+        const val QUALITY_FULL = 0
+        const val QUALITY_REDUCED = 1      // Half the early reflections
+        const val QUALITY_MINIMAL = 2      // No reverb
+
+        // EQ engines (mirrors EQProcessor::Mode in eq_processor.h)
+        const val EQ_MODE_CASCADE = 0          // Biquads, no latency
+        const val EQ_MODE_LINEAR_PHASE = 1     // FIR, constant group delay
+        const val EQ_MODE_MINIMUM_PHASE = 2    // FIR, latency of one partition
+        const val EQ_PARTITION_MIN = 32
+        const val EQ_PARTITION_MAX = 512
         
         // Sony Café Mode Effect UUID (matches native implementation)
         const val EFFECT_UUID = "87654321-4321-8765-4321-fedcba098765"
+
+        // Realtime budget instrumentation (mirrors DspStage in dsp_stats.h)
+        val STAGE_NAMES = listOf(
+            "input_convert", "eq", "haas", "binaural", "reverb", "dynamics", "output_convert", "total"
+        )
+        private const val STAGE_REPORT_FLOATS = 5
+        private const val CALLBACK_REPORT_FLOATS = 7
+        private const val QUALITY_REPORT_FLOATS = 6
     }
+
+    /**
+     * Per-stage cost of the native process callback, in nanoseconds per frame
+     */
+    data class StageStats(
+        val stage: String,
+        val calls: Long,
+        val minNsPerFrame: Float,
+        val meanNsPerFrame: Float,
+        val p99NsPerFrame: Float,
+        val maxNsPerFrame: Float
+    )
+
+    /**
+     * Callback timing against the buffer period (the realtime budget)
+     */
+    data class CallbackStats(
+        val callbacks: Long,
+        val meanIntervalUs: Float,
+        val meanJitterUs: Float,
+        val maxJitterUs: Float,
+        val overruns: Long,
+        val maxLoad: Float,
+        val idleRatio: Float
+    )
+
+    /**
+     * Quality tier the engine is running and how often the load governor switched it
+     */
+    data class QualityStatus(
+        val activeTier: Int,
+        val requestedTier: Int,
+        val automatic: Boolean,
+        val stepDowns: Long,
+        val stepUps: Long,
+        val load: Float
+    )
     
     private var isInitialized = false
     private var effectHandle: Long = 0
@@ -145,6 +224,203 @@ class CafeModeDSP {
         }
     }
     
+    /**
+     * Choose which processing stages run; cleared stages fade out and stop costing CPU
+     * @param mask STAGE_* bits, e.g. STAGES_SPATIAL_ONLY for low-end devices
+     */
+    fun setStageMask(mask: Int) {
+        if (isInitialized) {
+            try {
+                nativeSetStageMask(mask and STAGES_ALL)
+                Log.v(TAG, "Sony Café Mode stage mask set to: $mask")
+            } catch (e: UnsatisfiedLinkError) {
+                Log.w(TAG, "Stage mask not available: ${e.message}")
+            }
+        }
+    }
+
+    /**
+     * Get the enabled processing stages (STAGE_* bits)
+     */
+    fun getStageMask(): Int {
+        return if (isInitialized) {
+            nativeGetParameter(PARAM_STAGE_MASK).toInt()
+        } else STAGES_ALL
+    }
+
+    /**
+     * Set the best quality tier the engine may run
+     * @param tier QUALITY_FULL, QUALITY_REDUCED or QUALITY_MINIMAL
+     */
+    fun setQualityTier(tier: Int) {
+        if (isInitialized) {
+            nativeSetParameter(PARAM_QUALITY_TIER, tier.coerceIn(QUALITY_FULL, QUALITY_MINIMAL).toFloat())
+            Log.v(TAG, "Sony Café Mode quality tier set to: $tier")
+        }
+    }
+
+    /**
+     * Let the engine step below the requested tier when callbacks near their deadline
+     */
+    fun setAutoQuality(enabled: Boolean) {
+        if (isInitialized) {
+            nativeSetParameter(PARAM_QUALITY_AUTO, if (enabled) 1.0f else 0.0f)
+            Log.v(TAG, "Sony Café Mode automatic quality ${if (enabled) "on" else "off"}")
+        }
+    }
+
+    /**
+     * Get the active quality tier and the governor's switch counts
+     */
+    fun getQualityStatus(): QualityStatus? {
+        if (!isInitialized) return null
+        val values = try {
+            nativeGetQualityStatus()?.takeIf { it.size >= QUALITY_REPORT_FLOATS }
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Quality status not available: ${e.message}")
+            null
+        } ?: return null
+        return QualityStatus(
+            activeTier = values[0].toInt(),
+            requestedTier = values[1].toInt(),
+            automatic = values[2] != 0.0f,
+            stepDowns = values[3].toLong(),
+            stepUps = values[4].toLong(),
+            load = values[5]
+        )
+    }
+
+    /**
+     * Select the EQ engine; the FIR modes also apply the headphone curve
+     * @param mode EQ_MODE_CASCADE, EQ_MODE_LINEAR_PHASE or EQ_MODE_MINIMUM_PHASE
+     */
+    fun setEqMode(mode: Int) {
+        if (isInitialized) {
+            nativeSetParameter(PARAM_EQ_MODE, mode.coerceIn(EQ_MODE_CASCADE, EQ_MODE_MINIMUM_PHASE).toFloat())
+            Log.v(TAG, "Sony Café Mode EQ mode set to: $mode")
+        }
+    }
+
+    /**
+     * Set the FIR partition size: smaller lowers latency, larger lowers CPU
+     * @param frames power of two between EQ_PARTITION_MIN and EQ_PARTITION_MAX
+     */
+    fun setEqPartition(frames: Int) {
+        if (isInitialized) {
+            nativeSetParameter(PARAM_EQ_PARTITION, frames.coerceIn(EQ_PARTITION_MIN, EQ_PARTITION_MAX).toFloat())
+            Log.v(TAG, "Sony Café Mode EQ partition set to: $frames")
+        }
+    }
+
+    /**
+     * Get the latency the FIR EQ adds, in frames (0 for the cascade)
+     */
+    fun getEqLatency(): Int {
+        return if (isInitialized) {
+            nativeGetParameter(PARAM_EQ_LATENCY).toInt()
+        } else 0
+    }
+
+    /**
+     * Set the headphone correction curve the FIR modes equalise towards
+     * @param frequencies point frequencies in Hz
+     * @param gainsDb gain at each point in dB; empty arrays clear the curve
+     * @return true if the curve was accepted
+     */
+    fun setHeadphoneCurve(frequencies: FloatArray, gainsDb: FloatArray): Boolean {
+        if (!isInitialized || frequencies.size != gainsDb.size) return false
+        return try {
+            nativeSetHeadphoneCurve(frequencies, gainsDb) == 0
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Headphone curve not available: ${e.message}")
+            false
+        }
+    }
+
+    /**
+     * Map a binary preset bank (generated by cafetone-presets)
+     * @return number of presets, or -1 if the file could not be loaded
+     */
+    fun loadPresets(path: String): Int {
+        if (!isInitialized) return -1
+        return try {
+            nativeLoadPresets(path)
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Presets not available: ${e.message}")
+            -1
+        }
+    }
+
+    /**
+     * Map a binary HRIR set (generated by cafetone-hrir) for HRTF rendering,
+     * replacing the system one
+     * @return number of measured directions, or -1 if the file could not be loaded
+     */
+    fun loadHrirs(path: String): Int {
+        if (!isInitialized) return -1
+        return try {
+            nativeLoadHrirs(path)
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "HRIR sets not available: ${e.message}")
+            -1
+        }
+    }
+
+    /**
+     * Render the binaural stage by HRTF convolution instead of its gain approximation
+     * @return true if HRTF rendering is on; enabling fails without an HRIR set
+     */
+    fun setHrtfEnabled(enabled: Boolean): Boolean {
+        if (!isInitialized) return false
+        nativeSetParameter(PARAM_HRTF_MODE, if (enabled) 1.0f else 0.0f)
+        Log.v(TAG, "Sony Café Mode HRTF rendering ${if (enabled) "enabled" else "disabled"}")
+        return nativeGetParameter(PARAM_HRTF_MODE) != 0.0f
+    }
+
+    /**
+     * Set the direction HRTF rendering places the music at
+     * @param azimuth degrees, positive to the right (-180..180)
+     * @param elevation degrees, positive up (-90..90)
+     */
+    fun setHrtfDirection(azimuth: Float, elevation: Float) {
+        if (isInitialized) {
+            nativeSetParameter(PARAM_HRTF_AZIMUTH, azimuth.coerceIn(-180.0f, 180.0f))
+            nativeSetParameter(PARAM_HRTF_ELEVATION, elevation.coerceIn(-90.0f, 90.0f))
+            Log.v(TAG, "Sony Café Mode HRTF direction set to: $azimuth / $elevation")
+        }
+    }
+
+    /**
+     * Get the memory behind HRTF directions, in bytes: the precomputed direction
+     * grid (shared by every session at the same rate) plus this session's cache of
+     * interpolated filter pairs. 0 while HRTF rendering is off.
+     */
+    fun getHrtfMemoryBytes(): Int {
+        return if (isInitialized) {
+            (nativeGetParameter(PARAM_HRTF_GRID_BYTES) + nativeGetParameter(PARAM_HRTF_CACHE_BYTES)).toInt()
+        } else 0
+    }
+
+    /**
+     * Switch intensity, width and distance to a preset in one step
+     * @param index preset index in the loaded bank
+     */
+    fun selectPreset(index: Int) {
+        if (isInitialized) {
+            nativeSetParameter(PARAM_PRESET, index.toFloat())
+            Log.v(TAG, "Sony Café Mode preset selected: $index")
+        }
+    }
+
+    /**
+     * Get the selected preset, -1 once a parameter has been changed by hand
+     */
+    fun getPreset(): Int {
+        return if (isInitialized) {
+            nativeGetParameter(PARAM_PRESET).toInt()
+        } else -1
+    }
+
     /**
      * Enable/disable Sony Café Mode processing
      * @param enabled true to enable, false to bypass
@@ -183,6 +459,66 @@ class CafeModeDSP {
         } else 0.0f
     }
     
+    /**
+     * Get per-stage realtime budget counters (EQ, Haas, Binaural, Reverb, Dynamics, conversion)
+     */
+    fun getStageStats(): List<StageStats> {
+        val values = readStats() ?: return emptyList()
+        return STAGE_NAMES.mapIndexed { index, name ->
+            val base = index * STAGE_REPORT_FLOATS
+            StageStats(
+                stage = name,
+                calls = values[base].toLong(),
+                minNsPerFrame = values[base + 1],
+                meanNsPerFrame = values[base + 2],
+                p99NsPerFrame = values[base + 3],
+                maxNsPerFrame = values[base + 4]
+            )
+        }
+    }
+
+    /**
+     * Get callback interval jitter and budget overrun counters
+     */
+    fun getCallbackStats(): CallbackStats? {
+        val values = readStats() ?: return null
+        val base = STAGE_NAMES.size * STAGE_REPORT_FLOATS
+        return CallbackStats(
+            callbacks = values[base].toLong(),
+            meanIntervalUs = values[base + 1],
+            meanJitterUs = values[base + 2],
+            maxJitterUs = values[base + 3],
+            overruns = values[base + 4].toLong(),
+            maxLoad = values[base + 5],
+            idleRatio = values[base + 6]
+        )
+    }
+
+    /**
+     * Clear the budget counters (applied at the next audio callback)
+     */
+    fun resetStageStats() {
+        if (isInitialized) {
+            try {
+                nativeResetStageStats()
+            } catch (e: UnsatisfiedLinkError) {
+                Log.w(TAG, "Stage stats not available: ${e.message}")
+            }
+        }
+    }
+
+    private fun readStats(): FloatArray? {
+        if (!isInitialized) return null
+        return try {
+            nativeGetStageStats()?.takeIf {
+                it.size >= STAGE_NAMES.size * STAGE_REPORT_FLOATS + CALLBACK_REPORT_FLOATS
+            }
+        } catch (e: UnsatisfiedLinkError) {
+            Log.w(TAG, "Stage stats not available: ${e.message}")
+            null
+        }
+    }
+
     /**
      * Get Sony Café Mode DSP status information
      */
@@ -204,4 +540,11 @@ class CafeModeDSP {
     private external fun nativeSetParameter(paramId: Int, value: Float)
     private external fun nativeGetParameter(paramId: Int): Float
     private external fun nativeSetEnabled(enabled: Boolean)
+    private external fun nativeLoadPresets(path: String): Int
+    private external fun nativeLoadHrirs(path: String): Int
+    private external fun nativeSetStageMask(mask: Int)
+    private external fun nativeGetStageStats(): FloatArray?
+    private external fun nativeResetStageStats()
+    private external fun nativeGetQualityStatus(): FloatArray?
+    private external fun nativeSetHeadphoneCurve(frequencies: FloatArray, gains: FloatArray): Int
 }
\ No newline at end of file